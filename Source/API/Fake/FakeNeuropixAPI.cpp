@@ -0,0 +1,1220 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+/**
+
+	Stand-in for the subset of the Neuropixels API used by this plugin.
+
+	Built in place of NeuropixAPI_x64_4_1_3.lib when NEUROPIX_FAKE_API is
+	enabled in CMake, so that the basestation, headstage and probe classes
+	(and the acquisition engines behind them) can run without hardware.
+
+	The simulated rig is configured through environment variables:
+
+	  NPX_FAKE_SLOTS       comma-separated PXI slots to report (default "2")
+	  NPX_FAKE_ONEBOX      comma-separated OneBox serial numbers (default none)
+	  NPX_FAKE_PROBES      probe part numbers per port, comma-separated;
+	                       use '+' for a second dock and leave a port empty
+	                       to report no headstage
+	                       (default "PRB_1_4_0480_1,NP2013,,")
+	  NPX_FAKE_RATE        packet rate multiplier (default 1.0)
+	  NPX_FAKE_FIFO_MS     depth of each packet FIFO in milliseconds (default 1000)
+	  NPX_FAKE_LATENCY_US  latency added to every read / FIFO status call (default 0)
+	  NPX_FAKE_JITTER_US   uniformly distributed extra latency (default 0)
+
+	Data starts flowing when setSWTrigger() is called after arm(). Packets
+	that are not read before the FIFO fills are dropped, which shows up as a
+	timestamp jump, exactly like a hardware overflow.
+
+*/
+
+#include <ctime> // NeuropixAPI.h uses time_t without including it
+
+#include "../NeuropixAPI.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <random>
+#include <sstream>
+#include <string>
+#include <thread>
+#include <tuple>
+#include <vector>
+
+using namespace Neuropixels;
+
+namespace
+{
+
+const int numPorts = 4;
+const int numDocks = 2;
+const int numAdcChannels = 24; // 12 ADCs + 12 comparators
+const int waveformLength = 1024;
+
+/** Sample rates of the simulated streams */
+const double apSampleRate = 30000.0;
+const double lfpSampleRate = 2500.0;
+const double adcSampleRate = 30000.0;
+
+/** The hardware timestamp clock runs at 100 kHz */
+const double timestampClockRate = 100000.0;
+
+enum class PacketFormat
+{
+    ELECTRODE_PACKET, // NP1-style 12-sample superframes
+    PACKET_INFO // NP2-style one sample per packet
+};
+
+struct FakeProbe
+{
+    std::string partNumber;
+    std::string headstagePartNumber;
+    PacketFormat format = PacketFormat::ELECTRODE_PACKET;
+    int numSources = 1;
+};
+
+/** Samples produced by one hardware FIFO since the trigger */
+struct FakeStream
+{
+    std::chrono::steady_clock::time_point start;
+    int64_t packetsConsumed = 0;
+    double packetsPerSecond = 0.0;
+    int capacity = 0;
+};
+
+typedef std::tuple<int, int, int, int> StreamKey; // slot, port, dock, source
+
+double getEnvDouble (const char* name, double defaultValue)
+{
+    const char* value = std::getenv (name);
+
+    if (value == nullptr || *value == 0)
+        return defaultValue;
+
+    return std::atof (value);
+}
+
+std::string getEnvString (const char* name, const char* defaultValue)
+{
+    const char* value = std::getenv (name);
+
+    return value != nullptr ? std::string (value) : std::string (defaultValue);
+}
+
+std::vector<std::string> split (const std::string& text, char delimiter)
+{
+    std::vector<std::string> tokens;
+    std::stringstream stream (text);
+    std::string token;
+
+    while (std::getline (stream, token, delimiter))
+        tokens.push_back (token);
+
+    if (! text.empty() && text.back() == delimiter)
+        tokens.push_back ("");
+
+    return tokens;
+}
+
+FakeProbe makeProbe (const std::string& partNumber)
+{
+    FakeProbe probe;
+    probe.partNumber = partNumber;
+
+    if (partNumber == "NP2020" || partNumber == "NP2021")
+    {
+        probe.headstagePartNumber = "NPM_HS_32";
+        probe.format = PacketFormat::PACKET_INFO;
+        probe.numSources = 4;
+    }
+    else if (partNumber.rfind ("NP20", 0) == 0 || partNumber.rfind ("PRB2", 0) == 0)
+    {
+        probe.headstagePartNumber = "NPM_HS_30";
+        probe.format = PacketFormat::PACKET_INFO;
+    }
+    else if (partNumber == "NP1200" || partNumber == "NP1210")
+    {
+        probe.headstagePartNumber = "NPNH_HS_30";
+    }
+    else if (partNumber == "NP1300")
+    {
+        probe.headstagePartNumber = "OPTO_HS_00";
+    }
+    else
+    {
+        probe.headstagePartNumber = "NP2_HS_30";
+    }
+
+    return probe;
+}
+
+/**
+
+	Global state of the simulated rig.
+
+*/
+class FakeSystem
+{
+public:
+    static FakeSystem& getInstance()
+    {
+        static FakeSystem instance;
+        return instance;
+    }
+
+    std::mutex lock;
+
+    std::vector<int> pxiSlots;
+    std::vector<int> oneBoxSerials;
+    std::map<int, int> oneBoxSlots; // slot -> serial
+
+    FakeProbe probes[numPorts][numDocks];
+    bool hasProbe[numPorts][numDocks] = {};
+
+    std::map<int, bool> running;
+    std::map<StreamKey, FakeStream> streams;
+
+    double rateMultiplier;
+    double fifoSeconds;
+    double latencyUs;
+    double jitterUs;
+
+    std::vector<int16_t> waveform;
+
+    bool isSlotOpen (int slot) const
+    {
+        for (int s : pxiSlots)
+            if (s == slot)
+                return true;
+
+        return oneBoxSlots.count (slot) > 0;
+    }
+
+    bool isProbeConnected (int slot, int port, int dock) const
+    {
+        if (! isSlotOpen (slot) || port < 1 || port > numPorts || dock < 1 || dock > numDocks)
+            return false;
+
+        return hasProbe[port - 1][dock - 1];
+    }
+
+    const FakeProbe* getProbe (int slot, int port, int dock) const
+    {
+        if (! isProbeConnected (slot, port, dock))
+            return nullptr;
+
+        return &probes[port - 1][dock - 1];
+    }
+
+    /** Returns the FIFO for a stream, creating it at the trigger time if needed */
+    FakeStream* getStream (int slot, int port, int dock, int source, double packetsPerSecond)
+    {
+        auto it = running.find (slot);
+
+        if (it == running.end() || ! it->second)
+            return nullptr;
+
+        StreamKey key (slot, port, dock, source);
+        auto stream = streams.find (key);
+
+        if (stream == streams.end())
+        {
+            FakeStream& s = streams[key];
+            s.start = triggerTimes[slot];
+            s.packetsPerSecond = packetsPerSecond * rateMultiplier;
+            s.capacity = std::max (1, int (s.packetsPerSecond * fifoSeconds));
+            return &s;
+        }
+
+        return &stream->second;
+    }
+
+    /** Number of packets waiting in a FIFO; packets beyond its capacity are dropped */
+    int update (FakeStream& stream)
+    {
+        const double elapsed = std::chrono::duration<double> (std::chrono::steady_clock::now() - stream.start).count();
+        const int64_t produced = int64_t (elapsed * stream.packetsPerSecond);
+
+        if (produced - stream.packetsConsumed > stream.capacity)
+            stream.packetsConsumed = produced - stream.capacity;
+
+        return int (produced - stream.packetsConsumed);
+    }
+
+    void trigger (int slot)
+    {
+        triggerTimes[slot] = std::chrono::steady_clock::now();
+        running[slot] = true;
+    }
+
+    void stop (int slot)
+    {
+        running[slot] = false;
+
+        for (auto it = streams.begin(); it != streams.end();)
+        {
+            if (std::get<0> (it->first) == slot)
+                it = streams.erase (it);
+            else
+                ++it;
+        }
+    }
+
+    int16_t sample (int64_t sampleIndex, int channel) const
+    {
+        return waveform[(sampleIndex + channel * 17) & (waveformLength - 1)];
+    }
+
+    /** Status word for an AP sample: the sync input is a 1 Hz square wave */
+    uint16_t status (int64_t sampleIndex, double sampleRate) const
+    {
+        return (int64_t (sampleIndex / (sampleRate / 2.0)) & 1) ? ELECTRODEPACKET_STATUS_SYNC : 0;
+    }
+
+    uint32_t timestamp (int64_t sampleIndex, double sampleRate) const
+    {
+        return uint32_t (int64_t (sampleIndex * timestampClockRate / sampleRate));
+    }
+
+    /** Blocks for the configured read latency */
+    void injectLatency()
+    {
+        double delayUs = latencyUs;
+
+        if (jitterUs > 0)
+        {
+            std::lock_guard<std::mutex> guard (randomLock);
+            delayUs += std::uniform_real_distribution<double> (0.0, jitterUs) (random);
+        }
+
+        if (delayUs <= 0)
+            return;
+
+        const auto deadline = std::chrono::steady_clock::now() + std::chrono::duration<double, std::micro> (delayUs);
+
+        while (std::chrono::steady_clock::now() < deadline)
+            std::this_thread::yield();
+    }
+
+private:
+    FakeSystem()
+    {
+        for (const std::string& slot : split (getEnvString ("NPX_FAKE_SLOTS", "2"), ','))
+            if (! slot.empty())
+                pxiSlots.push_back (std::atoi (slot.c_str()));
+
+        for (const std::string& serial : split (getEnvString ("NPX_FAKE_ONEBOX", ""), ','))
+            if (! serial.empty())
+                oneBoxSerials.push_back (std::atoi (serial.c_str()));
+
+        std::vector<std::string> ports = split (getEnvString ("NPX_FAKE_PROBES", "PRB_1_4_0480_1,NP2013,,"), ',');
+
+        for (int port = 0; port < numPorts && port < int (ports.size()); port++)
+        {
+            std::vector<std::string> docks = split (ports[port], '+');
+
+            for (int dock = 0; dock < numDocks && dock < int (docks.size()); dock++)
+            {
+                if (docks[dock].empty())
+                    continue;
+
+                probes[port][dock] = makeProbe (docks[dock]);
+                hasProbe[port][dock] = true;
+            }
+        }
+
+        rateMultiplier = std::max (0.001, getEnvDouble ("NPX_FAKE_RATE", 1.0));
+        fifoSeconds = std::max (0.001, getEnvDouble ("NPX_FAKE_FIFO_MS", 1000.0) / 1000.0);
+        latencyUs = getEnvDouble ("NPX_FAKE_LATENCY_US", 0.0);
+        jitterUs = getEnvDouble ("NPX_FAKE_JITTER_US", 0.0);
+
+        // 937.5 Hz sine at 30 kHz plus low-level noise
+        std::mt19937 noise (1234);
+        std::normal_distribution<double> gaussian (0.0, 10.0);
+
+        for (int i = 0; i < waveformLength; i++)
+            waveform.push_back (int16_t (100.0 * std::sin (2.0 * 3.14159265358979323846 * 32.0 * i / waveformLength) + gaussian (noise)));
+    }
+
+    std::map<int, std::chrono::steady_clock::time_point> triggerTimes;
+
+    std::mutex randomLock;
+    std::mt19937 random;
+};
+
+void copyString (char* destination, const std::string& source, size_t size)
+{
+    std::snprintf (destination, size, "%s", source.c_str());
+}
+
+void fillHardwareID (HardwareID* id, const std::string& partNumber, uint64_t serialNumber)
+{
+    std::memset (id, 0, sizeof (HardwareID));
+    id->SerialNumber = serialNumber;
+    copyString (id->ProductNumber, partNumber, sizeof (id->ProductNumber));
+    copyString (id->version_Major, "1", sizeof (id->version_Major));
+    copyString (id->version_Minor, "0", sizeof (id->version_Minor));
+}
+
+uint64_t getSerialNumber (int slot, int port, int dock)
+{
+    return 18000000000ULL + uint64_t (slot) * 100 + uint64_t (port) * 10 + uint64_t (dock);
+}
+
+} // namespace
+
+// Device discovery
+
+void Neuropixels::getAPIVersion (int* version_major, int* version_minor, int* version_patch)
+{
+    *version_major = 4;
+    *version_minor = 1;
+    *version_patch = 3;
+}
+
+void Neuropixels::checkFtdiDriver (ftdi_driver_version_t* required, ftdi_driver_version_t* current, bool* is_driver_present, bool* is_version_ok)
+{
+    required->vmajor = current->vmajor = 2;
+    required->vminor = current->vminor = 12;
+    required->vbuild = current->vbuild = 36;
+    *is_driver_present = true;
+    *is_version_ok = true;
+}
+
+const char* Neuropixels::getErrorMessage (NP_ErrorCode code)
+{
+    switch (code)
+    {
+        case SUCCESS:
+            return "Success (fake API)";
+        case NO_SLOT:
+            return "No basestation in this slot (fake API)";
+        case NO_LINK:
+            return "No probe at this location (fake API)";
+        case NOTSUPPORTED:
+            return "Not supported (fake API)";
+        default:
+            return "Error (fake API)";
+    }
+}
+
+int Neuropixels::getDeviceList (struct basestationID* list, int count)
+{
+    FakeSystem& fake = FakeSystem::getInstance();
+    int found = 0;
+
+    for (int slot : fake.pxiSlots)
+    {
+        if (found < count)
+        {
+            list[found].platformid = NPPlatform_PXI;
+            list[found].ID = slot;
+        }
+
+        found++;
+    }
+
+    for (int serial : fake.oneBoxSerials)
+    {
+        if (found < count)
+        {
+            list[found].platformid = NPPlatform_USB;
+            list[found].ID = serial;
+        }
+
+        found++;
+    }
+
+    return found;
+}
+
+NP_ErrorCode Neuropixels::getDeviceInfo (int slotID, struct basestationID* info)
+{
+    FakeSystem& fake = FakeSystem::getInstance();
+    std::lock_guard<std::mutex> guard (fake.lock);
+
+    for (int slot : fake.pxiSlots)
+    {
+        if (slot == slotID)
+        {
+            info->platformid = NPPlatform_PXI;
+            info->ID = slot;
+            return SUCCESS;
+        }
+    }
+
+    auto it = fake.oneBoxSlots.find (slotID);
+
+    if (it != fake.oneBoxSlots.end())
+    {
+        info->platformid = NPPlatform_USB;
+        info->ID = it->second;
+        return SUCCESS;
+    }
+
+    return NO_SLOT;
+}
+
+bool Neuropixels::tryGetSlotID (const basestationID* bsid, int* slotID)
+{
+    FakeSystem& fake = FakeSystem::getInstance();
+    std::lock_guard<std::mutex> guard (fake.lock);
+
+    if (bsid->platformid == NPPlatform_PXI)
+    {
+        *slotID = bsid->ID;
+        return true;
+    }
+
+    for (const auto& entry : fake.oneBoxSlots)
+    {
+        if (entry.second == bsid->ID)
+        {
+            *slotID = entry.first;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+NP_ErrorCode Neuropixels::scanBS (void)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::mapBS (int serial_number, int slotID)
+{
+    FakeSystem& fake = FakeSystem::getInstance();
+    std::lock_guard<std::mutex> guard (fake.lock);
+
+    for (int serial : fake.oneBoxSerials)
+    {
+        if (serial == serial_number)
+        {
+            fake.oneBoxSlots[slotID] = serial_number;
+            return SUCCESS;
+        }
+    }
+
+    return NO_SLOT;
+}
+
+NP_ErrorCode Neuropixels::setParameter (np_parameter_t paramID, int value)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::getParameter (np_parameter_t paramID, int* value)
+{
+    *value = 0;
+    return SUCCESS;
+}
+
+// Basestation
+
+NP_ErrorCode Neuropixels::openBS (int slotID)
+{
+    FakeSystem& fake = FakeSystem::getInstance();
+    std::lock_guard<std::mutex> guard (fake.lock);
+
+    return fake.isSlotOpen (slotID) ? SUCCESS : NO_SLOT;
+}
+
+NP_ErrorCode Neuropixels::closeBS (int slotID)
+{
+    FakeSystem& fake = FakeSystem::getInstance();
+    std::lock_guard<std::mutex> guard (fake.lock);
+
+    fake.stop (slotID);
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::arm (int slotID)
+{
+    FakeSystem& fake = FakeSystem::getInstance();
+    std::lock_guard<std::mutex> guard (fake.lock);
+
+    fake.stop (slotID);
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::setSWTrigger (int slotID)
+{
+    FakeSystem& fake = FakeSystem::getInstance();
+    std::lock_guard<std::mutex> guard (fake.lock);
+
+    fake.trigger (slotID);
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::setSWTriggerEx (int slotID, swtriggerflags_t trigger_flags)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::switchmatrix_set (int slotID, switchmatrixoutput_t output, switchmatrixinput_t input, bool connect)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::switchmatrix_get (int slotID, switchmatrixoutput_t output, switchmatrixinput_t input, bool* is_connected)
+{
+    *is_connected = false;
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::switchmatrix_clear (int slotID, switchmatrixoutput_t output)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::setSyncClockFrequency (int slotID, double frequency)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::bs_getFirmwareInfo (int slotID, struct firmware_Info* info)
+{
+    info->major = 3;
+    info->minor = 0;
+    info->build = 226;
+    copyString (info->name, "BS_FPGA_FAKE", sizeof (info->name));
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::bs_updateFirmware (int slotID, const char* filename, int (*callback) (size_t bytes_written))
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::bsc_getFirmwareInfo (int slotID, struct firmware_Info* info)
+{
+    info->major = 4;
+    info->minor = 0;
+    info->build = 233;
+    copyString (info->name, "QBSC_FPGA_FAKE", sizeof (info->name));
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::bsc_updateFirmware (int slotID, const char* filename, int (*callback) (size_t bytes_written))
+{
+    return SUCCESS;
+}
+
+// Ports, headstages and probes
+
+NP_ErrorCode Neuropixels::getHSSupportedProbeCount (int slotID, int portID, int* count)
+{
+    FakeSystem& fake = FakeSystem::getInstance();
+    const FakeProbe* probe = fake.getProbe (slotID, portID, 1);
+
+    *count = (probe != nullptr && probe->headstagePartNumber.rfind ("NPM_HS", 0) == 0) ? 2 : 1;
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::openPort (int slotID, int portID)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::closePort (int slotID, int portID)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::detectHeadStage (int slotID, int portID, bool* detected)
+{
+    FakeSystem& fake = FakeSystem::getInstance();
+
+    *detected = fake.isProbeConnected (slotID, portID, 1);
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::detectFlex (int slotID, int portID, int dockID, bool* detected)
+{
+    FakeSystem& fake = FakeSystem::getInstance();
+
+    *detected = fake.isProbeConnected (slotID, portID, dockID);
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::setHSLed (int slotID, int portID, bool enable)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::openProbe (int slotID, int portID, int dockID)
+{
+    return FakeSystem::getInstance().isProbeConnected (slotID, portID, dockID) ? SUCCESS : NO_LINK;
+}
+
+NP_ErrorCode Neuropixels::closeProbe (int slotID, int portID, int dockID)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::init (int slotID, int portID, int dockID)
+{
+    return FakeSystem::getInstance().isProbeConnected (slotID, portID, dockID) ? SUCCESS : NO_LINK;
+}
+
+NP_ErrorCode Neuropixels::writeProbeConfiguration (int slotID, int portID, int dockID, bool read_check)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::setADCCalibration (int slotID, int portID, const char* filename)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::setGainCalibration (int slotID, int portID, int dockID, const char* filename)
+{
+    return SUCCESS;
+}
+
+// Data streams
+
+NP_ErrorCode Neuropixels::readElectrodeData (int slotID, int portID, int dockID, struct electrodePacket* packets, int* actual_amount, int requested_amount)
+{
+    FakeSystem& fake = FakeSystem::getInstance();
+    fake.injectLatency();
+
+    *actual_amount = 0;
+
+    int count;
+    int64_t firstPacket;
+
+    // Claim the packets under the lock, then synthesize them without holding it, so that reads
+    // from different streams run in parallel
+    {
+        std::lock_guard<std::mutex> guard (fake.lock);
+
+        if (! fake.isProbeConnected (slotID, portID, dockID))
+            return NO_LINK;
+
+        FakeStream* stream = fake.getStream (slotID, portID, dockID, SourceAP, apSampleRate / NP1_PROBE_SUPERFRAMESIZE);
+
+        if (stream == nullptr)
+            return SUCCESS;
+
+        count = std::min (requested_amount, fake.update (*stream));
+        firstPacket = stream->packetsConsumed;
+        stream->packetsConsumed += count;
+    }
+
+    for (int p = 0; p < count; p++)
+    {
+        electrodePacket& packet = packets[p];
+        const int64_t packetIndex = firstPacket + p;
+
+        for (int s = 0; s < NP1_PROBE_SUPERFRAMESIZE; s++)
+        {
+            const int64_t sampleIndex = packetIndex * NP1_PROBE_SUPERFRAMESIZE + s;
+
+            packet.timestamp[s] = fake.timestamp (sampleIndex, apSampleRate);
+            packet.Status[s] = fake.status (sampleIndex, apSampleRate);
+
+            for (int ch = 0; ch < NP1_PROBE_CHANNEL_COUNT; ch++)
+                packet.apData[s][ch] = fake.sample (sampleIndex, ch);
+        }
+
+        packet.Status[0] |= ELECTRODEPACKET_STATUS_LFP;
+
+        for (int ch = 0; ch < NP1_PROBE_CHANNEL_COUNT; ch++)
+            packet.lfpData[ch] = fake.sample (packetIndex, ch) / 2;
+    }
+
+    *actual_amount = count;
+
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::getElectrodeDataFifoState (int slotID, int portID, int dockID, int* packets_available, int* headroom)
+{
+    FakeSystem& fake = FakeSystem::getInstance();
+    fake.injectLatency();
+
+    std::lock_guard<std::mutex> guard (fake.lock);
+
+    *packets_available = 0;
+    *headroom = 0;
+
+    if (! fake.isProbeConnected (slotID, portID, dockID))
+        return NO_LINK;
+
+    FakeStream* stream = fake.getStream (slotID, portID, dockID, SourceAP, apSampleRate / NP1_PROBE_SUPERFRAMESIZE);
+
+    if (stream != nullptr)
+    {
+        *packets_available = fake.update (*stream);
+        *headroom = stream->capacity - *packets_available;
+    }
+
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::setOPMODE (int slotID, int portID, int dockID, probe_opmode_t mode)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::readPackets (int slotID, int portID, int dockID, streamsource_t source, struct PacketInfo* pck_info, int16_t* data, int channel_count, int packet_count, int* packets_read)
+{
+    FakeSystem& fake = FakeSystem::getInstance();
+    fake.injectLatency();
+
+    *packets_read = 0;
+
+    int count;
+    int64_t firstPacket;
+    double sampleRate;
+
+    // Claim the packets under the lock, then synthesize them without holding it
+    {
+        std::lock_guard<std::mutex> guard (fake.lock);
+
+        const FakeProbe* probe = fake.getProbe (slotID, portID, dockID);
+
+        if (probe == nullptr)
+            return NO_LINK;
+
+        const bool isLfp = probe->format == PacketFormat::ELECTRODE_PACKET && source == SourceLFP;
+        sampleRate = isLfp ? lfpSampleRate : apSampleRate;
+
+        FakeStream* stream = fake.getStream (slotID, portID, dockID, source, sampleRate);
+
+        if (stream == nullptr)
+            return SUCCESS;
+
+        count = std::min (packet_count, fake.update (*stream));
+        firstPacket = stream->packetsConsumed;
+        stream->packetsConsumed += count;
+    }
+
+    for (int p = 0; p < count; p++)
+    {
+        const int64_t sampleIndex = firstPacket + p;
+
+        pck_info[p].Timestamp = fake.timestamp (sampleIndex, sampleRate);
+        pck_info[p].Status = fake.status (sampleIndex, sampleRate);
+        pck_info[p].payloadlength = uint16_t (channel_count);
+
+        int16_t* samples = data + int64_t (p) * channel_count;
+
+        for (int ch = 0; ch < channel_count; ch++)
+            samples[ch] = fake.sample (sampleIndex, ch + source * NP1_PROBE_CHANNEL_COUNT);
+    }
+
+    *packets_read = count;
+
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::getPacketFifoStatus (int slotID, int portID, int dockID, streamsource_t source, int* packets_available, int* headroom)
+{
+    FakeSystem& fake = FakeSystem::getInstance();
+    fake.injectLatency();
+
+    std::lock_guard<std::mutex> guard (fake.lock);
+
+    *packets_available = 0;
+    *headroom = 0;
+
+    const FakeProbe* probe = fake.getProbe (slotID, portID, dockID);
+
+    if (probe == nullptr)
+        return NO_LINK;
+
+    const bool isLfp = probe->format == PacketFormat::ELECTRODE_PACKET && source == SourceLFP;
+
+    FakeStream* stream = fake.getStream (slotID, portID, dockID, source, isLfp ? lfpSampleRate : apSampleRate);
+
+    if (stream != nullptr)
+    {
+        *packets_available = fake.update (*stream);
+        *headroom = stream->capacity - *packets_available;
+    }
+
+    return SUCCESS;
+}
+
+// Probe configuration
+
+NP_ErrorCode Neuropixels::setGain (int slotID, int portID, int dockID, int channel, int ap_gain_select, int lfg_gain_select)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::getGain (int slotID, int portID, int dockID, int channel, int* ap_gain_select, int* lfg_gain_select)
+{
+    *ap_gain_select = 3;
+    *lfg_gain_select = 2;
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::selectElectrode (int slotID, int portID, int dockID, int channel, int shank, int bank)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::setReference (int slotID, int portID, int dockID, int channel, int shank, channelreference_t reference, int int_ref_electrode_bank)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::setAPCornerFrequency (int slotID, int portID, int dockID, int channel, bool disable_high_pass)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::selectColumnPattern (int slotID, int portID, int dockID, columnpattern_t pattern)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::selectElectrodeGroup (int slotID, int portID, int dockID, int channel_group, int bank)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::selectElectrodeGroupMask (int slotID, int portID, int dockID, int channel_group, electrodebanks_t mask)
+{
+    return SUCCESS;
+}
+
+// OneBox waveplayer, ADCs and DACs
+
+NP_ErrorCode Neuropixels::waveplayer_writeBuffer (int slotID, const int16_t* data, unsigned int len)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::waveplayer_arm (int slotID, bool single_shot)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::waveplayer_setSampleFrequency (int slotID, double frequency_Hz)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::ADC_enableProbe (int slotID, bool enable)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::ADC_setComparatorThreshold (int slotID, int ADC_channel, double v_low, double v_high)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::ADC_setVoltageRange (int slotID, ADCrange_t range)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::DAC_enableOutput (int slotID, int DAC_channel, bool state)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::DAC_setProbeSniffer (int slotID, int DAC_channel, int portID, int dockID, int channel, streamsource_t source_type)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::ADC_readPackets (int slotID, struct PacketInfo* pck_info, int16_t* data, int channel_count, int packet_count, int* packets_read)
+{
+    FakeSystem& fake = FakeSystem::getInstance();
+    fake.injectLatency();
+
+    *packets_read = 0;
+
+    int count;
+    int64_t firstPacket;
+
+    // Claim the packets under the lock, then synthesize them without holding it
+    {
+        std::lock_guard<std::mutex> guard (fake.lock);
+
+        // ADC stream is keyed on port 0, which no probe uses
+        FakeStream* stream = fake.getStream (slotID, 0, 0, 0, adcSampleRate);
+
+        if (stream == nullptr)
+            return SUCCESS;
+
+        count = std::min (packet_count, fake.update (*stream));
+        firstPacket = stream->packetsConsumed;
+        stream->packetsConsumed += count;
+    }
+
+    const int numAdcs = numAdcChannels / 2;
+
+    for (int p = 0; p < count; p++)
+    {
+        const int64_t sampleIndex = firstPacket + p;
+
+        pck_info[p].Timestamp = fake.timestamp (sampleIndex, adcSampleRate);
+        pck_info[p].Status = fake.status (sampleIndex, adcSampleRate);
+        pck_info[p].payloadlength = uint16_t (channel_count);
+
+        int16_t* samples = data + int64_t (p) * channel_count;
+
+        for (int ch = 0; ch < channel_count; ch++)
+        {
+            const int16_t value = int16_t (fake.sample (sampleIndex, ch % numAdcs) * 50);
+            samples[ch] = ch < numAdcs ? value : int16_t (value > 0 ? 1 : 0);
+        }
+    }
+
+    *packets_read = count;
+
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::ADC_getPacketFifoStatus (int slotID, int* packets_avaialble, int* headroom)
+{
+    FakeSystem& fake = FakeSystem::getInstance();
+    fake.injectLatency();
+
+    std::lock_guard<std::mutex> guard (fake.lock);
+
+    *packets_avaialble = 0;
+    *headroom = 0;
+
+    FakeStream* stream = fake.getStream (slotID, 0, 0, 0, adcSampleRate);
+
+    if (stream != nullptr)
+    {
+        *packets_avaialble = fake.update (*stream);
+        *headroom = stream->capacity - *packets_avaialble;
+    }
+
+    return SUCCESS;
+}
+
+// Built-in self tests (always pass)
+
+NP_ErrorCode Neuropixels::bistBS (int slotID)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::bistHB (int slotID, int portID, int dockID)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::bistStartPRBS (int slotID, int portID)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::bistStopPRBS (int slotID, int portID, int* prbs_err)
+{
+    *prbs_err = 0;
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::bistI2CMM (int slotID, int portID, int dockID)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::bistEEPROM (int slotID, int portID)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::bistSR (int slotID, int portID, int dockID, uint8_t* shanksOkMask)
+{
+    if (shanksOkMask != nullptr)
+        *shanksOkMask = 0x0F;
+
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::bistPSB (int slotID, int portID, int dockID)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::bistNoise (int slotID, int portID, int dockID)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::bistSignal (int slotID, int portID, int dockID)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::HST_GetVersion (int slotID, int portID, int* version_major, int* version_minor)
+{
+    *version_major = 1;
+    *version_minor = 0;
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::HSTestVDDA1V2 (int slotID, int portID)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::HSTestVDDD1V2 (int slotID, int portID)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::HSTestVDDA1V8 (int slotID, int portID)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::HSTestVDDD1V8 (int slotID, int portID)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::HSTestOscillator (int slotID, int portID)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::HSTestMCLK (int slotID, int portID)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::HSTestPCLK (int slotID, int portID)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::HSTestPSB (int slotID, int portID)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::HSTestI2C (int slotID, int portID)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::HSTestNRST (int slotID, int portID)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::HSTestREC_NRESET (int slotID, int portID)
+{
+    return SUCCESS;
+}
+
+// Hardware IDs
+
+NP_ErrorCode Neuropixels::getBSCHardwareID (int slotID, struct HardwareID* pHwid)
+{
+    fillHardwareID (pHwid, "NP2_QBSC_00", getSerialNumber (slotID, 0, 0));
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::getHeadstageHardwareID (int slotID, int portID, struct HardwareID* pHwid)
+{
+    const FakeProbe* probe = FakeSystem::getInstance().getProbe (slotID, portID, 1);
+
+    if (probe == nullptr)
+        return NO_LINK;
+
+    fillHardwareID (pHwid, probe->headstagePartNumber, getSerialNumber (slotID, portID, 0));
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::getFlexHardwareID (int slotID, int portID, int dockID, struct HardwareID* pHwid)
+{
+    const FakeProbe* probe = FakeSystem::getInstance().getProbe (slotID, portID, dockID);
+
+    if (probe == nullptr)
+        return NO_LINK;
+
+    fillHardwareID (pHwid, "NPM_FLEX_00", getSerialNumber (slotID, portID, dockID));
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::getProbeHardwareID (int slotID, int portID, int dockID, struct HardwareID* pHwid)
+{
+    const FakeProbe* probe = FakeSystem::getInstance().getProbe (slotID, portID, dockID);
+
+    if (probe == nullptr)
+        return NO_LINK;
+
+    fillHardwareID (pHwid, probe->partNumber, getSerialNumber (slotID, portID, dockID));
+    return SUCCESS;
+}
+
+// Opto
+
+NP_ErrorCode Neuropixels::setEmissionSite (int slotID, int portID, int dockID, wavelength_t wavelength, int site)
+{
+    return SUCCESS;
+}
+
+NP_ErrorCode Neuropixels::getEmissionSite (int slotID, int portID, int dockID, wavelength_t wavelength, int* site)
+{
+    *site = -1;
+    return SUCCESS;
+}
+
+namespace Neuropixels
+{
+extern "C"
+{
+    NP_ErrorCode NP_APIC np_setHSLed (int slotID, int portID, bool enable)
+    {
+        return SUCCESS;
+    }
+
+    void NP_APIC np_dbg_setlevel (int level)
+    {
+    }
+
+    NP_ErrorCode NP_APIC np_setOpticalCalibration (int slotID, int portID, int dockID, const char* filename)
+    {
+        return SUCCESS;
+    }
+
+    NP_ErrorCode NP_APIC np_setEmissionSite (int slotID, int portID, int dockID, wavelength_t wavelength, int site)
+    {
+        return SUCCESS;
+    }
+}
+} // namespace Neuropixels
@@ -424,6 +424,8 @@ void OneBox::startAcquisition()
 
     adcSource->startAcquisition();
 
+    acquisitionPool.start();
+
     errorCode = Neuropixels::switchmatrix_set (slot, Neuropixels::SM_Output_AcquisitionTrigger, Neuropixels::SM_Input_SWTrigger1, true);
 
     LOGD ("OneBox software trigger");
@@ -439,6 +441,8 @@ void OneBox::startAcquisition()
 
 void OneBox::stopAcquisition()
 {
+    acquisitionPool.stop();
+
     for (auto probe : probes)
     {
         if (probe->isEnabled)
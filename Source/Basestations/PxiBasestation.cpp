@@ -568,6 +568,8 @@ void PxiBasestation::startAcquisition()
             probe->startAcquisition();
     }
 
+    acquisitionPool.start();
+
     errorCode = Neuropixels::setSWTrigger (slot);
 }
 
@@ -575,6 +577,8 @@ void PxiBasestation::stopAcquisition()
 {
     LOGC ("Basestation stopping acquisition.");
 
+    acquisitionPool.stop();
+
     for (auto probe : probes)
     {
         if (probe->isEnabled)
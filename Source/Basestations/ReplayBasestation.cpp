@@ -0,0 +1,194 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "ReplayBasestation.h"
+#include "SimulatedBasestation.h"
+
+#include "../Headstages/SimulatedHeadstage.h"
+#include "../Probes/ReplayProbe.h"
+
+void ReplayBasestation::getInfo()
+{
+    info.boot_version = "SIM 0.0";
+    info.version = "SIM 0.0";
+    info.part_number = "Replay BS";
+}
+
+ReplayBasestation::ReplayBasestation (NeuropixThread* neuropixThread,
+                                      int slot_number,
+                                      const Array<File>& captureFiles_,
+                                      double speed_) : Basestation (neuropixThread, slot_number),
+                                                       captureFiles (captureFiles_),
+                                                       speed (speed_)
+{
+    type = BasestationType::SIMULATED;
+
+    getInfo();
+}
+
+bool ReplayBasestation::chooseCaptureFiles (Array<File>& files, double& speed)
+{
+    FileChooser fileChooser ("Select packet capture files to replay",
+                             File::getSpecialLocation (File::userDocumentsDirectory).getChildFile ("Neuropixels captures"),
+                             "*.npxcap");
+
+    if (! fileChooser.browseForMultipleFilesToOpen())
+        return false;
+
+    files = fileChooser.getResults();
+
+    AlertWindow window ("Replay speed", "Select how fast the capture files are replayed.", MessageBoxIconType::NoIcon);
+
+    window.addComboBox ("speed", { "Real time", "2x real time", "4x real time", "10x real time", "As fast as possible" });
+    window.addButton ("OK", 1, KeyPress (KeyPress::returnKey));
+
+    window.runModalLoop();
+
+    const double speeds[] = { 1.0, 2.0, 4.0, 10.0, 0.0 };
+
+    speed = speeds[jlimit (0, 4, window.getComboBoxComponent ("speed")->getSelectedItemIndex())];
+
+    return files.size() > 0;
+}
+
+bool ReplayBasestation::open()
+{
+    headstages.clear();
+    probes.clear();
+
+    savingDirectory = File();
+
+    basestationConnectBoard = std::make_unique<SimulatedBasestationConnectBoard> (this);
+    basestationConnectBoard->getInfo();
+
+    for (int i = 0; i < maxProbes; i++)
+    {
+        auto replay = std::make_unique<CaptureReplay>();
+
+        if (i < captureFiles.size() && replay->open (captureFiles[i]))
+        {
+            replay->setSpeed (speed);
+            replay->setLooping (looping);
+
+            headstages.add (new ReplayHeadstage (this, i + 1, std::move (replay)));
+        }
+        else
+        {
+            headstages.add (nullptr);
+        }
+    }
+
+    for (auto headstage : headstages)
+    {
+        if (headstage != nullptr)
+            probes.add (headstage->getProbes()[0]);
+    }
+
+    LOGC ("Replay basestation in slot ", slot, ": ", probes.size(), " capture files, speed ", speed > 0.0 ? String (speed) + "x" : String ("max"));
+
+    syncFrequencies.add (1);
+
+    return true;
+}
+
+void ReplayBasestation::setReplaySpeed (double speed_, bool loop)
+{
+    speed = speed_;
+    looping = loop;
+
+    for (auto probe : probes)
+    {
+        CaptureReplay& replay = static_cast<ReplayProbe*> (probe)->getReplay();
+
+        replay.setSpeed (speed);
+        replay.setLooping (looping);
+    }
+}
+
+void ReplayBasestation::close()
+{
+}
+
+void ReplayBasestation::setSyncAsInput()
+{
+}
+
+void ReplayBasestation::setSyncAsOutput (int freqIndex)
+{
+}
+
+void ReplayBasestation::setSyncAsPassive()
+{
+}
+
+int ReplayBasestation::getProbeCount()
+{
+    return probes.size();
+}
+
+void ReplayBasestation::initialize (bool signalChainIsLoading)
+{
+    probesInitialized = true;
+}
+
+void ReplayBasestation::searchForProbes()
+{
+}
+
+Array<int> ReplayBasestation::getSyncFrequencies()
+{
+    return syncFrequencies;
+}
+
+float ReplayBasestation::getFillPercentage()
+{
+    float fillPercentage = 0.0f;
+
+    for (auto probe : probes)
+        fillPercentage = jmax (fillPercentage, probe->fifoFillPercentage);
+
+    return fillPercentage;
+}
+
+void ReplayBasestation::startAcquisition()
+{
+    for (int i = 0; i < probes.size(); i++)
+    {
+        if (probes[i]->isEnabled)
+            probes[i]->startAcquisition();
+    }
+
+    acquisitionPool.start();
+}
+
+void ReplayBasestation::stopAcquisition()
+{
+    acquisitionPool.stop();
+
+    for (int i = 0; i < probes.size(); i++)
+    {
+        if (probes[i]->isEnabled)
+            probes[i]->stopAcquisition();
+    }
+}
@@ -0,0 +1,103 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef __REPLAYBASESTATION_H_2C4C2D67__
+#define __REPLAYBASESTATION_H_2C4C2D67__
+
+#include "../NeuropixComponents.h"
+
+/** 
+
+	Replays packet capture files written by PacketCapture, one probe
+	per file, through the same decoding path as the hardware probes.
+
+	Replay runs at real time, at a multiple of real time, or as fast
+	as possible (speed 0), and can loop at the end of each file.
+
+*/
+class ReplayBasestation : public Basestation
+{
+public:
+    /** Constructor */
+    ReplayBasestation (NeuropixThread*, int slot, const Array<File>& captureFiles, double speed);
+
+    /** Destructor */
+    ~ReplayBasestation() {}
+
+    /** Gets part number, firmware version, etc.*/
+    void getInfo() override;
+
+    /** Opens the capture files and creates one probe per file */
+    bool open() override;
+
+    /** Closes connection to the basestation */
+    void close() override;
+
+    /** Initializes probes */
+    void initialize (bool signalChainIsLoading) override;
+
+    /** Searches for probes connected to this basestation */
+    void searchForProbes() override;
+
+    /** Returns the total number of probes connected to this basestation*/
+    int getProbeCount() override;
+
+    /** Set basestation SMA connector as input*/
+    void setSyncAsInput() override;
+
+    /** Set basestation SMA connector as output (and set frequency)*/
+    void setSyncAsOutput (int freqIndex) override;
+
+    /** Set basestation SMA connector to passively inherit signal from backplane */
+    void setSyncAsPassive() override;
+
+    /** Starts probe data streaming */
+    void startAcquisition() override;
+
+    /** Stops probe data streaming*/
+    void stopAcquisition() override;
+
+    /** Returns an array of available frequencies when SMA is in "output" mode */
+    Array<int> getSyncFrequencies() override;
+
+    /** Returns the fraction of the basestation FIFO that is filled */
+    float getFillPercentage() override;
+
+    /** Sets the replay rate relative to real time (0 = as fast as possible) and the looping mode */
+    void setReplaySpeed (double speed, bool loop);
+
+    /** Asks the user for capture files and a replay speed; returns false if cancelled */
+    static bool chooseCaptureFiles (Array<File>& files, double& speed);
+
+    /** Maximum number of capture files per basestation (one per port) */
+    static constexpr int maxProbes = 4;
+
+private:
+    Array<File> captureFiles;
+
+    double speed;
+    bool looping = true;
+};
+
+#endif // __REPLAYBASESTATION_H_2C4C2D67__
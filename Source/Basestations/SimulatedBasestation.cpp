@@ -245,10 +245,14 @@ void SimulatedBasestation::startAcquisition()
         if (probes[i]->isEnabled)
             probes[i]->startAcquisition();
     }
+
+    acquisitionPool.start();
 }
 
 void SimulatedBasestation::stopAcquisition()
 {
+    acquisitionPool.stop();
+
     for (int i = 0; i < probes.size(); i++)
     {
         if (probes[i]->isEnabled)
@@ -22,6 +22,7 @@
 */
 
 #include "SimulatedHeadstage.h"
+#include "../Probes/ReplayProbe.h"
 #include "../Probes/SimulatedProbe.h"
 
 void SimulatedHeadstage::getInfo()
@@ -50,4 +51,20 @@ SimulatedHeadstage::SimulatedHeadstage (Basestation* bs, int port, String PN, in
         // 2.0 headstage, add a placeholder for second dock
         probes.add (nullptr);
     }
+}
+
+void ReplayHeadstage::getInfo()
+{
+    info.version = "SIM0.0";
+    info.part_number = "Replay headstage";
+}
+
+ReplayHeadstage::ReplayHeadstage (Basestation* bs, int port, std::unique_ptr<CaptureReplay> replay) : Headstage (bs, port)
+{
+    getInfo();
+
+    flexCables.add (new SimulatedFlex (this));
+
+    probes.add (new ReplayProbe (basestation, this, flexCables[0], std::move (replay)));
+    probes[0]->setStatus (SourceStatus::CONNECTING);
 }
\ No newline at end of file
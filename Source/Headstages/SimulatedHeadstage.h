@@ -43,6 +43,18 @@ public:
     void runTestModule() override {}
 };
 
+class CaptureReplay;
+
+/** Headstage holding a single ReplayProbe */
+class ReplayHeadstage : public Headstage
+{
+public:
+    ReplayHeadstage (Basestation* bs, int port, std::unique_ptr<CaptureReplay> replay);
+    void getInfo() override;
+    bool hasTestModule() override { return false; }
+    void runTestModule() override {}
+};
+
 class SimulatedFlex : public Flex
 {
 public:
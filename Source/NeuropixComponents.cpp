@@ -26,6 +26,12 @@
 float FirmwareUpdater::totalFirmwareBytes = 0;
 FirmwareUpdater* FirmwareUpdater::currentThread = nullptr;
 
+void DataSource::startAcquisitionThread()
+{
+    if (! basestation->acquisitionPool.addTasks (getAcquisitionTasks()))
+        startThread();
+}
+
 Probe::Probe (Basestation* bs_, Headstage* hs_, Flex* fl_, int dock_)
     : DataSource (bs_),
       headstage (hs_),
@@ -35,75 +41,45 @@ Probe::Probe (Basestation* bs_, Headstage* hs_, Flex* fl_, int dock_)
       isCalibrated (false),
       calibrationWarningShown (false)
 {
-    for (int i = 0; i < 12 * MAXPACKETS; i++)
-        timestamp_s[i] = -1.0;
-
     sourceType = DataSourceType::PROBE;
-
-    for (int i = 0; i < 384; i++)
-    {
-        for (int j = 0; j < 100; j++)
-        {
-            ap_offsets[i][j] = 0;
-            lfp_offsets[i][j] = 0;
-        }
-    }
 }
 
-void Probe::updateOffsets (float* samples, int64 timestamp, bool isApBand)
+void Probe::prepareOffsets (int numChannels, float apSampleRate, float lfpSampleRate)
 {
-    if (isApBand && timestamp > 30000 * 5) // wait for amplifiers to settle
-    {
-        if (ap_offset_counter < 99)
-        {
-            for (int i = 0; i < 384; i++)
-            {
-                ap_offsets[i][ap_offset_counter + 1] = samples[i];
-            }
+    apOffsets.prepare (offsetSettings, numChannels, apSampleRate);
+    lfpOffsets.prepare (offsetSettings, numChannels, lfpSampleRate);
 
-            ap_offset_counter++;
-        }
-        else if (ap_offset_counter == 99)
-        {
-            for (int i = 0; i < 384; i++)
-            {
-                for (int j = 1; j < 100; j++)
-                {
-                    ap_offsets[i][0] += ap_offsets[i][j];
-                }
-
-                ap_offsets[i][0] /= 99;
-            }
+    apScaling.setOffsets (apOffsets.getOffsets());
+    lfpScaling.setOffsets (lfpOffsets.getOffsets());
+}
 
-            ap_offset_counter++;
-        }
+void Probe::updateOffsets (const float* samples, int numSamples, int64 sampleNumber, bool isApBand)
+{
+    if (isApBand)
+    {
+        if (apOffsets.process (samples, numSamples, sampleNumber))
+            apScaling.setOffsets (apOffsets.getOffsets());
     }
-    else if (! isApBand && timestamp > 2500 * 5) // wait for amplifiers to settle
+    else
     {
-        if (lfp_offset_counter < 99)
-        {
-            for (int i = 0; i < 384; i++)
-            {
-                lfp_offsets[i][lfp_offset_counter + 1] = samples[i];
-            }
+        if (lfpOffsets.process (samples, numSamples, sampleNumber))
+            lfpScaling.setOffsets (lfpOffsets.getOffsets());
+    }
+}
 
-            lfp_offset_counter++;
-        }
-        else if (lfp_offset_counter == 99)
-        {
-            for (int i = 0; i < 384; i++)
-            {
-                for (int j = 1; j < 100; j++)
-                {
-                    lfp_offsets[i][0] += lfp_offsets[i][j];
-                }
+void Probe::resetOffsets()
+{
+    apOffsets.reset();
+    lfpOffsets.reset();
+}
 
-                lfp_offsets[i][0] /= 99;
-            }
+void Probe::setSampleScaling (float apMicrovoltsPerBit, float lfpMicrovoltsPerBit)
+{
+    apScaling.setScale (channel_count, apMicrovoltsPerBit);
+    apScaling.setOffsets (apOffsets.getOffsets());
 
-            lfp_offset_counter++;
-        }
-    }
+    lfpScaling.setScale (channel_count, lfpMicrovoltsPerBit);
+    lfpScaling.setOffsets (lfpOffsets.getOffsets());
 }
 
 void Probe::updateNamingScheme (ProbeNameConfig::NamingScheme scheme)
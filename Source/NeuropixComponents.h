@@ -31,6 +31,15 @@
 
 #include "API/NeuropixAPI.h"
 
+#include "Probes/AcquisitionPool.h"
+#include "Probes/GapFiller.h"
+#include "Probes/HardwareClock.h"
+#include "Probes/OffsetTracker.h"
+#include "Probes/PacketCapture.h"
+#include "Probes/PacketDecoder.h"
+#include "Probes/PacketLoss.h"
+#include "Probes/PollingScheduler.h"
+#include "Probes/SyncAlignment.h"
 #include "UI/ActivityView.h"
 #include "UI/ProbeNameConfig.h"
 
@@ -38,8 +47,6 @@
 #define MAX_HEADSTAGE_CLK_SAMPLE 3221225475
 #define MAX_ALLOWABLE_TIMESTAMP_JUMP 4
 
-#define MAXPACKETS 64
-
 class BasestationConnectBoard;
 class Flex;
 class Headstage;
@@ -398,6 +405,13 @@ public:
     /** Returns the name of the data source */
     virtual String getName() = 0;
 
+    /** Returns the tasks that acquire this source's data, if they can be run by an AcquisitionPool */
+    virtual Array<AcquisitionTask*> getAcquisitionTasks() { return {}; }
+
+    /** Hands this source's tasks to the basestation's AcquisitionPool if it is enabled,
+        otherwise starts this source's own thread */
+    void startAcquisitionThread();
+
     // --------- GET / SET METHODS  --------- //
 
     /** Sets the status (CONNECTING, CONNECTED, etc.) */
@@ -426,6 +440,9 @@ public:
     /** Flags if the the data source is enabled */
     bool isEnabled = true;
 
+    /** Target latency and minimum batch size for reads from the hardware FIFO */
+    PollingScheduler::Settings pollingSettings;
+
 protected:
     SourceStatus status;
 };
@@ -504,11 +521,6 @@ public:
     float ap_sample_rate;
     float lfp_sample_rate;
 
-    float ap_offsets[384][100];
-    float lfp_offsets[384][100];
-
-    double timestamp_s[12 * MAXPACKETS];
-
     int64 ap_timestamp;
     int64 lfp_timestamp;
 
@@ -525,6 +537,10 @@ public:
     /** Updates the settings object for this probe */
     void updateSettings (ProbeSettings p)
     {
+        // The offsets depend on the gains and the reference
+        if (p.apGainIndex != settings.apGainIndex || p.lfpGainIndex != settings.lfpGainIndex || p.referenceIndex != settings.referenceIndex)
+            resetOffsets();
+
         settings = p;
         refreshActivityViewMapping();
     }
@@ -532,10 +548,24 @@ public:
     /** Updates the naming scheme */
     void updateNamingScheme (ProbeNameConfig::NamingScheme scheme);
 
-    void updateOffsets (float* samples, int64 timestamp, bool isApBand);
+    /** Applies offsetSettings and the current offset estimates when acquisition starts */
+    void prepareOffsets (int numChannels, float apSampleRate, float lfpSampleRate);
+
+    /** Updates the offset estimates of one band from a decoded batch (acquisition thread) */
+    void updateOffsets (const float* samples, int numSamples, int64 sampleNumber, bool isApBand);
 
-    int ap_offset_counter = 0;
-    int lfp_offset_counter = 0;
+    /** Discards the offset estimates, e.g. after a gain or reference change */
+    void resetOffsets();
+
+    /** Sets the per-channel conversion factors used by the packet decoder (offsets are taken from apOffsets / lfpOffsets) */
+    void setSampleScaling (float apMicrovoltsPerBit, float lfpMicrovoltsPerBit);
+
+    /** DC offset correction, applied when acquisition starts */
+    OffsetTracker::Settings offsetSettings;
+
+    /** Running DC offset estimates of each band */
+    OffsetTracker apOffsets;
+    OffsetTracker lfpOffsets;
 
     ProbeType type;
 
@@ -547,6 +577,21 @@ public:
 
     float fifoFillPercentage;
 
+    /** Raw packet capture options, applied when acquisition starts */
+    PacketCapture::Settings captureSettings;
+
+    /** Timestamp jumps seen by this probe's acquisition threads */
+    PacketLossCounters packetLoss;
+
+    /** Error flags in the packet status words seen by this probe's acquisition threads */
+    StatusErrorCounters statusErrors;
+
+    /** Handling of samples lost at timestamp jumps, applied when acquisition starts */
+    GapFiller::Settings gapFillSettings;
+
+    /** Sync input edges seen by this probe's primary acquisition thread */
+    SyncEdges syncEdges;
+
     /* Stores the generic probe model name e.g. Neuripixels 2.0 - Single Shank */
     String name;
 
@@ -579,10 +624,15 @@ public:
     uint32_t last_npx_timestamp;
     bool passedOneSecond;
 
+    /** Returns the values shown by the activity view: peak-to-peak amplitudes, or AP band spike rates or noise levels */
     const float* getPeakToPeakValues (ActivityToView currentView = ActivityToView::APVIEW)
     {
         if (currentView == ActivityToView::APVIEW)
             return apView->getPeakToPeakValues();
+        else if (currentView == ActivityToView::SPIKERATEVIEW)
+            return apView->getSpikeRates();
+        else if (currentView == ActivityToView::NOISEVIEW)
+            return apView->getNoiseLevels();
         else
             return lfpView->getPeakToPeakValues();
     }
@@ -649,6 +699,25 @@ public:
         surveyModeActive = enabled;
     }
 
+    /** Selects how the activity views receive samples (only while not acquiring) */
+    void setActivityIngestion (ActivityView::Ingestion ingestion)
+    {
+        if (apView)
+            apView->setIngestion (ingestion);
+
+        if (lfpView)
+            lfpView->setIngestion (ingestion);
+    }
+
+    void setActivityRobustNoiseEnabled (bool enabled)
+    {
+        if (apView)
+            apView->setRobustNoiseEnabled (enabled);
+
+        if (lfpView)
+            lfpView->setRobustNoiseEnabled (enabled);
+    }
+
     void setEnabledForSurvey (bool enabled)
     {
         isEnabledForSurvey = enabled;
@@ -670,6 +739,10 @@ protected:
 
     void refreshActivityViewMapping();
 
+    /** Conversion factors from raw ADC values to microvolts */
+    PacketDecoder::ChannelScaling apScaling;
+    PacketDecoder::ChannelScaling lfpScaling;
+
     uint64 eventCode;
     Array<int> gains; // available gain values
     bool isEnabledForSurvey = false;
@@ -711,7 +784,8 @@ class Basestation : public NeuropixComponent
 {
 public:
     /** Constructor -- Sets the slot values. */
-    Basestation (NeuropixThread* neuropixThread_, int slot_) : NeuropixComponent()
+    Basestation (NeuropixThread* neuropixThread_, int slot_) : NeuropixComponent(),
+                                                                acquisitionPool ("Slot " + String (slot_) + " acquisition")
     {
         probesInitialized = false;
         neuropixThread = neuropixThread_;
@@ -859,6 +933,12 @@ public:
     OwnedArray<Headstage> headstages;
     Array<Probe*> probes;
 
+    /** Worker threads for the data sources on this basestation (disabled by default) */
+    AcquisitionPool acquisitionPool;
+
+    /** Maps the packet timestamps of this basestation's streams to host time */
+    HardwareClock clock;
+
     String getCustomPortName (int port, int dock)
     {
         if (dock == 0)
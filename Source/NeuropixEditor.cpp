@@ -28,6 +28,9 @@
 #include "NeuropixThread.h"
 #include "UI/NeuropixInterface.h"
 
+// Status errors in this many most recent seconds are highlighted in the FIFO monitors
+#define STATUS_ERROR_DISPLAY_SECONDS 5
+
 RefreshButton::RefreshButton() : Button ("Refresh")
 {
     XmlDocument xmlDoc (R"(
@@ -192,10 +195,74 @@ void FifoMonitor::timerCallback()
 {
     if (slot != 255)
     {
-        setFillPercentage (basestation->getFillPercentage());
+        fillPercentage = basestation->getFillPercentage();
+        updateStatusErrors();
+        repaint();
     }
 }
 
+void FifoMonitor::updateStatusErrors()
+{
+    String tooltip = "FIFO fill: " + String (int (fillPercentage * 100.0f)) + "%";
+
+    numRecentErrors = 0;
+
+    for (auto probe : basestation->getProbes())
+    {
+        const StatusErrorCounters::Counts recent = probe->statusErrors.getRecent (STATUS_ERROR_DISPLAY_SECONDS);
+        const StatusErrorCounters::Counts totals = probe->statusErrors.getTotals();
+
+        StringArray counts;
+
+        for (int type = 0; type < StatusErrorCounters::numErrorTypes; type++)
+        {
+            numRecentErrors += recent[type];
+
+            if (totals[type] > 0)
+                counts.add (String (StatusErrorCounters::getErrorName (type)) + " " + String (totals[type])
+                            + " (" + String (recent[type]) + " in last " + String (STATUS_ERROR_DISPLAY_SECONDS) + " s)");
+        }
+
+        if (counts.size() > 0)
+            tooltip += "\nPort " + String (probe->headstage->port) + ", dock " + String (probe->dock) + ": " + counts.joinIntoString (", ");
+    }
+
+    setTooltip (tooltip + "\nRight-click to export link statistics");
+}
+
+void FifoMonitor::mouseDown (const MouseEvent& event)
+{
+    if (! event.mods.isPopupMenu() || slot == 255)
+        return;
+
+    PopupMenu menu;
+    menu.addItem (1, "Export link statistics...", true);
+
+    if (menu.show() == 1)
+        exportStatistics();
+}
+
+void FifoMonitor::exportStatistics()
+{
+    String defaultName = "neuropixels_link_stats_slot" + String (slot) + "_" + Time::getCurrentTime().formatted ("%Y-%m-%d_%H-%M-%S") + ".json";
+    File defaultLocation = CoreServices::getDefaultUserSaveDirectory().getChildFile (defaultName);
+
+    FileChooser fileChooser ("Save link statistics as JSON", defaultLocation, "*.json");
+
+    if (! fileChooser.browseForFileToSave (true))
+        return;
+
+    File outputFile = fileChooser.getResult().withFileExtension (".json");
+
+    if (! outputFile.replaceWithText (PacketLossReporter::getStatsString (basestation->getProbes())))
+    {
+        CoreServices::sendStatusMessage ("Unable to write link statistics to " + outputFile.getFullPathName());
+        return;
+    }
+
+    CoreServices::sendStatusMessage ("Link statistics saved to " + outputFile.getFullPathName());
+}
+
 void FifoMonitor::setSlot (unsigned char slot_)
 {
     slot = slot_;
@@ -218,6 +285,13 @@ void FifoMonitor::paint (Graphics& g)
     g.setColour (Colours::yellow);
     float barHeight = (this->getHeight() - 4) * fillPercentage;
     g.fillRoundedRectangle (2, this->getHeight() - 2 - barHeight, this->getWidth() - 4, barHeight, 2);
+
+    if (numRecentErrors > 0)
+    {
+        g.setColour (Colours::red);
+        g.drawRoundedRectangle (1, 1, this->getWidth() - 2, this->getHeight() - 2, 2, 2.0f);
+        g.fillEllipse (this->getWidth() / 2 - 3, 3, 6, 6);
+    }
 }
 
 SourceButton::SourceButton (int id_, DataSource* source_, Basestation* basestation_)
@@ -174,10 +174,14 @@ private:
 
 /** 
 
-	Displays the FIFO filling state for each basestation
+	Displays the FIFO filling state for each basestation, and
+	whether any of its probes received packets with status errors
+	in the last few seconds (details in the tooltip).
+
+	Right-click to export the link statistics as JSON.
 
 */
-class FifoMonitor : public Component, public Timer
+class FifoMonitor : public Component, public Timer, public SettableTooltipClient
 {
 public:
     /** Constructor */
@@ -189,16 +193,26 @@ public:
     /** Sets the fill percentage to display */
     void setFillPercentage (float percentage);
 
-    /** Calls repaint() */
+    /** Updates the fill percentage and status errors */
     void timerCallback();
 
+    /** Shows the export menu on right-click */
+    void mouseDown (const MouseEvent& event) override;
+
     unsigned char slot;
 
 private:
     /** Renders the monitor */
     void paint (Graphics& g);
 
+    /** Updates the recent status error count and tooltip */
+    void updateStatusErrors();
+
+    /** Writes the basestation's packet loss and status error statistics to a JSON file */
+    void exportStatistics();
+
     float fillPercentage;
+    int64 numRecentErrors = 0;
     Basestation* basestation;
     int id;
 };
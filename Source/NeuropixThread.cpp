@@ -26,8 +26,11 @@
 
 #include "Basestations/OneBox.h"
 #include "Basestations/PxiBasestation.h"
+#include "Basestations/ReplayBasestation.h"
 #include "Basestations/SimulatedBasestation.h"
+#include "Probes/AcquisitionBenchmark.h"
 #include "Probes/OneBoxADC.h"
+#include "Probes/SimulatedProbe.h"
 
 #include "UI/NeuropixInterface.h"
 
@@ -200,6 +203,10 @@ NeuropixThread::NeuropixThread (SourceNode* sn, DeviceType type_) : DataThread (
 {
     defaultSyncFrequencies.add (1);
 
+    packetLossReporter = std::make_unique<PacketLossReporter> (this);
+    syncAligner = std::make_unique<SyncAligner> (this);
+    benchmarkThread = std::make_unique<BenchmarkThread>();
+
     api_v3.isActive = true;
 
     LOGC ("Scanning for devices...");
@@ -255,33 +262,54 @@ NeuropixThread::NeuropixThread (SourceNode* sn, DeviceType type_) : DataThread (
     // If no basestations were found, ask user if they want to run in simulation mode
     if (basestations.size() == 0)
     {
-        bool response = true;
+        // 1 = simulate, 2 = replay capture files, 0 = neither
+        int response = 1;
 
         if (! FORCE_SIMULATION_MODE)
         {
             if (type == PXI)
             {
-                response = AlertWindow::showOkCancelBox (AlertWindow::NoIcon,
-                                                         "No basestations detected",
-                                                         "No Neuropixels PXI basestations were detected. Do you want to run this plugin in simulation mode?",
-                                                         "Yes",
-                                                         "No",
-                                                         0,
-                                                         0);
+                response = AlertWindow::showYesNoCancelBox (AlertWindow::NoIcon,
+                                                            "No basestations detected",
+                                                            "No Neuropixels PXI basestations were detected. Do you want to run this plugin in simulation mode, or replay packet capture files?",
+                                                            "Simulate",
+                                                            "Replay",
+                                                            "No",
+                                                            0,
+                                                            0);
             }
             else if (type == ONEBOX)
             {
-                response = AlertWindow::showOkCancelBox (AlertWindow::NoIcon,
-                                                         "No OneBox detected",
-                                                         "No OneBox was detected. Do you want to run this plugin in simulation mode?",
-                                                         "Yes",
-                                                         "No",
-                                                         0,
-                                                         0);
+                response = AlertWindow::showYesNoCancelBox (AlertWindow::NoIcon,
+                                                            "No OneBox detected",
+                                                            "No OneBox was detected. Do you want to run this plugin in simulation mode, or replay packet capture files?",
+                                                            "Simulate",
+                                                            "Replay",
+                                                            "No",
+                                                            0,
+                                                            0);
             }
         }
 
-        if (response)
+        Array<File> captureFiles;
+        double replaySpeed = 1.0;
+
+        if (response == 2 && ReplayBasestation::chooseCaptureFiles (captureFiles, replaySpeed))
+        {
+            int slot = type == PXI ? 2 : 16;
+
+            for (int i = 0; i < captureFiles.size(); i += ReplayBasestation::maxProbes)
+            {
+                Array<File> files;
+
+                for (int j = i; j < jmin (i + ReplayBasestation::maxProbes, captureFiles.size()); j++)
+                    files.add (captureFiles[j]);
+
+                basestations.add (new ReplayBasestation (this, slot++, files, replaySpeed));
+                basestations.getLast()->open();
+            }
+        }
+        else if (response == 1)
         {
             if (type == PXI)
             {
@@ -401,11 +429,18 @@ String NeuropixThread::generateProbeName (int probeIndex, ProbeNameConfig::Namin
 
 void NeuropixThread::updateStreamInfo (bool enabledStateChanged)
 {
+    // Streams that still exist keep their DataStream and DataBuffer
+    const Array<StreamInfo> previousInfo = streamInfo;
+
+    OwnedArray<DataStream> previousStreams;
+
     if (enabledStateChanged)
-        sourceStreams.clear();
+        previousStreams.swapWith (sourceStreams);
+
+    OwnedArray<DataBuffer> previousBuffers;
+    previousBuffers.swapWith (sourceBuffers);
 
     streamInfo.clear();
-    sourceBuffers.clear();
 
     int probe_index = 0;
 
@@ -439,9 +474,6 @@ void NeuropixThread::updateStreamInfo (bool enabledStateChanged)
 
                 streamInfo.add (apInfo);
 
-                sourceBuffers.add (new DataBuffer (apInfo.num_channels, 460800)); // AP band buffer
-                probe->apBuffer = sourceBuffers.getLast();
-
                 if (probe->generatesLfpData())
                 {
                     StreamInfo lfpInfo;
@@ -451,9 +483,6 @@ void NeuropixThread::updateStreamInfo (bool enabledStateChanged)
                     lfpInfo.probe = probe;
                     lfpInfo.sendSyncAsContinuousChannel = probe->sendSync;
 
-                    sourceBuffers.add (new DataBuffer (lfpInfo.num_channels, 38400)); // LFP band buffer
-                    probe->lfpBuffer = sourceBuffers.getLast();
-
                     streamInfo.add (lfpInfo);
                 }
 
@@ -478,10 +507,6 @@ void NeuropixThread::updateStreamInfo (bool enabledStateChanged)
 
                     streamInfo.add (apInfo);
 
-                    sourceBuffers.add (new DataBuffer (apInfo.num_channels, 460800)); // AP band buffer
-
-                    probe->quadBaseBuffers.add (sourceBuffers.getLast());
-
                     LOGD ("Probe (slot=", probe->basestation->slot, ", port=", probe->headstage->port, ") SHANK=", shank + 1, " CH = ", 384, " SR = ", apInfo.sample_rate, " Hz");
                 }
 
@@ -501,23 +526,137 @@ void NeuropixThread::updateStreamInfo (bool enabledStateChanged)
                 adcInfo.probe = nullptr;
                 adcInfo.adc = (OneBoxADC*) source;
 
-                sourceBuffers.add (new DataBuffer (adcInfo.num_channels, 10000)); // data buffer
-                source->apBuffer = sourceBuffers.getLast();
-
                 streamInfo.add (adcInfo);
             }
         }
     }
 
+    if (enabledStateChanged)
+    {
+        int numReused = 0;
+
+        for (const auto& info : streamInfo)
+        {
+            const int previousIndex = findStream (previousInfo, info);
+
+            // New streams (null here) are created by updateSettings()
+            DataStream* stream = previousStreams[previousIndex];
+            sourceStreams.add (stream);
+
+            if (stream != nullptr)
+            {
+                previousStreams.set (previousIndex, nullptr, false);
+                numReused++;
+            }
+        }
+
+        LOGD ("Reused ", numReused, " of ", streamInfo.size(), " data streams");
+    }
+
+    createSourceBuffers (previousInfo, previousBuffers);
+
     LOGD ("Finished updating stream info");
 }
 
+int NeuropixThread::findStream (const Array<StreamInfo>& infos, const StreamInfo& info)
+{
+    for (int i = 0; i < infos.size(); i++)
+    {
+        if (infos.getReference (i).isSameStream (info))
+            return i;
+    }
+
+    return -1;
+}
+
+void NeuropixThread::createSourceBuffers (const Array<StreamInfo>& previousInfo, OwnedArray<DataBuffer>& previousBuffers)
+{
+    const BufferBudget previousBudget = bufferBudget;
+
+    bufferBudget.clear();
+
+    for (const auto& info : streamInfo)
+    {
+        String name;
+
+        switch (info.type)
+        {
+            case AP_BAND:
+                name = info.probe->getName() + "-AP";
+                break;
+            case LFP_BAND:
+                name = info.probe->getName() + "-LFP";
+                break;
+            case QUAD_BASE:
+                name = info.probe->getName() + "-" + String (info.shank + 1);
+                break;
+            case ADC:
+                name = "OneBox-ADC";
+                break;
+            default:
+                name = info.probe->getName();
+        }
+
+        bufferBudget.addStream (name, info.num_channels, info.sample_rate);
+    }
+
+    bufferBudget.allocate();
+
+    int numReused = 0;
+
+    for (int i = 0; i < streamInfo.size(); i++)
+    {
+        const StreamInfo& info = streamInfo.getReference (i);
+
+        const int numSamples = bufferBudget.getStream (i).numSamples;
+        const int previousIndex = findStream (previousInfo, info);
+
+        DataBuffer* buffer = nullptr;
+
+        if (previousBuffers[previousIndex] != nullptr
+            && previousInfo.getReference (previousIndex).num_channels == info.num_channels
+            && previousBudget.getStream (previousIndex).numSamples == numSamples)
+        {
+            buffer = sourceBuffers.add (previousBuffers[previousIndex]);
+            previousBuffers.set (previousIndex, nullptr, false);
+            numReused++;
+        }
+        else
+        {
+            buffer = sourceBuffers.add (new DataBuffer (info.num_channels, numSamples));
+        }
+
+        switch (info.type)
+        {
+            case LFP_BAND:
+                info.probe->lfpBuffer = buffer;
+                break;
+            case QUAD_BASE:
+                info.probe->quadBaseBuffers.add (buffer);
+                break;
+            case ADC:
+                info.adc->apBuffer = buffer;
+                break;
+            default:
+                info.probe->apBuffer = buffer;
+        }
+    }
+
+    LOGC ("Source buffers: ", bufferBudget.getNumStreams(), " streams (", numReused, " reused), ", bufferBudget.getBufferSeconds(), " s each, ", bufferBudget.getTotalBytes() / (1024 * 1024), " MB in total");
+
+    if (bufferBudget.exceedsBudget())
+        LOGE ("Source buffers exceed the memory budget of ", bufferBudget.settings.budgetMegabytes, " MB; using the minimum size for every stream");
+}
+
 NeuropixThread::~NeuropixThread()
 {
     LOGD ("NeuropixThread destructor.");
 
     editor->uiLoader->waitForThreadToExit (-1);
 
+    packetLossReporter->stop();
+    syncAligner->stop();
+
     closeConnection();
 }
 
@@ -946,14 +1085,69 @@ bool NeuropixThread::startAcquisition()
         LOGD ("Neuropixels settings thread finished.");
     }
 
+    updateInputLatency();
+
+    packetLossReporter->start (getProbes());
+    syncAligner->start (getProbes());
+
+    // All basestations measure timestamps from the same host time
+    const int64 startTicks = Time::getHighResolutionTicks();
+
     for (int i = 0; i < basestations.size(); i++)
     {
+        basestations[i]->clock.reset (startTicks);
         basestations[i]->startAcquisition();
     }
 
     return true;
 }
 
+void NeuropixThread::updateInputLatency()
+{
+    // Data is only handed to readElectrodeData / readPackets once it has
+    // waited for NP_PARAM_INPUT_LATENCY_US, so short reads need a short latency
+    double latencyUs = 0.0;
+
+    for (auto probe : getProbes())
+    {
+        if (! probe->isEnabled || probe->basestation->type == BasestationType::SIMULATED)
+            continue;
+
+        const PollingScheduler::Settings& settings = probe->pollingSettings;
+
+        double probeLatencyUs = settings.targetLatencyUs;
+
+        if (settings.readBatchSuperFrames > 0)
+        {
+            const double batchUs = settings.readBatchSuperFrames * PollingScheduler::Settings::superFrameDurationUs;
+
+            probeLatencyUs = probeLatencyUs > 0.0 ? jmin (probeLatencyUs, batchUs) : batchUs;
+        }
+
+        if (probeLatencyUs > 0.0)
+            latencyUs = latencyUs > 0.0 ? jmin (latencyUs, probeLatencyUs) : probeLatencyUs;
+    }
+
+    // Leave the API default alone until a probe asks for something else
+    if (latencyUs <= 0.0 && defaultInputLatencyUs < 0)
+        return;
+
+    if (defaultInputLatencyUs < 0)
+    {
+        if (Neuropixels::getParameter (Neuropixels::NP_PARAM_INPUT_LATENCY_US, &defaultInputLatencyUs) != Neuropixels::SUCCESS)
+            defaultInputLatencyUs = int (64 * PollingScheduler::Settings::superFrameDurationUs);
+    }
+
+    const int inputLatencyUs = latencyUs > 0.0 ? jmax (1, int (latencyUs)) : defaultInputLatencyUs;
+
+    Neuropixels::NP_ErrorCode errorCode = Neuropixels::setParameter (Neuropixels::NP_PARAM_INPUT_LATENCY_US, inputLatencyUs);
+
+    if (errorCode == Neuropixels::SUCCESS)
+        LOGC ("Set Neuropixels API input latency to ", inputLatencyUs, " us");
+    else
+        LOGC ("Failed to set Neuropixels API input latency, error code: ", errorCode);
+}
+
 void NeuropixThread::setDirectoryForSlot (int slotIndex, File directory)
 {
     LOGD ("Thread setting directory for slot ", slotIndex, " to ", directory.getFileName());
@@ -1001,8 +1195,14 @@ bool NeuropixThread::stopAcquisition()
     for (int i = 0; i < basestations.size(); i++)
     {
         basestations[i]->stopAcquisition();
+
+        if (basestations[i]->clock.getNumObservations() > 0)
+            LOGC ("Slot ", basestations[i]->slot, " clock: ", basestations[i]->clock.getSummary());
     }
 
+    packetLossReporter->stop();
+    syncAligner->stop();
+
     return true;
 }
 
@@ -1014,13 +1214,22 @@ void NeuropixThread::updateSettings (OwnedArray<ContinuousChannel>* continuousCh
                                      OwnedArray<ConfigurationObject>* configurationObjects)
 {
     bool checkStreamNames = true;
+    int numCreated = 0;
 
-    if (sourceStreams.size() == 0) // initialize data streams
+    // Create the streams that updateStreamInfo() did not keep (all of them, initially)
     {
         String lastName;
 
-        for (auto info : streamInfo)
+        for (int i = 0; i < streamInfo.size(); i++)
         {
+            const StreamInfo& info = streamInfo.getReference (i);
+
+            if (info.type == stream_type::AP_BAND || info.type == stream_type::QUAD_BASE)
+                lastName = generateProbeName (info.probe_index, info.probe->namingScheme);
+
+            if (sourceStreams[i] != nullptr)
+                continue;
+
             String streamName, description, identifier;
 
             if (info.type == stream_type::ADC)
@@ -1032,8 +1241,6 @@ void NeuropixThread::updateSettings (OwnedArray<ContinuousChannel>* continuousCh
 
             else if (info.type == stream_type::AP_BAND)
             {
-                lastName = generateProbeName (info.probe_index, info.probe->namingScheme);
-
                 if (info.probe->namingScheme != ProbeNameConfig::STREAM_INDICES)
                     streamName = lastName + "-AP";
                 else
@@ -1063,8 +1270,6 @@ void NeuropixThread::updateSettings (OwnedArray<ContinuousChannel>* continuousCh
 
             else if (info.type == stream_type::QUAD_BASE)
             {
-                lastName = generateProbeName (info.probe_index, info.probe->namingScheme);
-
                 if (info.probe->namingScheme != ProbeNameConfig::STREAM_INDICES)
                     streamName = lastName + "-" + String (info.shank + 1);
                 else
@@ -1083,10 +1288,16 @@ void NeuropixThread::updateSettings (OwnedArray<ContinuousChannel>* continuousCh
 
             };
 
-            sourceStreams.add (new DataStream (settings));
+            if (i < sourceStreams.size())
+                sourceStreams.set (i, new DataStream (settings));
+            else
+                sourceStreams.add (new DataStream (settings));
 
-            checkStreamNames = false;
+            numCreated++;
         }
+
+        // Names of existing streams may have shifted
+        checkStreamNames = numCreated < streamInfo.size();
     }
 
     dataStreams->clear();
@@ -1488,7 +1699,24 @@ String NeuropixThread::handleConfigMessage (const String& msg)
     // NP GAIN <bs> <port> <dock> <AP/LFP> <gainval>
     // NP REFERENCE <bs> <port> <dock> <EXT/TIP>
     // NP FILTER <bs> <port> <dock> <ON/OFF>
+    // NP LATENCY <bs> <port> <dock> <target latency in us, 0 = full batches> [<min packets per read>]
+    // NP BATCH <bs> <port> <dock> <max superframes (12 samples) per read, 0 = default>
+    // NP CAPTURE <bs> <port> <dock> <ON/OFF> [<ring file size in MB>]
+    // NP GAPFILL <bs> <port> <dock> <OFF/ADVANCE/ZERO/HOLD/NAN> [<max samples filled per gap>]
+    // NP OFFSETS <bs> <port> <dock> <OFF/ONCE/CONTINUOUS/RESET> [<time constant in s>]
+    // NP ACTIVITY <bs> <port> <dock> <ENVELOPE/FULL>
+    // NP ACTIVITY <bs> <port> <dock> NOISE <ROBUST/POOLED>
+    // NP REPLAY <bs> <speed relative to real time, MAX> [LOOP/ONCE]
     // NP INFO
+    // NP STATS
+    // NP SYNC [THRESHOLD <misalignment threshold in ms>]
+    // NP SYNC OFFSET <bs> <port> <dock> <samples> (simulated probes: delays the simulated sync input)
+    // NP BUFFERS [<max downstream stall in s> [<memory budget in MB, 0 = no limit>]]
+    // NP BENCHMARK [seconds per case]
+    // NP BENCHMARK THREADS [number of streams] [seconds per mode] (runs in the background)
+    // NP BENCHMARK PROBES <type>[x<count>],<type>[x<count>],... [seconds] [speed relative to real time, MAX] [CSV/JSON] [output file] (runs in the background)
+    // NP BENCHMARK RESULT (report of the last NP BENCHMARK THREADS or PROBES run)
+    // NP THREADS <bs> <number of worker threads, 0 = one per stream, AUTO> [<core>,<core>,...]
 
     LOGD ("Neuropix-PXI received ", msg);
 
@@ -1508,6 +1736,53 @@ String NeuropixThread::handleConfigMessage (const String& msg)
             {
                 return getProbeInfoString();
             }
+            else if (command.equalsIgnoreCase ("STATS"))
+            {
+                return PacketLossReporter::getStatsString (getProbes());
+            }
+            else if (command.equalsIgnoreCase ("SYNC"))
+            {
+                if (parts[2].equalsIgnoreCase ("THRESHOLD") && parts.size() > 3)
+                {
+                    syncAligner->setThresholdMs (jmax (0.0, parts[3].getDoubleValue()));
+                }
+                else if (parts[2].equalsIgnoreCase ("OFFSET"))
+                {
+                    if (parts.size() < 7)
+                        return "Incorrect number of argument for " + command + " OFFSET. Found " + String (parts.size()) + ", requires 7.";
+
+                    for (auto probe : getProbes())
+                    {
+                        if (probe->basestation->slot == parts[3].getIntValue() && probe->headstage->port == parts[4].getIntValue() && probe->dock == parts[5].getIntValue())
+                        {
+                            if (auto simulatedProbe = dynamic_cast<SimulatedProbe*> (probe))
+                            {
+                                simulatedProbe->setSyncOffset (parts[6].getIntValue());
+                                return "SUCCESS";
+                            }
+
+                            return "Sync offsets can only be injected into simulated probes.";
+                        }
+                    }
+
+                    return "No probe found in slot " + parts[3] + ", port " + parts[4] + ", dock " + parts[5] + ".";
+                }
+
+                return syncAligner->getTableString();
+            }
+            else if (command.equalsIgnoreCase ("BUFFERS") && parts.size() < 3)
+            {
+                return bufferBudget.getReportString();
+            }
+            else if (command.equalsIgnoreCase ("BENCHMARK") && parts.size() > 2 && parts[2].equalsIgnoreCase ("RESULT"))
+            {
+                if (benchmarkThread->isThreadRunning())
+                    return "RUNNING";
+
+                const String result = benchmarkThread->getResult();
+
+                return result.isNotEmpty() ? result : "No background benchmark has been run.";
+            }
             else
             {
                 if (CoreServices::getAcquisitionStatus())
@@ -1515,7 +1790,128 @@ String NeuropixThread::handleConfigMessage (const String& msg)
                     return "Neuropixels plugin cannot update settings while acquisition is active.";
                 }
 
-                if (command.equalsIgnoreCase ("SELECT") || command.equalsIgnoreCase ("GAIN") || command.equalsIgnoreCase ("REFERENCE") || command.equalsIgnoreCase ("FILTER"))
+                if (command.equalsIgnoreCase ("BENCHMARK"))
+                {
+                    if (parts[2].equalsIgnoreCase ("THREADS"))
+                    {
+                        int numStreams = parts.size() > 3 ? parts[3].getIntValue() : 32;
+                        double secondsPerMode = parts.size() > 4 ? parts[4].getDoubleValue() : 2.0;
+
+                        numStreams = jlimit (1, 128, numStreams);
+                        secondsPerMode = jlimit (0.5, 30.0, secondsPerMode);
+
+                        if (! benchmarkThread->start ([=]
+                                                      { return AcquisitionBenchmark::runThreading (numStreams, secondsPerMode); }))
+                            return "A benchmark is already running.";
+
+                        return "STARTED";
+                    }
+
+                    if (parts[2].equalsIgnoreCase ("PROBES"))
+                    {
+                        if (parts.size() < 4)
+                            return "Incorrect number of argument for " + command + " PROBES. Found " + String (parts.size()) + ", requires 4.";
+
+                        StringArray probeTypes = StringArray::fromTokens (parts[3], ",", "");
+                        double seconds = parts.size() > 4 ? parts[4].getDoubleValue() : 5.0;
+                        double speed = parts.size() > 5 ? (parts[5].equalsIgnoreCase ("MAX") ? 0.0 : jmax (0.0, parts[5].getDoubleValue())) : 1.0;
+                        bool asJson = parts.size() > 6 && parts[6].equalsIgnoreCase ("JSON");
+                        File outputFile = parts.size() > 7 ? File::getCurrentWorkingDirectory().getChildFile (parts.joinIntoString (" ", 7)) : File();
+
+                        seconds = jlimit (0.5, 120.0, seconds);
+
+                        if (! benchmarkThread->start ([=]
+                                                      { return AcquisitionBenchmark::runProbes (probeTypes, seconds, speed, asJson, outputFile); }))
+                            return "A benchmark is already running.";
+
+                        return "STARTED";
+                    }
+
+                    double secondsPerCase = parts.size() > 2 ? parts[2].getDoubleValue() : 0.5;
+
+                    return AcquisitionBenchmark::run (jlimit (0.1, 10.0, secondsPerCase));
+                }
+
+                if (command.equalsIgnoreCase ("BUFFERS"))
+                {
+                    bufferBudget.settings.maxStallSeconds = jmax (0.0, parts[2].getDoubleValue());
+
+                    if (parts.size() > 3)
+                        bufferBudget.settings.budgetMegabytes = jmax (int64 (0), parts[3].getLargeIntValue());
+
+                    updateStreamInfo (true);
+                    CoreServices::updateSignalChain (editor);
+
+                    return bufferBudget.getReportString();
+                }
+
+                if (command.equalsIgnoreCase ("THREADS"))
+                {
+                    if (parts.size() < 4)
+                        return "Incorrect number of argument for " + command + ". Found " + String (parts.size()) + ", requires 4.";
+
+                    int slot = parts[2].getIntValue();
+
+                    for (auto basestation : basestations)
+                    {
+                        if (basestation->slot == slot)
+                        {
+                            AcquisitionPool::Settings& settings = basestation->acquisitionPool.settings;
+
+                            Array<int> cpuCores;
+
+                            if (parts.size() > 4)
+                            {
+                                for (auto core : StringArray::fromTokens (parts[4], ",", ""))
+                                {
+                                    if (! isPositiveAndBelow (core.getIntValue(), SystemStats::getNumCpus()))
+                                        return "Core " + core + " is out of range (this computer has " + String (SystemStats::getNumCpus()) + " cores).";
+
+                                    cpuCores.add (core.getIntValue());
+                                }
+                            }
+
+                            if (parts[3].equalsIgnoreCase ("AUTO"))
+                                settings.numWorkers = -1;
+                            else
+                                settings.numWorkers = jmax (0, parts[3].getIntValue());
+
+                            settings.cpuCores = cpuCores;
+
+                            return "SUCCESS";
+                        }
+                    }
+
+                    return "No basestation found in slot " + String (slot) + ".";
+                }
+
+                if (command.equalsIgnoreCase ("REPLAY"))
+                {
+                    if (parts.size() < 4)
+                        return "Incorrect number of argument for " + command + ". Found " + String (parts.size()) + ", requires 4.";
+
+                    int slot = parts[2].getIntValue();
+
+                    for (auto basestation : basestations)
+                    {
+                        if (auto replayBasestation = dynamic_cast<ReplayBasestation*> (basestation))
+                        {
+                            if (replayBasestation->slot == slot)
+                            {
+                                double speed = parts[3].equalsIgnoreCase ("MAX") ? 0.0 : jmax (0.0, parts[3].getDoubleValue());
+                                bool loop = ! (parts.size() > 4 && parts[4].equalsIgnoreCase ("ONCE"));
+
+                                replayBasestation->setReplaySpeed (speed, loop);
+
+                                return "SUCCESS";
+                            }
+                        }
+                    }
+
+                    return "No replay basestation found in slot " + String (slot) + ".";
+                }
+
+                if (command.equalsIgnoreCase ("SELECT") || command.equalsIgnoreCase ("GAIN") || command.equalsIgnoreCase ("REFERENCE") || command.equalsIgnoreCase ("FILTER") || command.equalsIgnoreCase ("LATENCY") || command.equalsIgnoreCase ("BATCH") || command.equalsIgnoreCase ("CAPTURE") || command.equalsIgnoreCase ("GAPFILL") || command.equalsIgnoreCase ("OFFSETS") || command.equalsIgnoreCase ("ACTIVITY"))
                 {
                     if (parts.size() > 5)
                     {
@@ -1581,6 +1977,63 @@ String NeuropixThread::handleConfigMessage (const String& msg)
                                         probe->ui->setApFilterState (parts[5].equalsIgnoreCase ("ON"));
                                     }
                                 }
+                                else if (command.equalsIgnoreCase ("LATENCY"))
+                                {
+                                    probe->pollingSettings.targetLatencyUs = jmax (0.0, parts[5].getDoubleValue());
+
+                                    if (parts.size() > 6)
+                                        probe->pollingSettings.minBatchPackets = jmax (1, parts[6].getIntValue());
+                                }
+                                else if (command.equalsIgnoreCase ("BATCH"))
+                                {
+                                    probe->ui->setReadBatchSize (parts[5].getIntValue());
+                                }
+                                else if (command.equalsIgnoreCase ("CAPTURE"))
+                                {
+                                    probe->captureSettings.enabled = parts[5].equalsIgnoreCase ("ON");
+
+                                    if (parts.size() > 6)
+                                        probe->captureSettings.sizeMegabytes = jmax (1, parts[6].getIntValue());
+                                }
+                                else if (command.equalsIgnoreCase ("GAPFILL"))
+                                {
+                                    if (! GapFiller::parseMode (parts[5], probe->gapFillSettings.mode))
+                                        return "Unknown gap fill mode " + parts[5] + ", expected OFF, ADVANCE, ZERO, HOLD or NAN.";
+
+                                    if (parts.size() > 6)
+                                        probe->gapFillSettings.maxFillSamples = jmax (0, parts[6].getIntValue());
+                                }
+                                else if (command.equalsIgnoreCase ("OFFSETS"))
+                                {
+                                    if (parts[5].equalsIgnoreCase ("RESET"))
+                                        probe->resetOffsets();
+                                    else if (! OffsetTracker::parseMode (parts[5], probe->offsetSettings.mode))
+                                        return "Unknown offset mode " + parts[5] + ", expected OFF, ONCE, CONTINUOUS or RESET.";
+
+                                    if (parts.size() > 6)
+                                        probe->offsetSettings.timeConstantSeconds = jmax (0.01f, parts[6].getFloatValue());
+                                }
+                                else if (command.equalsIgnoreCase ("ACTIVITY"))
+                                {
+                                    if (parts[5].equalsIgnoreCase ("NOISE"))
+                                    {
+                                        if (parts.size() > 6 && parts[6].equalsIgnoreCase ("ROBUST"))
+                                            probe->setActivityRobustNoiseEnabled (true);
+                                        else if (parts.size() > 6 && parts[6].equalsIgnoreCase ("POOLED"))
+                                            probe->setActivityRobustNoiseEnabled (false);
+                                        else
+                                            return "Expected ROBUST or POOLED after " + command + " NOISE.";
+                                    }
+                                    else
+                                    {
+                                        ActivityView::Ingestion ingestion;
+
+                                        if (! ActivityView::parseIngestion (parts[5], ingestion))
+                                            return "Unknown activity view mode " + parts[5] + ", expected ENVELOPE, FULL or NOISE.";
+
+                                        probe->setActivityIngestion (ingestion);
+                                    }
+                                }
                                 else if (command.equalsIgnoreCase ("SELECT"))
                                 {
                                     Array<int> electrodes;
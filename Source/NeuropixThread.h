@@ -29,6 +29,7 @@
 #include <string.h>
 
 #include "NeuropixComponents.h"
+#include "Probes/BufferBudget.h"
 
 #define PLUGIN_VERSION "2.1.1"
 
@@ -61,8 +62,14 @@ struct StreamInfo
     stream_type type;
     int shank = -1;
     bool sendSyncAsContinuousChannel;
-    Probe* probe;
-    OneBoxADC* adc;
+    Probe* probe = nullptr;
+    OneBoxADC* adc = nullptr;
+
+    /** Returns true if both describe the same stream of the same source */
+    bool isSameStream (const StreamInfo& other) const
+    {
+        return probe == other.probe && adc == other.adc && type == other.type && shank == other.shank;
+    }
 };
 
 /** 
@@ -70,6 +77,8 @@ struct StreamInfo
 	Shows a progress window while searching for probes.
 
 */
+class BenchmarkThread;
+
 class Initializer : public ThreadWithProgressWindow
 {
 public:
@@ -279,6 +288,22 @@ private:
 
     void closeConnection();
 
+    /** Matches the API input latency to the shortest read batch or latency target of any enabled probe */
+    void updateInputLatency();
+
+    /** Returns the index of the entry in infos that describes the same stream as info, or -1 */
+    static int findStream (const Array<StreamInfo>& infos, const StreamInfo& info);
+
+    /** Sets the DataBuffer of every stream in streamInfo, sized by bufferBudget; buffers of
+        unchanged streams are taken from previousBuffers, the others are allocated */
+    void createSourceBuffers (const Array<StreamInfo>& previousInfo, OwnedArray<DataBuffer>& previousBuffers);
+
+    /** Sizes of the source buffers, within the configured stall time and memory budget */
+    BufferBudget bufferBudget;
+
+    /** API input latency before updateInputLatency() first changed it (-1 = unchanged) */
+    int defaultInputLatencyUs = -1;
+
     Array<int> defaultSyncFrequencies;
 
     Array<StreamInfo> streamInfo;
@@ -297,6 +322,15 @@ private:
 
     std::unique_ptr<Initializer> initializer;
 
+    /** Summarizes timestamp jumps during acquisition (declared after basestations, so it stops first) */
+    std::unique_ptr<PacketLossReporter> packetLossReporter;
+
+    /** Matches sync edges across probes during acquisition */
+    std::unique_ptr<SyncAligner> syncAligner;
+
+    /** Runs "NP BENCHMARK THREADS" and "NP BENCHMARK PROBES" in the background */
+    std::unique_ptr<BenchmarkThread> benchmarkThread;
+
     NeuropixAPIv3 api_v3;
 
     NeuropixEditor* editor; 
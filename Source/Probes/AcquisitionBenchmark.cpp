@@ -0,0 +1,1041 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "AcquisitionBenchmark.h"
+#include "AcquisitionEngine.h"
+
+#include "../UI/BiquadBank.h"
+#include "../UI/SpikeDetector.h"
+
+#include <DspLib.h>
+#include <functional>
+#include <map>
+
+#if ! JUCE_WINDOWS
+#include <sys/resource.h>
+#include <time.h>
+#endif
+
+// Samples held by each benchmark DataBuffer (1 s at 30 kHz)
+#define BENCHMARK_BUFFER_SAMPLES 30000
+
+// How often the benchmark empties the DataBuffers, like the GUI's processing thread
+#define BENCHMARK_DRAIN_INTERVAL_MS 10
+
+/** Sample counters and output arrays used by the original acquisition loops */
+struct LegacyState
+{
+    LegacyState (int numChannels, int samplesPerBatch, int maxPackets)
+        : apSamples ((size_t) (numChannels + 1) * samplesPerBatch),
+          lfpSamples ((size_t) (numChannels + 1) * maxPackets),
+          apTimestamps (samplesPerBatch),
+          eventCodes (samplesPerBatch),
+          lfpTimestamps (maxPackets),
+          lfpEventCodes (maxPackets)
+    {
+        for (int j = 0; j < 384; j++)
+        {
+            apOffsets[j][0] = 0;
+            lfpOffsets[j][0] = 0;
+        }
+
+        availableApGains.add (500.0f);
+        availableLfpGains.add (250.0f);
+    }
+
+    std::vector<float> apSamples;
+    std::vector<float> lfpSamples;
+    std::vector<int64> apTimestamps;
+    std::vector<uint64> eventCodes;
+    std::vector<int64> lfpTimestamps;
+    std::vector<uint64> lfpEventCodes;
+
+    float apOffsets[384][100];
+    float lfpOffsets[384][100];
+
+    Array<float> availableApGains;
+    Array<float> availableLfpGains;
+    int apGainIndex = 0;
+    int lfpGainIndex = 0;
+
+    int64 apTimestamp = 0;
+    int64 lfpTimestamp = 0;
+    uint32_t lastNpxTimestamp = 0;
+    bool passedOneSecond = true;
+    bool sendSync = true;
+    bool invertSyncLine = false;
+    uint64 eventCode = 0;
+};
+
+/** The per-sample loop used by the NP1-family probes before AcquisitionEngine */
+static void runLegacyElectrodePacketLoop (const Neuropixels::electrodePacket* packet,
+                                          int count,
+                                          int numChannels,
+                                          LegacyState& s)
+{
+    for (int packetNum = 0; packetNum < count; packetNum++)
+    {
+        for (int i = 0; i < 12; i++)
+        {
+            s.eventCode = packet[packetNum].Status[i] >> 6;
+
+            if (s.invertSyncLine)
+                s.eventCode = ~s.eventCode;
+
+            uint32_t npx_timestamp = packet[packetNum].timestamp[i];
+
+            uint32_t timestamp_jump = npx_timestamp - s.lastNpxTimestamp;
+
+            if (timestamp_jump > MAX_ALLOWABLE_TIMESTAMP_JUMP)
+            {
+                if (s.passedOneSecond && timestamp_jump < MAX_HEADSTAGE_CLK_SAMPLE)
+                    LOGC ("NPX TIMESTAMP JUMP: ", timestamp_jump);
+            }
+
+            s.lastNpxTimestamp = npx_timestamp;
+
+            for (int j = 0; j < numChannels; j++)
+            {
+                s.apSamples[j * (12 * count) + i + (packetNum * 12)] =
+                    float (packet[packetNum].apData[i][j]) * 1.2f / 1024.0f * 1000000.0f
+                        / s.availableApGains[s.apGainIndex]
+                    - s.apOffsets[j][0];
+
+                if (i == 0)
+                {
+                    s.lfpSamples[(j * count) + packetNum] =
+                        float (packet[packetNum].lfpData[j]) * 1.2f / 1024.0f * 1000000.0f
+                            / s.availableLfpGains[s.lfpGainIndex]
+                        - s.lfpOffsets[j][0];
+                }
+            }
+
+            s.apTimestamps[i + packetNum * 12] = s.apTimestamp++;
+            s.eventCodes[i + packetNum * 12] = s.eventCode;
+
+            if (s.sendSync)
+                s.apSamples[numChannels * (12 * count) + i + (packetNum * 12)] = (float) s.eventCode;
+        }
+
+        s.lfpTimestamps[packetNum] = s.lfpTimestamp++;
+        s.lfpEventCodes[packetNum] = s.eventCode;
+
+        if (s.sendSync)
+            s.lfpSamples[(numChannels * count) + packetNum] = (float) s.eventCode;
+    }
+}
+
+/** The per-sample loop used by NP2.0 and Quad Base probes before AcquisitionEngine */
+static void runLegacyPacketInfoLoop (const Neuropixels::PacketInfo* packetInfo,
+                                     const int16_t* data,
+                                     int count,
+                                     LegacyState& s)
+{
+    const float bitScaling = 4096.0f;
+    const float amplifierGain = 80.0f;
+
+    for (int packetNum = 0; packetNum < count; packetNum++)
+    {
+        s.eventCode = packetInfo[packetNum].Status >> 6;
+
+        if (s.invertSyncLine)
+            s.eventCode = ~s.eventCode;
+
+        uint32_t npx_timestamp = packetInfo[packetNum].Timestamp;
+
+        uint32_t timestamp_jump = npx_timestamp - s.lastNpxTimestamp;
+
+        if (timestamp_jump > MAX_ALLOWABLE_TIMESTAMP_JUMP)
+        {
+            if (s.passedOneSecond && timestamp_jump < MAX_HEADSTAGE_CLK_SAMPLE)
+                LOGC ("NPX TIMESTAMP JUMP: ", timestamp_jump);
+        }
+
+        s.lastNpxTimestamp = npx_timestamp;
+
+        for (int j = 0; j < 384; j++)
+        {
+            s.apSamples[j * count + packetNum] =
+                float (data[packetNum * 384 + j]) / bitScaling / amplifierGain * 1000000.0f;
+        }
+
+        s.apTimestamps[packetNum] = s.apTimestamp++;
+        s.eventCodes[packetNum] = s.eventCode;
+
+        if (s.sendSync)
+            s.apSamples[(384 * count) + packetNum] = (float) s.eventCode;
+    }
+}
+
+/** Generates a slowly varying test signal in the range of real AP data */
+static int16_t getSyntheticSample (int64 sampleNumber, int channel)
+{
+    return (int16_t) (((sampleNumber * 7 + channel * 13) % 200) - 100);
+}
+
+/** Sync line toggles once per second, as with a typical 1 Hz sync pulse */
+static uint16_t getSyntheticStatus (int64 sampleNumber)
+{
+    return ((sampleNumber / 30000) % 2) ? ELECTRODEPACKET_STATUS_SYNC : 0;
+}
+
+/** Fills count packets, numbered from firstPacket */
+static void fillElectrodePackets (Neuropixels::electrodePacket* packets, int count, int numChannels, int64 firstPacket = 0)
+{
+    int64 sampleNumber = firstPacket * 12;
+
+    for (int packetNum = 0; packetNum < count; packetNum++)
+    {
+        for (int i = 0; i < 12; i++)
+        {
+            packets[packetNum].timestamp[i] = (uint32_t) (sampleNumber * 10 / 3);
+            packets[packetNum].Status[i] = getSyntheticStatus (sampleNumber);
+
+            for (int j = 0; j < numChannels; j++)
+                packets[packetNum].apData[i][j] = getSyntheticSample (sampleNumber, j);
+
+            sampleNumber++;
+        }
+
+        for (int j = 0; j < numChannels; j++)
+            packets[packetNum].lfpData[j] = getSyntheticSample (firstPacket + packetNum, j);
+    }
+}
+
+/** Fills count packets, numbered from firstPacket */
+static void fillPacketInfo (Neuropixels::PacketInfo* packetInfo, int16_t* data, int count, int64 firstPacket = 0)
+{
+    for (int packetNum = 0; packetNum < count; packetNum++)
+    {
+        const int64 sampleNumber = firstPacket + packetNum;
+
+        packetInfo[packetNum].Timestamp = (uint32_t) (sampleNumber * 10 / 3);
+        packetInfo[packetNum].Status = getSyntheticStatus (sampleNumber);
+        packetInfo[packetNum].payloadlength = 384;
+
+        for (int j = 0; j < 384; j++)
+            data[packetNum * 384 + j] = getSyntheticSample (sampleNumber, j);
+    }
+}
+
+/** Calls processBatch repeatedly for about `seconds`, and returns samples per second */
+static double measure (const std::function<void()>& processBatch, int samplesPerBatch, double seconds)
+{
+    processBatch(); // warm up caches
+
+    int64 samples = 0;
+    const int64 start = Time::getHighResolutionTicks();
+    const int64 end = start + Time::secondsToHighResolutionTicks (seconds);
+    int64 now = start;
+
+    while (now < end)
+    {
+        processBatch();
+        samples += samplesPerBatch;
+        now = Time::getHighResolutionTicks();
+    }
+
+    return double (samples) / Time::highResolutionTicksToSeconds (now - start);
+}
+
+static String formatResult (const String& name, double legacyRate, double engineRate)
+{
+    return name + ": legacy " + String (legacyRate / 1e6, 2) + " MS/s (" + String (int (legacyRate / 30000.0)) + "x real time), "
+           + "engine " + String (engineRate / 1e6, 2) + " MS/s (" + String (int (engineRate / 30000.0)) + "x real time), "
+           + "speedup " + String (engineRate / legacyRate, 2) + "x\n";
+}
+
+template <class Traits>
+static String benchmarkElectrodePackets (const String& name, double seconds)
+{
+    PacketDecoder::ChannelScaling apScaling;
+    PacketDecoder::ChannelScaling lfpScaling;
+    apScaling.setScale (Traits::numChannels, 1.2f / 1024.0f * 1000000.0f / 500.0f);
+    lfpScaling.setScale (Traits::numChannels, 1.2f / 1024.0f * 1000000.0f / 250.0f);
+
+    AcquisitionEngine<Traits> engine (nullptr, apScaling, lfpScaling);
+    engine.reset (true, false);
+
+    fillElectrodePackets (engine.getElectrodePackets(), Traits::maxPackets, Traits::numChannels);
+
+    auto state = std::make_unique<LegacyState> (Traits::numChannels, AcquisitionEngine<Traits>::defaultSamplesPerBatch, Traits::maxPackets);
+
+    const double legacyRate = measure ([&]
+                                       { runLegacyElectrodePacketLoop (engine.getElectrodePackets(), Traits::maxPackets, Traits::numChannels, *state); },
+                                       AcquisitionEngine<Traits>::defaultSamplesPerBatch,
+                                       seconds);
+
+    const double engineRate = measure ([&]
+                                       { engine.process (Traits::maxPackets); },
+                                       AcquisitionEngine<Traits>::defaultSamplesPerBatch,
+                                       seconds);
+
+    return formatResult (name, legacyRate, engineRate);
+}
+
+template <class Traits>
+static String benchmarkPacketInfo (const String& name, double seconds)
+{
+    PacketDecoder::ChannelScaling apScaling;
+    apScaling.setScale (Traits::numChannels, 1000000.0f / 4096.0f / 80.0f);
+
+    AcquisitionEngine<Traits> engine (nullptr, apScaling, apScaling);
+    engine.reset (true, false);
+
+    fillPacketInfo (engine.getPacketInfo(), engine.getPacketData(), Traits::maxPackets);
+
+    auto state = std::make_unique<LegacyState> (Traits::numChannels, AcquisitionEngine<Traits>::defaultSamplesPerBatch, Traits::maxPackets);
+
+    const double legacyRate = measure ([&]
+                                       { runLegacyPacketInfoLoop (engine.getPacketInfo(), engine.getPacketData(), Traits::maxPackets, *state); },
+                                       AcquisitionEngine<Traits>::defaultSamplesPerBatch,
+                                       seconds);
+
+    const double engineRate = measure ([&]
+                                       { engine.process (Traits::maxPackets); },
+                                       AcquisitionEngine<Traits>::defaultSamplesPerBatch,
+                                       seconds);
+
+    return formatResult (name, legacyRate, engineRate);
+}
+
+/** Compares the activity view band-pass with one Dsp filter per channel and a BiquadBank,
+    including the peak-to-peak search (1536 channels, as for a Quad Base probe) */
+static String benchmarkActivityFilter (double seconds)
+{
+    const int numChannels = 1536;
+    const int samplesPerBatch = 3000;
+
+    AudioBuffer<float> buffer (numChannels, samplesPerBatch);
+
+    for (int ch = 0; ch < numChannels; ch++)
+        for (int i = 0; i < samplesPerBatch; i++)
+            buffer.setSample (ch, i, float (getSyntheticSample (i, ch)));
+
+    OwnedArray<Dsp::Filter> filters;
+
+    for (int ch = 0; ch < numChannels; ch++)
+    {
+        filters.add (new Dsp::SmoothedFilterDesign<Dsp::Butterworth::Design::BandPass<2>, 1, Dsp::DirectFormII> (1));
+
+        Dsp::Params params;
+        params[0] = 30000.0; // sample rate
+        params[1] = 2; // order
+        params[2] = 3150.0; // center frequency
+        params[3] = 5700.0; // bandwidth
+
+        filters.getLast()->setParams (params);
+    }
+
+    float amplitude = 0.0f;
+
+    const double filterRate = measure ([&]
+                                       {
+                                           for (int ch = 0; ch < numChannels; ch++)
+                                           {
+                                               float* data = buffer.getWritePointer (ch);
+                                               filters[ch]->process (samplesPerBatch, &data);
+                                               amplitude += buffer.findMinMax (ch, 0, samplesPerBatch).getLength();
+                                           }
+                                       },
+                                       samplesPerBatch,
+                                       seconds);
+
+    BiquadBank bank;
+    bank.setBandPass (numChannels, 30000.0, 3150.0, 5700.0);
+
+    std::vector<float> minValues (numChannels);
+    std::vector<float> maxValues (numChannels);
+    std::vector<float> sums (numChannels);
+    std::vector<float> sumSquares (numChannels);
+
+    const double bankRate = measure ([&]
+                                     {
+                                         bank.process (buffer.getArrayOfWritePointers(), samplesPerBatch, minValues.data(), maxValues.data(), sums.data(), sumSquares.data());
+                                         amplitude += maxValues[0] - minValues[0];
+                                     },
+                                     samplesPerBatch,
+                                     seconds);
+
+    SpikeDetector detector;
+    detector.prepare (numChannels, 30000.0f);
+
+    std::vector<uint32_t> crossings (numChannels);
+
+    const double detectorRate = measure ([&]
+                                         {
+                                             bank.process (buffer.getArrayOfWritePointers(), samplesPerBatch, minValues.data(), maxValues.data(), sums.data(), sumSquares.data());
+                                             detector.process (buffer.getArrayOfReadPointers(), samplesPerBatch, crossings.data());
+                                         },
+                                         samplesPerBatch,
+                                         seconds);
+
+    ignoreUnused (amplitude);
+
+    return "Activity band-pass (1536 channels): per-channel filters " + String (filterRate / 1e3, 1) + " kS/s, "
+           + "biquad bank (" + BiquadBank::getInstructionSetName() + ") " + String (bankRate / 1e3, 1) + " kS/s, "
+           + "speedup " + String (bankRate / filterRate, 2) + "x; "
+           + "with spike detection " + String (detectorRate / 1e3, 1) + " kS/s\n";
+}
+
+/** An NP1 stream fed by a SimulatedFifo (as in SimulatedProbe) and decoded by AcquisitionEngine */
+class SimulatedStream : public AcquisitionTask
+{
+public:
+    SimulatedStream()
+    {
+        scaling.setScale (NP1Traits::numChannels, 1.2f / 1024.0f * 1000000.0f / 500.0f);
+
+        engine.reset (true, false);
+
+        fillElectrodePackets (engine.getElectrodePackets(), NP1Traits::maxPackets, NP1Traits::numChannels);
+    }
+
+    void prepareToPoll() override
+    {
+        scheduler.prepare (PollingScheduler::Settings(), NP1Traits::packetIntervalUs, NP1Traits::maxPackets);
+        fifo.start (NP1Traits::packetIntervalUs, 4096, Time::getHighResolutionTicks());
+    }
+
+    double poll() override
+    {
+        const int64 readTicks = Time::getHighResolutionTicks();
+        const int count = fifo.read (NP1Traits::maxPackets, readTicks);
+
+        scheduler.packetsRead (count, NP1Traits::maxPackets, readTicks);
+
+        if (count > 0)
+            engine.process (count);
+
+        numPackets += count;
+
+        const int64 now = Time::getHighResolutionTicks();
+
+        if (scheduler.shouldQueryFifo (now))
+            scheduler.fifoStatusRead (fifo.getPacketsAvailable (now), fifo.getHeadroom (now), now);
+
+        return scheduler.getTimeUntilNextRead (Time::getHighResolutionTicks());
+    }
+
+    /** Acquires on the calling thread, as a probe does without a pool */
+    void run (Thread& thread)
+    {
+        prepareToPoll();
+
+        while (! thread.threadShouldExit())
+        {
+            poll();
+
+            scheduler.waitForNextRead (thread);
+        }
+    }
+
+    int64 getNumPackets() const { return numPackets; }
+    int64 getNumLostPackets() const { return fifo.getNumOverflowedPackets(); }
+
+private:
+    PacketDecoder::ChannelScaling scaling;
+    AcquisitionEngine<NP1Traits> engine { nullptr, scaling, scaling };
+
+    SimulatedFifo fifo;
+    PollingScheduler scheduler;
+
+    std::atomic<int64> numPackets { 0 };
+};
+
+class SimulatedStreamThread : public Thread
+{
+public:
+    SimulatedStreamThread (SimulatedStream& stream_) : Thread ("Simulated stream"),
+                                                       stream (stream_)
+    {
+    }
+
+    void run() override { stream.run (*this); }
+
+private:
+    SimulatedStream& stream;
+};
+
+/** Context switches and CPU time of the whole process (not available on Windows) */
+struct ProcessUsage
+{
+    int64 contextSwitches = -1;
+    double cpuSeconds = -1.0;
+};
+
+static ProcessUsage getProcessUsage()
+{
+    ProcessUsage usage;
+
+#if ! JUCE_WINDOWS
+    struct rusage r;
+
+    if (getrusage (RUSAGE_SELF, &r) == 0)
+    {
+        usage.contextSwitches = int64 (r.ru_nvcsw + r.ru_nivcsw);
+        usage.cpuSeconds = double (r.ru_utime.tv_sec + r.ru_stime.tv_sec)
+                           + double (r.ru_utime.tv_usec + r.ru_stime.tv_usec) * 1e-6;
+    }
+#endif
+
+    return usage;
+}
+
+/** Sleeps for `seconds`, returning early if the calling thread is asked to exit */
+static void sleepUnlessStopped (double seconds)
+{
+    const int64 end = Time::getHighResolutionTicks() + Time::secondsToHighResolutionTicks (seconds);
+
+    while (Time::getHighResolutionTicks() < end && ! Thread::currentThreadShouldExit())
+        Thread::sleep (BENCHMARK_DRAIN_INTERVAL_MS);
+}
+
+/** Acquires from numStreams streams, with one thread each (numWorkers = 0) or with an AcquisitionPool */
+static String benchmarkThreading (const String& name, int numStreams, int numWorkers, double seconds)
+{
+    OwnedArray<SimulatedStream> streams;
+
+    for (int i = 0; i < numStreams; i++)
+        streams.add (new SimulatedStream());
+
+    const ProcessUsage before = getProcessUsage();
+    const int64 start = Time::getHighResolutionTicks();
+
+    int numThreads;
+
+    if (numWorkers == 0)
+    {
+        OwnedArray<SimulatedStreamThread> threads;
+
+        for (auto stream : streams)
+            threads.add (new SimulatedStreamThread (*stream));
+
+        for (auto thread : threads)
+            thread->startThread();
+
+        numThreads = threads.size();
+
+        sleepUnlessStopped (seconds);
+
+        for (auto thread : threads)
+            thread->signalThreadShouldExit();
+
+        for (auto thread : threads)
+            thread->stopThread (1000);
+    }
+    else
+    {
+        AcquisitionPool pool ("Benchmark");
+        pool.settings.numWorkers = numWorkers;
+
+        Array<AcquisitionTask*> tasks;
+
+        for (auto stream : streams)
+            tasks.add (stream);
+
+        pool.addTasks (tasks);
+        pool.start();
+
+        numThreads = pool.getNumWorkers();
+
+        sleepUnlessStopped (seconds);
+
+        pool.stop();
+    }
+
+    const double elapsedSeconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - start);
+    const ProcessUsage after = getProcessUsage();
+
+    int64 numPackets = 0;
+    int64 numLostPackets = 0;
+
+    for (auto stream : streams)
+    {
+        numPackets += stream->getNumPackets();
+        numLostPackets += stream->getNumLostPackets();
+    }
+
+    const double expectedPackets = elapsedSeconds * 1.0e6 / NP1Traits::packetIntervalUs * numStreams;
+
+    String result = name + ": " + String (numThreads) + " threads, ";
+
+    if (before.contextSwitches >= 0)
+    {
+        result += String (after.contextSwitches - before.contextSwitches) + " context switches, "
+                  + String (100.0 * (after.cpuSeconds - before.cpuSeconds) / elapsedSeconds, 1) + "% CPU, ";
+    }
+
+    return result + "throughput " + String (100.0 * numPackets / expectedPackets, 1) + "% of real time, "
+           + String (numLostPackets) + " packets lost\n";
+}
+
+/** Writes one second of synthetic packets in the format read by AcquisitionEngine<Traits> */
+template <class Traits>
+static bool writeSyntheticCapture (const File& file)
+{
+    const PacketCapture::Layout layout = AcquisitionEngine<Traits>::getCaptureLayout();
+    const int numRecords = int (1.0e6 / Traits::packetIntervalUs);
+    const int recordsPerWrite = 1024;
+
+    PacketCapture::FileHeader stream {};
+    String ("Synthetic").copyToUTF8 (stream.partNumber, sizeof (stream.partNumber));
+
+    PacketCapture capture (layout);
+
+    if (! capture.open (file, int64 (PacketCapture::dataOffset) + int64 (numRecords) * (layout.headerBytes + layout.payloadBytes), stream))
+        return false;
+
+    std::vector<Neuropixels::electrodePacket> packets;
+    std::vector<Neuropixels::PacketInfo> packetInfo;
+    std::vector<int16_t> packetData;
+
+    if constexpr (Traits::format == PacketFormat::ELECTRODE_PACKETS)
+    {
+        packets.resize (recordsPerWrite);
+    }
+    else
+    {
+        packetInfo.resize (recordsPerWrite);
+        packetData.resize ((size_t) recordsPerWrite * Traits::numChannels);
+    }
+
+    for (int first = 0; first < numRecords; first += recordsPerWrite)
+    {
+        const int count = jmin (recordsPerWrite, numRecords - first);
+
+        if constexpr (Traits::format == PacketFormat::ELECTRODE_PACKETS)
+        {
+            fillElectrodePackets (packets.data(), count, Traits::numChannels, first);
+            capture.write (packets.data(), nullptr, count);
+        }
+        else
+        {
+            fillPacketInfo (packetInfo.data(), packetData.data(), count, first);
+            capture.write (packetInfo.data(), packetData.data(), count);
+        }
+
+        // Move each chunk to the file before the staging FIFO fills up
+        capture.flush();
+    }
+
+    return capture.getNumRecordsDropped() == 0;
+}
+
+/** Thread CPU time of the calling thread (not available on Windows) */
+static double getThreadCpuSeconds()
+{
+#if ! JUCE_WINDOWS
+    struct timespec t;
+
+    if (clock_gettime (CLOCK_THREAD_CPUTIME_ID, &t) == 0)
+        return double (t.tv_sec) + double (t.tv_nsec) * 1e-9;
+#endif
+
+    return -1.0;
+}
+
+/**
+
+	One stream of the probe benchmark: an AcquisitionEngine replaying a
+	synthetic capture file into a DataBuffer and an ActivityView on its
+	own thread, as a probe does during acquisition.
+
+*/
+class BenchmarkStream : public Thread
+{
+public:
+    BenchmarkStream (const String& type_, int probeIndex_, int numChannels, bool hasLfp)
+        : Thread ("Benchmark " + type_),
+          type (type_),
+          probeIndex (probeIndex_),
+          apBuffer (numChannels + 1, BENCHMARK_BUFFER_SAMPLES),
+          apView (numChannels, 3000),
+          drainBuffer (numChannels + 1, BENCHMARK_BUFFER_SAMPLES),
+          sampleNumbers (BENCHMARK_BUFFER_SAMPLES),
+          timestamps (BENCHMARK_BUFFER_SAMPLES),
+          eventCodes (BENCHMARK_BUFFER_SAMPLES)
+    {
+        apScaling.setScale (numChannels, 1.2f / 1024.0f * 1000000.0f / 500.0f);
+        lfpScaling.setScale (numChannels, 1.2f / 1024.0f * 1000000.0f / 250.0f);
+
+        if (hasLfp)
+        {
+            lfpBuffer = std::make_unique<DataBuffer> (numChannels + 1, BENCHMARK_BUFFER_SAMPLES);
+            lfpView = std::make_unique<ActivityView> (numChannels, 250);
+        }
+    }
+
+    ~BenchmarkStream() override { stopThread (1000); }
+
+    /** Creates the engine and points it at the capture file */
+    template <class Traits>
+    bool open (const File& captureFile, double speed, Neuropixels::streamsource_t source)
+    {
+        if (! replay.open (captureFile))
+            return false;
+
+        replay.setSpeed (speed);
+        replay.setLooping (true);
+
+        engine = std::make_unique<AcquisitionEngine<Traits>> (nullptr, apScaling, lfpScaling, source);
+        engine->reset (true, false);
+        engine->setOutputs (&apBuffer, &apView, lfpBuffer.get(), lfpView.get());
+
+        return engine->setReplay (&replay);
+    }
+
+    void run() override
+    {
+        const double cpuStart = getThreadCpuSeconds();
+
+        engine->run (*this);
+
+        if (cpuStart >= 0.0)
+            cpuSeconds = getThreadCpuSeconds() - cpuStart;
+    }
+
+    /** Empties the DataBuffers, as the GUI's processing thread does */
+    void drain()
+    {
+        apBuffer.readAllFromBuffer (drainBuffer, sampleNumbers.data(), timestamps.data(), eventCodes.data(), BENCHMARK_BUFFER_SAMPLES);
+
+        if (lfpBuffer != nullptr)
+            lfpBuffer->readAllFromBuffer (drainBuffer, sampleNumbers.data(), timestamps.data(), eventCodes.data(), BENCHMARK_BUFFER_SAMPLES);
+    }
+
+    const String type;
+    const int probeIndex;
+
+    PacketDecoder::ChannelScaling apScaling;
+    PacketDecoder::ChannelScaling lfpScaling;
+
+    std::unique_ptr<AcquisitionEngineBase> engine;
+    CaptureReplay replay;
+
+    double cpuSeconds = -1.0;
+
+private:
+    DataBuffer apBuffer;
+    ActivityView apView;
+    std::unique_ptr<DataBuffer> lfpBuffer;
+    std::unique_ptr<ActivityView> lfpView;
+
+    AudioBuffer<float> drainBuffer;
+    std::vector<int64> sampleNumbers;
+    std::vector<double> timestamps;
+    std::vector<uint64> eventCodes;
+};
+
+/** Probe types accepted by runProbes(), with the number of streams per probe */
+struct BenchmarkProbeType
+{
+    const char* name;
+    int numStreams;
+};
+
+static const BenchmarkProbeType benchmarkProbeTypes[] = {
+    { "NP1", 1 },
+    { "NHP", 1 },
+    { "NP2", 1 },
+    { "QUAD", 4 }
+};
+
+/** Creates the streams of one probe; returns false if the type is unknown or a file cannot be opened */
+static bool addBenchmarkProbe (OwnedArray<BenchmarkStream>& streams,
+                               const String& type,
+                               int probeIndex,
+                               double speed,
+                               std::map<String, File>& captureFiles)
+{
+    auto getCaptureFile = [&] (auto traits) -> File
+    {
+        using Traits = decltype (traits);
+
+        if (captureFiles.count (type) == 0)
+        {
+            File file = File::getSpecialLocation (File::tempDirectory).getNonexistentChildFile ("npx_benchmark_" + type, ".npxcap");
+
+            if (! writeSyntheticCapture<Traits> (file))
+                return File();
+
+            captureFiles[type] = file;
+        }
+
+        return captureFiles[type];
+    };
+
+    auto add = [&] (auto traits, Neuropixels::streamsource_t source) -> bool
+    {
+        using Traits = decltype (traits);
+
+        const File file = getCaptureFile (traits);
+
+        if (file == File())
+            return false;
+
+        auto stream = new BenchmarkStream (type, probeIndex, Traits::numChannels, Traits::hasLfp);
+        streams.add (stream);
+
+        return stream->open<Traits> (file, speed, source);
+    };
+
+    if (type == "NP1")
+        return add (NP1Traits(), Neuropixels::SourceAP);
+
+    if (type == "NHP")
+        return add (NHPPassiveTraits(), Neuropixels::SourceAP);
+
+    if (type == "NP2")
+        return add (NP2Traits(), Neuropixels::SourceAP);
+
+    if (type == "QUAD")
+    {
+        for (int shank = 0; shank < 4; shank++)
+        {
+            if (! add (QuadBaseShankTraits(), Neuropixels::streamsource_t (shank)))
+                return false;
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+/** Result columns of runProbes(), in CSV order */
+static const StringArray benchmarkColumns = {
+    "probe", "type", "stream", "samples_per_second", "real_time_factor", "batches",
+    "decode_p50_us", "decode_p90_us", "decode_p99_us", "decode_max_us",
+    "min_headroom_packets", "max_fifo_fill_percent", "lost_packets", "cpu_percent"
+};
+
+String AcquisitionBenchmark::runProbes (const StringArray& probeTypes,
+                                        double seconds,
+                                        double speed,
+                                        bool asJson,
+                                        const File& outputFile)
+{
+    OwnedArray<BenchmarkStream> streams;
+    std::map<String, File> captureFiles;
+
+    bool ok = true;
+    int probeIndex = 0;
+
+    for (auto entry : probeTypes)
+    {
+        // <type>[x<count>], e.g. NP1x8
+        const String type = entry.upToFirstOccurrenceOf ("X", false, true).toUpperCase();
+        const int count = entry.containsIgnoreCase ("X") ? entry.fromFirstOccurrenceOf ("X", false, true).getIntValue() : 1;
+
+        for (int i = 0; i < count && ok; i++)
+            ok = addBenchmarkProbe (streams, type, probeIndex++, speed, captureFiles);
+    }
+
+    String result;
+
+    if (! ok || streams.size() == 0 || streams.size() > 128)
+    {
+        result = "Probe benchmark needs 1 to 128 streams of known types (";
+
+        for (auto& t : benchmarkProbeTypes)
+            result += String (t.name) + (t.numStreams > 1 ? " = " + String (t.numStreams) + " streams" : "") + ", ";
+
+        result = result.dropLastCharacters (2) + "), e.g. NP1x8,QUADx2";
+    }
+    else
+    {
+        const int64 start = Time::getHighResolutionTicks();
+        const int64 end = start + Time::secondsToHighResolutionTicks (seconds);
+
+        for (auto stream : streams)
+            stream->startThread();
+
+        // Stops early if run by a thread that is asked to exit
+        while (Time::getHighResolutionTicks() < end && ! Thread::currentThreadShouldExit())
+        {
+            for (auto stream : streams)
+                stream->drain();
+
+            Thread::sleep (BENCHMARK_DRAIN_INTERVAL_MS);
+        }
+
+        for (auto stream : streams)
+            stream->signalThreadShouldExit();
+
+        for (auto stream : streams)
+            stream->stopThread (1000);
+
+        const double elapsedSeconds = Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - start);
+
+        Array<var> rows;
+        double totalSamplesPerSecond = 0.0;
+
+        for (int i = 0; i < streams.size(); i++)
+        {
+            BenchmarkStream* stream = streams[i];
+            const PollingScheduler& scheduler = stream->engine->getScheduler();
+            const PollingScheduler::Statistics stats = scheduler.getStatistics();
+
+            const double samplesPerSecond = double (stream->engine->getApSampleNumber()) / elapsedSeconds;
+            totalSamplesPerSecond += samplesPerSecond;
+
+            DynamicObject::Ptr row = new DynamicObject();
+
+            row->setProperty (Identifier ("probe"), stream->probeIndex);
+            row->setProperty (Identifier ("type"), stream->type);
+            row->setProperty (Identifier ("stream"), i);
+            row->setProperty (Identifier ("samples_per_second"), samplesPerSecond);
+            row->setProperty (Identifier ("real_time_factor"), samplesPerSecond / 30000.0);
+            row->setProperty (Identifier ("batches"), stats.numReads);
+            row->setProperty (Identifier ("decode_p50_us"), scheduler.getProcessingPercentileUs (50.0));
+            row->setProperty (Identifier ("decode_p90_us"), scheduler.getProcessingPercentileUs (90.0));
+            row->setProperty (Identifier ("decode_p99_us"), scheduler.getProcessingPercentileUs (99.0));
+            row->setProperty (Identifier ("decode_max_us"), scheduler.getProcessingPercentileUs (100.0));
+            row->setProperty (Identifier ("min_headroom_packets"), stats.minHeadroom);
+            row->setProperty (Identifier ("max_fifo_fill_percent"), 100.0 * stats.maxFifoFill);
+            row->setProperty (Identifier ("lost_packets"), stream->replay.getNumOverflowedPackets());
+            row->setProperty (Identifier ("cpu_percent"), stream->cpuSeconds >= 0.0 ? 100.0 * stream->cpuSeconds / elapsedSeconds : -1.0);
+
+            rows.add (row.get());
+        }
+
+        if (asJson)
+        {
+            DynamicObject output;
+
+            output.setProperty (Identifier ("cores"), SystemStats::getNumCpus());
+            output.setProperty (Identifier ("speed"), speed);
+            output.setProperty (Identifier ("seconds"), elapsedSeconds);
+            output.setProperty (Identifier ("instruction_set"), String (PacketDecoder::getInstructionSetName()));
+            output.setProperty (Identifier ("total_samples_per_second"), totalSamplesPerSecond);
+            output.setProperty (Identifier ("streams"), rows);
+
+            MemoryOutputStream f;
+            output.writeAsJSON (f, JSON::FormatOptions {}.withIndentLevel (0).withSpacing (JSON::Spacing::multiLine).withMaxDecimalPlaces (4));
+
+            result = f.toString();
+        }
+        else
+        {
+            result = benchmarkColumns.joinIntoString (",") + "\n";
+
+            for (auto& row : rows)
+            {
+                StringArray values;
+
+                for (auto& column : benchmarkColumns)
+                    values.add (row[Identifier (column)].toString());
+
+                result += values.joinIntoString (",") + "\n";
+            }
+        }
+    }
+
+    for (auto& file : captureFiles)
+        file.second.deleteFile();
+
+    if (outputFile != File())
+        outputFile.replaceWithText (result);
+
+    LOGC (result);
+
+    return result;
+}
+
+String AcquisitionBenchmark::runThreading (int numStreams, double secondsPerMode)
+{
+    String result = "Threading benchmark (" + String (numStreams) + " simulated NP1 streams, " + String (SystemStats::getNumCpus()) + " cores";
+
+#if ! JUCE_WINDOWS
+    result += ", context switches and CPU are for the whole process";
+#endif
+
+    result += ")\n";
+
+    result += benchmarkThreading ("One thread per stream", numStreams, 0, secondsPerMode);
+    result += benchmarkThreading ("Acquisition pool (automatic)", numStreams, -1, secondsPerMode);
+    result += benchmarkThreading ("Acquisition pool (1 thread)", numStreams, 1, secondsPerMode);
+
+    LOGC (result);
+
+    return result;
+}
+
+String AcquisitionBenchmark::run (double secondsPerCase)
+{
+    String result = "Acquisition benchmark (" + String (PacketDecoder::getInstructionSetName()) + ", single core, sync channel enabled)\n";
+
+    result += benchmarkElectrodePackets<NP1Traits> ("Neuropixels 1.0", secondsPerCase);
+    result += benchmarkElectrodePackets<NHPPassiveTraits> ("NHP Passive", secondsPerCase);
+    result += benchmarkPacketInfo<NP2Traits> ("Neuropixels 2.0", secondsPerCase);
+    result += benchmarkPacketInfo<QuadBaseShankTraits> ("Quad Base shank", secondsPerCase);
+    result += benchmarkActivityFilter (secondsPerCase);
+
+    LOGC (result);
+
+    return result;
+}
+
+BenchmarkThread::BenchmarkThread() : Thread ("Acquisition benchmark")
+{
+}
+
+BenchmarkThread::~BenchmarkThread()
+{
+    stopThread (5000);
+}
+
+bool BenchmarkThread::start (std::function<String()> benchmark_)
+{
+    if (isThreadRunning())
+        return false;
+
+    benchmark = std::move (benchmark_);
+
+    {
+        const ScopedLock lock (resultLock);
+        result.clear();
+    }
+
+    startThread();
+
+    return true;
+}
+
+String BenchmarkThread::getResult()
+{
+    const ScopedLock lock (resultLock);
+    return result;
+}
+
+void BenchmarkThread::run()
+{
+    String report = benchmark();
+
+    if (threadShouldExit())
+        return;
+
+    const ScopedLock lock (resultLock);
+    result = report;
+}
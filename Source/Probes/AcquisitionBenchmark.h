@@ -0,0 +1,110 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __ACQUISITIONBENCHMARK_H_2C4C2D67__
+#define __ACQUISITIONBENCHMARK_H_2C4C2D67__
+
+#include <DataThreadHeaders.h>
+
+#include <functional>
+
+/**
+
+	Measures single-core decode throughput of the acquisition
+	loops using synthetic packets (no hardware required).
+
+	Each probe family is timed twice: once with the original
+	per-sample loop and once with AcquisitionEngine. Results are
+	reported in samples per second and as a multiple of the
+	30 kHz real-time rate. One more case compares the activity view
+	band-pass with one filter per channel against a BiquadBank (also
+	with a SpikeDetector).
+
+	Triggered by the "NP BENCHMARK [seconds]" config message.
+
+	runThreading() compares one thread per stream with an
+	AcquisitionPool, using simulated NP1 streams that are fed by
+	a SimulatedFifo in real time ("NP BENCHMARK THREADS [streams]
+	[seconds]").
+
+	runProbes() sizes deployments: it acquires from a set of probes
+	of the given types, each replaying synthetic packets on its own
+	thread into a DataBuffer and an ActivityView (at real time or
+	faster), and reports per-stream throughput, batch decode time
+	percentiles, FIFO headroom and CPU use as CSV or JSON ("NP
+	BENCHMARK PROBES <types> [seconds] [speed] [CSV/JSON] [file]").
+	The config messages run runThreading() and runProbes() on a
+	BenchmarkThread, and the report is fetched with "NP BENCHMARK
+	RESULT".
+
+*/
+class AcquisitionBenchmark
+{
+public:
+    /** Runs all cases for approximately secondsPerCase each, and returns a summary */
+    static String run (double secondsPerCase = 0.5);
+
+    /** Acquires numStreams simulated streams for secondsPerMode with each threading model, and returns a summary */
+    static String runThreading (int numStreams = 32, double secondsPerMode = 2.0);
+
+    /** Acquires from probes of the given types (e.g. "NP1x8", "QUAD") for `seconds` at `speed`
+        times real time (0 = as fast as possible); returns a CSV or JSON report, which is also
+        written to outputFile if one is given */
+    static String runProbes (const StringArray& probeTypes,
+                             double seconds = 5.0,
+                             double speed = 1.0,
+                             bool asJson = false,
+                             const File& outputFile = File());
+};
+
+/**
+
+	Runs a long benchmark (runThreading() or runProbes()) in the
+	background, so that the config message that starts it returns
+	immediately.
+
+*/
+class BenchmarkThread : public Thread
+{
+public:
+    BenchmarkThread();
+
+    /** Stops a run in progress (its report is discarded) */
+    ~BenchmarkThread();
+
+    /** Starts running a benchmark that returns its report; returns false if one is already running */
+    bool start (std::function<String()> benchmark);
+
+    /** Returns the report of the last completed run, or an empty string if there is none */
+    String getResult();
+
+    void run() override;
+
+private:
+    std::function<String()> benchmark;
+
+    CriticalSection resultLock;
+    String result;
+};
+
+#endif // __ACQUISITIONBENCHMARK_H_2C4C2D67__
@@ -0,0 +1,209 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "AcquisitionEngine.h"
+#include "../NeuropixThread.h"
+
+AcquisitionEngineBase::AcquisitionEngineBase (Probe* probe_,
+                                              const PacketDecoder::ChannelScaling& apScaling_,
+                                              const PacketDecoder::ChannelScaling& lfpScaling_,
+                                              Neuropixels::streamsource_t source_,
+                                              int packetsPerSuperFrame_,
+                                              int defaultBatchPackets_,
+                                              const PacketCapture::Layout& captureLayout_)
+    : probe (probe_),
+      source (source_),
+      apScaling (apScaling_),
+      lfpScaling (lfpScaling_),
+      packetsPerSuperFrame (packetsPerSuperFrame_),
+      defaultBatchPackets (defaultBatchPackets_),
+      readBatchPackets (defaultBatchPackets_),
+      packetLoss (probe_ != nullptr ? &probe_->packetLoss : &offlinePacketLoss),
+      statusErrors (probe_ != nullptr ? &probe_->statusErrors : &offlineStatusErrors),
+      clock (&offlineClock),
+      captureLayout (captureLayout_)
+{
+}
+
+void AcquisitionEngineBase::setOutputs (DataBuffer* apBuffer_,
+                                        ActivityView* apView_,
+                                        DataBuffer* lfpBuffer_,
+                                        ActivityView* lfpView_,
+                                        int viewBlockIndex_)
+{
+    apBuffer = apBuffer_;
+    apView = apView_;
+    lfpBuffer = lfpBuffer_;
+    lfpView = lfpView_;
+    viewBlockIndex = viewBlockIndex_;
+}
+
+bool AcquisitionEngineBase::setReplay (CaptureReplay* replay_)
+{
+    if (replay_ != nullptr)
+    {
+        const PacketCapture::FileHeader& header = replay_->getHeader();
+
+        if (header.format != captureLayout.format
+            || header.headerBytes != captureLayout.headerBytes
+            || header.payloadBytes != captureLayout.payloadBytes)
+        {
+            LOGE ("Packet capture format does not match the stream on slot ", slot, ", port ", port);
+            return false;
+        }
+    }
+
+    replay = replay_;
+
+    return true;
+}
+
+void AcquisitionEngineBase::run (Thread& thread)
+{
+    prepareToPoll();
+
+    while (! thread.threadShouldExit())
+        scheduler.wait (poll(), thread);
+
+    finishPolling();
+}
+
+void AcquisitionEngineBase::reset (bool sendSync_, bool invertSyncLine)
+{
+    if (probe != nullptr)
+    {
+        slot = probe->basestation->slot;
+        port = probe->headstage->port;
+        dock = probe->dock;
+
+        pollingSettings = probe->pollingSettings;
+        gapFillSettings = probe->gapFillSettings;
+
+        clock = &probe->basestation->clock;
+        syncEdges = reportsFifoFill ? &probe->syncEdges : nullptr;
+    }
+    else
+    {
+        offlineClock.reset (Time::getHighResolutionTicks());
+    }
+
+    if (pollingSettings.readBatchSuperFrames > 0)
+        readBatchPackets = jmin (pollingSettings.readBatchSuperFrames, PollingScheduler::Settings::maxReadBatchSuperFrames) * packetsPerSuperFrame;
+    else
+        readBatchPackets = defaultBatchPackets;
+
+    allocateBuffers (readBatchPackets);
+
+    sendSync = sendSync_;
+    invertMask = invertSyncLine ? ~uint64 (0) : 0;
+
+    apEvents.reset (invertMask);
+
+    apSampleNumber = 0;
+    lfpSampleNumber = 0;
+    lastNpxTimestamp = 0;
+    hardwareTick = 0;
+    apTimestampConverter.reset();
+    lfpTimestampConverter.reset();
+    lastReadTicks = Time::getHighResolutionTicks();
+    passedOneSecond = false;
+
+    apSamplesSkipped = 0;
+    lfpSamplesSkipped = 0;
+
+    const int numDataChannels = (int) captureLayout.numChannels;
+    const int numBufferChannels = numDataChannels + (sendSync ? 1 : 0);
+
+    apGapFiller.prepare (gapFillSettings, numDataChannels, numBufferChannels, 30000.0);
+    lfpGapFiller.prepare (gapFillSettings, numDataChannels, numBufferChannels, 2500.0);
+
+    // Only engines whose traits track offsets update the estimates; the others leave them at zero
+    if (probe != nullptr)
+        probe->prepareOffsets (numDataChannels, 30000.0f, 2500.0f);
+
+    capture.reset();
+
+    if (probe != nullptr && probe->captureSettings.enabled)
+        openCapture (probe->captureSettings);
+}
+
+void AcquisitionEngineBase::openCapture (const PacketCapture::Settings& settings)
+{
+    File directory = probe->basestation->getSavingDirectory();
+
+    if (! directory.isDirectory())
+        directory = File::getSpecialLocation (File::userDocumentsDirectory).getChildFile ("Neuropixels captures");
+
+    PacketCapture::FileHeader stream {};
+
+    stream.source = int (source);
+    stream.slot = slot;
+    stream.port = port;
+    stream.dock = dock;
+    probe->info.part_number.copyToUTF8 (stream.partNumber, sizeof (stream.partNumber));
+    stream.serialNumber = probe->info.serial_number;
+    stream.apMicrovoltsPerBit = apScaling.getNumChannels() > 0 ? apScaling.scale[0] : 0.0f;
+    stream.lfpMicrovoltsPerBit = lfpScaling.getNumChannels() > 0 ? lfpScaling.scale[0] : 0.0f;
+
+    capture = std::make_unique<PacketCapture> (captureLayout);
+
+    if (! capture->open (PacketCapture::getDefaultFile (directory, slot, port, dock, int (source)),
+                         int64 (settings.sizeMegabytes) << 20,
+                         stream))
+    {
+        capture.reset();
+    }
+}
+
+void AcquisitionEngineBase::finishPolling()
+{
+    logSchedulerSummary();
+
+    capture.reset();
+}
+
+int64 AcquisitionEngineBase::reportTimestampJump (uint32_t timestampJump)
+{
+    if (! passedOneSecond || timestampJump >= MAX_HEADSTAGE_CLK_SAMPLE)
+        return 0;
+
+    packetLoss->registerJump (timestampJump, apSampleNumber);
+
+    return PacketLossCounters::getMissingSamples (timestampJump);
+}
+
+void AcquisitionEngineBase::reportReadError (Neuropixels::NP_ErrorCode errorCode)
+{
+    LOGD ("readPackets error code: ", errorCode, " for Basestation ", slot, ", probe ", port);
+}
+
+void AcquisitionEngineBase::updateFifoFill (int packetsAvailable, int headroom)
+{
+    if (probe != nullptr && reportsFifoFill && packetsAvailable + headroom > 0)
+        probe->fifoFillPercentage = float (packetsAvailable) / float (packetsAvailable + headroom);
+}
+
+void AcquisitionEngineBase::logSchedulerSummary()
+{
+    LOGC ("Acquisition thread for slot ", slot, ", port ", port, ", dock ", dock, " (", readBatchPackets, " packets per read): ", scheduler.getSummary());
+}
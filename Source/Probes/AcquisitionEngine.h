@@ -0,0 +1,715 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __ACQUISITIONENGINE_H_2C4C2D67__
+#define __ACQUISITIONENGINE_H_2C4C2D67__
+
+#include "../NeuropixComponents.h"
+#include "CaptureReplay.h"
+#include "PacketCapture.h"
+
+/** Layout of the data returned by the Neuropixels API */
+enum class PacketFormat
+{
+    ELECTRODE_PACKETS, // readElectrodeData: 12 AP samples + 1 LFP sample per packet
+    PACKET_INFO // readPackets: 1 sample per packet, payload stored separately
+};
+
+/**
+
+	Compile-time description of a probe family's data stream.
+
+	Every acquisition loop in this plugin differs only in these
+	constants, so they are supplied as template arguments to
+	AcquisitionEngine instead of being checked for every sample.
+
+*/
+struct NP1Traits
+{
+    static constexpr int numChannels = 384;
+    static constexpr int superFrameSize = 12; // AP samples per packet
+    static constexpr bool hasLfp = true;
+    static constexpr int maxPackets = 64; // default read batch
+    static constexpr PacketFormat format = PacketFormat::ELECTRODE_PACKETS;
+    static constexpr double packetIntervalUs = 400.0; // 12 samples at 30 kHz
+    static constexpr bool tracksOffsets = true;
+    static constexpr bool sharesFifo = false; // FIFO status is read from SourceAP for all streams
+};
+
+struct UHDTraits : NP1Traits
+{
+};
+
+struct OptoTraits : NP1Traits
+{
+};
+
+struct NHPActiveTraits : NP1Traits
+{
+};
+
+struct NHPPassiveTraits : NP1Traits
+{
+    static constexpr int numChannels = 128;
+};
+
+struct NP2Traits
+{
+    static constexpr int numChannels = 384;
+    static constexpr int superFrameSize = 1;
+    static constexpr bool hasLfp = false;
+    static constexpr int maxPackets = 64 * 12;
+    static constexpr PacketFormat format = PacketFormat::PACKET_INFO;
+    static constexpr double packetIntervalUs = 1.0e6 / 30000.0;
+    static constexpr bool tracksOffsets = false;
+    static constexpr bool sharesFifo = false;
+};
+
+struct QuadBaseShankTraits : NP2Traits
+{
+    static constexpr int maxPackets = 64 * 12 * 4;
+    static constexpr bool sharesFifo = true;
+};
+
+/**
+
+	State and slow-path handling shared by all AcquisitionEngine
+	specializations (sample counters, output buffers, error reporting).
+
+*/
+class AcquisitionEngineBase : public AcquisitionTask
+{
+public:
+    /** Constructor -- probe may be null when the engine is used offline (e.g. for benchmarks);
+        scaling objects are owned by the caller and read on every batch */
+    AcquisitionEngineBase (Probe* probe,
+                           const PacketDecoder::ChannelScaling& apScaling,
+                           const PacketDecoder::ChannelScaling& lfpScaling,
+                           Neuropixels::streamsource_t source,
+                           int packetsPerSuperFrame,
+                           int defaultBatchPackets,
+                           const PacketCapture::Layout& captureLayout);
+
+    /** Destructor */
+    virtual ~AcquisitionEngineBase() {}
+
+    /** Sets the buffers and views that receive decoded data (any of these may be null) */
+    void setOutputs (DataBuffer* apBuffer,
+                     ActivityView* apView,
+                     DataBuffer* lfpBuffer = nullptr,
+                     ActivityView* lfpView = nullptr,
+                     int viewBlockIndex = 0);
+
+    /** Resets sample counters, latches the sync and polling options, sizes
+        the buffers for the probe's read batch and opens a packet capture file
+        if the probe has capture enabled; call before starting acquisition */
+    void reset (bool sendSync, bool invertSyncLine);
+
+    /** Reads packets from a capture file instead of the Neuropixels API (null = API).
+        Returns false if the file was captured from a different kind of stream */
+    bool setReplay (CaptureReplay* replay);
+
+    /** Acquires data on the calling thread until it is asked to exit */
+    void run (Thread& thread);
+
+    /** Returns the maximum number of packets per read */
+    int getReadBatchPackets() const { return readBatchPackets; }
+
+    /** Determines whether this engine updates the probe's FIFO fill percentage */
+    void setReportsFifoFill (bool shouldReport) { reportsFifoFill = shouldReport; }
+
+    /** Returns the number of AP samples acquired since the last reset */
+    int64 getApSampleNumber() const { return apSampleNumber; }
+
+    /** Returns the number of LFP samples acquired since the last reset */
+    int64 getLfpSampleNumber() const { return lfpSampleNumber; }
+
+    /** Returns the scheduler that decides when to read from the FIFO */
+    const PollingScheduler& getScheduler() const { return scheduler; }
+
+    /** Logs the scheduler summary and closes the packet capture file */
+    void finishPolling() override;
+
+protected:
+    /** Resizes the packet and sample buffers to hold numPackets packets */
+    virtual void allocateBuffers (int numPackets) = 0;
+
+    /** Counts an unexpected jump in the 100 kHz hardware timestamp (reported later by PacketLossReporter);
+        returns the number of AP samples lost, or 0 if the jump is ignored */
+    int64 reportTimestampJump (uint32_t timestampJump);
+
+    /** Logs a failed read from the API */
+    void reportReadError (Neuropixels::NP_ErrorCode errorCode);
+
+    /** Stores the FIFO fill level in the probe, if this engine is responsible for it */
+    void updateFifoFill (int packetsAvailable, int headroom);
+
+    /** Logs how the acquisition thread spent its time */
+    void logSchedulerSummary();
+
+    /** Creates the capture file for this stream in the basestation's saving directory */
+    void openCapture (const PacketCapture::Settings& settings);
+
+    Probe* probe;
+    Neuropixels::streamsource_t source;
+
+    const PacketDecoder::ChannelScaling& apScaling;
+    const PacketDecoder::ChannelScaling& lfpScaling;
+
+    int slot = 0;
+    int port = 0;
+    int dock = 0;
+
+    DataBuffer* apBuffer = nullptr;
+    DataBuffer* lfpBuffer = nullptr;
+    ActivityView* apView = nullptr;
+    ActivityView* lfpView = nullptr;
+    int viewBlockIndex = 0;
+
+    bool sendSync = false;
+    uint64 invertMask = 0;
+    bool reportsFifoFill = true;
+
+    PollingScheduler scheduler;
+    PollingScheduler::Settings pollingSettings;
+
+    const int packetsPerSuperFrame;
+    const int defaultBatchPackets;
+    int readBatchPackets;
+
+    int64 apSampleNumber = 0;
+    int64 lfpSampleNumber = 0;
+    uint32_t lastNpxTimestamp = 0;
+    bool passedOneSecond = false;
+
+    /** The probe's loss counters, or offlinePacketLoss if there is no probe */
+    PacketLossCounters* packetLoss;
+    PacketLossCounters offlinePacketLoss;
+
+    /** The probe's status error counters, or offlineStatusErrors if there is no probe */
+    StatusErrorCounters* statusErrors;
+    StatusErrorCounters offlineStatusErrors;
+
+    /** The basestation's clock model, or offlineClock if there is no probe */
+    HardwareClock* clock;
+    HardwareClock offlineClock;
+
+    /** Unwrapped 100 kHz timestamp of the newest sample */
+    int64 hardwareTick = 0;
+
+    /** Keep the AP and LFP timestamps increasing across batches */
+    HardwareClock::StreamTimestamps apTimestampConverter;
+    HardwareClock::StreamTimestamps lfpTimestampConverter;
+
+    /** Changes of the inputs in the current batch */
+    EventTransitions apEvents;
+
+    /** Receives the sync edges, if this is the probe's primary stream */
+    SyncEdges* syncEdges = nullptr;
+
+    /** Host time at which the most recent read returned */
+    int64 lastReadTicks = 0;
+
+    /** How lost samples are handled, latched from the probe by reset() */
+    GapFiller::Settings gapFillSettings;
+
+    /** Write the AP and LFP batches, inserting fill samples if enabled */
+    GapFiller apGapFiller;
+    GapFiller lfpGapFiller;
+
+    /** Lost AP and LFP samples skipped by the sample counters since the last reset */
+    int64 apSamplesSkipped = 0;
+    int64 lfpSamplesSkipped = 0;
+
+    const PacketCapture::Layout captureLayout;
+
+    /** Receives the raw packets of every read, if capture is enabled */
+    std::unique_ptr<PacketCapture> capture;
+
+    /** Supplies packets in place of the API, if set */
+    CaptureReplay* replay = nullptr;
+};
+
+/**
+
+	Reads, decodes and forwards data for one probe stream.
+
+	All stream dimensions come from the Traits argument, so the
+	per-sample loops have constant bounds and no branches on probe
+	type or on whether the sync channel is being sent (that choice
+	is made once per batch). The read batch size is a runtime
+	setting (PollingScheduler::Settings::readBatchSuperFrames);
+	Traits::maxPackets is only the default.
+
+	Owners call run() from their thread; process() can be called
+	directly on packets placed in getElectrodePackets() /
+	getPacketInfo() + getPacketData() to measure throughput without
+	hardware, and setReplay() substitutes a capture file for the API.
+
+*/
+template <class Traits>
+class AcquisitionEngine : public AcquisitionEngineBase
+{
+public:
+    static constexpr int defaultSamplesPerBatch = Traits::maxPackets * Traits::superFrameSize;
+
+    /** AP samples decoded and sent to the outputs at a time (about 150 kB of floats for 385 channels) */
+    static constexpr int outputChunkSamples = 96;
+
+    /** Constructor -- scaling objects are owned by the caller and read on every batch */
+    AcquisitionEngine (Probe* probe_,
+                       const PacketDecoder::ChannelScaling& apScaling_,
+                       const PacketDecoder::ChannelScaling& lfpScaling_,
+                       Neuropixels::streamsource_t source_ = Neuropixels::SourceAP)
+        : AcquisitionEngineBase (probe_, apScaling_, lfpScaling_, source_, 12 / Traits::superFrameSize, Traits::maxPackets, getCaptureLayout())
+    {
+        allocateBuffers (Traits::maxPackets);
+    }
+
+    /** Resets the polling scheduler (and the replay clock, if replaying) */
+    void prepareToPoll() override
+    {
+        scheduler.prepare (pollingSettings, Traits::packetIntervalUs, readBatchPackets);
+
+        if (replay != nullptr)
+            replay->start (Time::getHighResolutionTicks());
+    }
+
+    /** Reads and processes one batch, and refreshes the FIFO status when due */
+    double poll() override
+    {
+        const int count = read();
+
+        lastReadTicks = Time::getHighResolutionTicks();
+
+        scheduler.packetsRead (count, readBatchPackets, lastReadTicks);
+
+        if (count > 0)
+        {
+            scheduler.startProcessing();
+
+            if (capture != nullptr)
+                writeCapture (count);
+
+            process (count);
+            scheduler.stopProcessing();
+        }
+
+        const int64 now = Time::getHighResolutionTicks();
+
+        if (scheduler.shouldQueryFifo (now))
+            queryFifo (now);
+
+        // Replaying as fast as possible: read again straight away until the file ends
+        if (replay != nullptr && replay->getSpeed() == 0.0)
+            return replay->isFinished() ? PollingScheduler::Settings::superFrameDurationUs : 0.0;
+
+        return scheduler.getTimeUntilNextRead (Time::getHighResolutionTicks());
+    }
+
+    /** Decodes `count` packets from the packet buffers and sends them to the outputs */
+    void process (int count)
+    {
+        jassert (count <= readBatchPackets);
+        jassert (apScaling.getNumChannels() == Traits::numChannels);
+
+        const uint16_t statusFlags = extractMetadata (count);
+
+        writeEventCodes (count);
+
+        if (statusFlags & StatusErrorCounters::errorMask)
+            countStatusErrors (count);
+
+        convertTimestamps (count);
+
+        if (syncEdges != nullptr)
+            syncEdges->detect (apEvents.getTransitions(), apTimestamps.data());
+
+        // Batches with gaps are written in one piece, so that the gap filler sees the sample indices it registered
+        const int chunkPackets = apGapFiller.hasGaps() ? count : jmax (1, outputChunkSamples / Traits::superFrameSize);
+
+        for (int firstPacket = 0; firstPacket < count; firstPacket += chunkPackets)
+            writeApChunk (firstPacket, jmin (chunkPackets, count - firstPacket));
+
+        if constexpr (Traits::hasLfp)
+        {
+            PacketDecoder::decodeLfpSuperFrames (packets.data(), count, lfpScaling, lfpSamples.data(), count);
+
+            lfpGapFiller.write (lfpBuffer, lfpSamples.data(), lfpSampleNumbers.data(), lfpTimestamps.data(), lfpEventCodes.data(), count);
+
+            if (lfpView != nullptr)
+                lfpView->addToBuffer (lfpSamples.data(), count, viewBlockIndex);
+        }
+
+        if constexpr (Traits::tracksOffsets)
+        {
+            if (probe != nullptr)
+                probe->updateOffsets (lfpSamples.data(), count, lfpSampleNumbers[0], false);
+        }
+
+        if (! passedOneSecond && apSampleNumber > 30000)
+            passedOneSecond = true;
+    }
+
+    /** Packet buffer for PacketFormat::ELECTRODE_PACKETS streams */
+    Neuropixels::electrodePacket* getElectrodePackets() { return packets.data(); }
+
+    /** Packet headers for PacketFormat::PACKET_INFO streams */
+    Neuropixels::PacketInfo* getPacketInfo() { return packetInfo.data(); }
+
+    /** Sample-major payload for PacketFormat::PACKET_INFO streams */
+    int16_t* getPacketData() { return packetData.data(); }
+
+    /** Decoded AP samples (channel-major, sync channel last) from the most recent output chunk */
+    const float* getApSamples() const { return apSamples.data(); }
+
+    /** Describes the records written to (and accepted from) packet capture files */
+    static PacketCapture::Layout getCaptureLayout()
+    {
+        PacketCapture::Layout layout;
+
+        if constexpr (Traits::format == PacketFormat::ELECTRODE_PACKETS)
+        {
+            layout.format = 0;
+            layout.headerBytes = sizeof (Neuropixels::electrodePacket);
+        }
+        else
+        {
+            layout.format = 1;
+            layout.headerBytes = sizeof (Neuropixels::PacketInfo);
+            layout.payloadBytes = Traits::numChannels * sizeof (int16_t);
+        }
+
+        layout.numChannels = Traits::numChannels;
+        layout.packetIntervalUs = Traits::packetIntervalUs;
+
+        return layout;
+    }
+
+private:
+    /** Copies the packets from the most recent read, as returned by the API, to the capture file */
+    void writeCapture (int count)
+    {
+        if constexpr (Traits::format == PacketFormat::ELECTRODE_PACKETS)
+            capture->write (packets.data(), nullptr, count);
+        else
+            capture->write (packetInfo.data(), packetData.data(), count);
+    }
+
+    void allocateBuffers (int numPackets) override
+    {
+        const size_t numSamples = (size_t) numPackets * Traits::superFrameSize;
+
+        if constexpr (Traits::format == PacketFormat::ELECTRODE_PACKETS)
+        {
+            packets.resize (numPackets);
+        }
+        else
+        {
+            packetInfo.resize (numPackets);
+            packetData.resize ((size_t) numPackets * Traits::numChannels);
+        }
+
+        apSamples.resize ((size_t) (Traits::numChannels + 1) * numSamples);
+        apSampleNumbers.resize (numSamples);
+        apEventCodes.resize (numSamples);
+        apTimestamps.resize (numSamples);
+
+        if constexpr (Traits::hasLfp)
+        {
+            lfpSamples.resize ((size_t) (Traits::numChannels + 1) * numPackets);
+            lfpSampleNumbers.resize (numPackets);
+            lfpEventCodes.resize (numPackets);
+            lfpTimestamps.resize (numPackets);
+        }
+    }
+
+    /** Reads up to one batch of packets from the API; returns the number read */
+    int read()
+    {
+        if (replay != nullptr)
+        {
+            if constexpr (Traits::format == PacketFormat::ELECTRODE_PACKETS)
+                return replay->read (packets.data(), nullptr, readBatchPackets, Time::getHighResolutionTicks());
+            else
+                return replay->read (packetInfo.data(), packetData.data(), readBatchPackets, Time::getHighResolutionTicks());
+        }
+
+        int count = readBatchPackets;
+        Neuropixels::NP_ErrorCode errorCode;
+
+        if constexpr (Traits::format == PacketFormat::ELECTRODE_PACKETS)
+        {
+            errorCode = Neuropixels::readElectrodeData (slot, port, dock, packets.data(), &count, count);
+        }
+        else
+        {
+            errorCode = Neuropixels::readPackets (slot,
+                                                  port,
+                                                  dock,
+                                                  source,
+                                                  packetInfo.data(),
+                                                  packetData.data(),
+                                                  Traits::numChannels,
+                                                  count,
+                                                  &count);
+        }
+
+        if (errorCode != Neuropixels::SUCCESS)
+        {
+            reportReadError (errorCode);
+            return 0;
+        }
+
+        return count;
+    }
+
+    /** Reads the FIFO fill level, for the FIFO monitor and the polling scheduler */
+    void queryFifo (int64 nowTicks)
+    {
+        int packetsAvailable = 0;
+        int headroom = 0;
+
+        if (replay != nullptr)
+        {
+            replay->getFifoState (nowTicks, packetsAvailable, headroom);
+        }
+        else if constexpr (Traits::format == PacketFormat::ELECTRODE_PACKETS)
+        {
+            Neuropixels::getElectrodeDataFifoState (slot, port, dock, &packetsAvailable, &headroom);
+        }
+        else
+        {
+            Neuropixels::getPacketFifoStatus (slot,
+                                              port,
+                                              dock,
+                                              Traits::sharesFifo ? Neuropixels::SourceAP : source,
+                                              &packetsAvailable,
+                                              &headroom);
+        }
+
+        updateFifoFill (packetsAvailable, headroom);
+
+        scheduler.fifoStatusRead (packetsAvailable, headroom, nowTicks);
+    }
+
+    /** Returns the status word of one AP sample */
+    uint16_t getStatus (int packetNum, int i) const
+    {
+        if constexpr (Traits::format == PacketFormat::ELECTRODE_PACKETS)
+            return packets[packetNum].Status[i];
+        else
+            return packetInfo[packetNum].Status;
+    }
+
+    /** Fills sample numbers and timestamps, and records the changes of the inputs in apEvents.
+        Returns the status words of all samples OR-ed together, so that error flags can be
+        detected without a branch per sample */
+    uint16_t extractMetadata (int count)
+    {
+        uint16_t statusFlags = 0;
+        uint16_t lastStatus = apEvents.getLastStatus();
+
+        apEvents.startBatch();
+
+        for (int packetNum = 0; packetNum < count; packetNum++)
+        {
+            for (int i = 0; i < Traits::superFrameSize; i++)
+            {
+                const int sampleIndex = packetNum * Traits::superFrameSize + i;
+
+                uint16_t status;
+                uint32_t npxTimestamp;
+
+                if constexpr (Traits::format == PacketFormat::ELECTRODE_PACKETS)
+                {
+                    status = packets[packetNum].Status[i];
+                    npxTimestamp = packets[packetNum].timestamp[i];
+                }
+                else
+                {
+                    status = packetInfo[packetNum].Status;
+                    npxTimestamp = packetInfo[packetNum].Timestamp;
+                }
+
+                const uint32_t timestampJump = npxTimestamp - lastNpxTimestamp;
+
+                if (timestampJump > MAX_ALLOWABLE_TIMESTAMP_JUMP)
+                {
+                    const int64 numMissing = reportTimestampJump (timestampJump);
+
+                    if (numMissing > 0 && gapFillSettings.mode != GapFiller::OFF)
+                        skipMissingSamples (sampleIndex, packetNum, numMissing);
+                }
+
+                statusFlags |= status;
+
+                // Unwrap the 32-bit counter (the first sample starts from its absolute value, so
+                // that all streams of a basestation share the same tick numbers)
+                hardwareTick += apSampleNumber == 0 ? int64 (npxTimestamp) : int64 (int32_t (timestampJump));
+
+                lastNpxTimestamp = npxTimestamp;
+
+                // The inputs change a few times per second, so one XOR per sample finds all changes
+                if ((status ^ lastStatus) & EventTransitions::statusMask)
+                {
+                    apEvents.add (sampleIndex, apSampleNumber, status);
+                    lastStatus = status;
+                }
+
+                apTimestamps[sampleIndex] = double (hardwareTick);
+                apSampleNumbers[sampleIndex] = apSampleNumber++;
+            }
+
+            if constexpr (Traits::hasLfp)
+            {
+                lfpTimestamps[packetNum] = apTimestamps[packetNum * Traits::superFrameSize];
+                lfpSampleNumbers[packetNum] = lfpSampleNumber++;
+            }
+        }
+
+        return statusFlags;
+    }
+
+    /** Decodes the AP samples of packets [firstPacket, firstPacket + numPackets) and sends them to
+        the outputs. Splitting a batch into chunks keeps the staging block in cache between decoding
+        and the copy made by the DataBuffer, and lets the ActivityView reduce each chunk to a running
+        range per channel while it is still in cache. */
+    void writeApChunk (int firstPacket, int numPackets)
+    {
+        const int firstSample = firstPacket * Traits::superFrameSize;
+        const int numSamples = numPackets * Traits::superFrameSize;
+
+        if constexpr (Traits::format == PacketFormat::ELECTRODE_PACKETS)
+            PacketDecoder::decodeApSuperFrames (packets.data() + firstPacket, numPackets, apScaling, apSamples.data(), numSamples);
+        else
+            PacketDecoder::decode (packetData.data() + (size_t) firstPacket * Traits::numChannels, numPackets, Traits::numChannels, apScaling, apSamples.data(), numSamples);
+
+        if (sendSync)
+            apEvents.expand (apSamples.data() + (size_t) Traits::numChannels * numSamples, firstSample, numSamples);
+
+        apGapFiller.write (apBuffer,
+                           apSamples.data(),
+                           apSampleNumbers.data() + firstSample,
+                           apTimestamps.data() + firstSample,
+                           apEventCodes.data() + firstSample,
+                           numSamples);
+
+        if (apView != nullptr)
+            apView->addToBuffer (apSamples.data(), numSamples, viewBlockIndex);
+
+        if constexpr (Traits::tracksOffsets)
+        {
+            if (probe != nullptr)
+                probe->updateOffsets (apSamples.data(), numSamples, apSampleNumbers[firstSample], true);
+        }
+    }
+
+    /** Expands the changes of the inputs into the per-sample event codes (and the LFP sync channel, if sent) */
+    void writeEventCodes (int count)
+    {
+        const int numSamples = count * Traits::superFrameSize;
+
+        apEvents.expand (apEventCodes.data(), numSamples);
+
+        if constexpr (Traits::hasLfp)
+        {
+            // The LFP sample of a packet takes the inputs of its last AP sample
+            for (int packetNum = 0; packetNum < count; packetNum++)
+                lfpEventCodes[packetNum] = apEventCodes[packetNum * Traits::superFrameSize + Traits::superFrameSize - 1];
+
+            if (sendSync)
+            {
+                float* lfpSync = lfpSamples.data() + (size_t) Traits::numChannels * count;
+
+                for (int packetNum = 0; packetNum < count; packetNum++)
+                    lfpSync[packetNum] = (float) lfpEventCodes[packetNum];
+            }
+        }
+    }
+
+    /** Converts the hardware ticks stored by extractMetadata() to seconds since the start of
+        acquisition, after adding this batch to the basestation's clock model */
+    void convertTimestamps (int count)
+    {
+        const HardwareClock::Fit fit = clock->addObservation (hardwareTick, lastReadTicks);
+
+        apTimestampConverter.convert (fit, apTimestamps.data(), count * Traits::superFrameSize);
+
+        if constexpr (Traits::hasLfp)
+            lfpTimestampConverter.convert (fit, lfpTimestamps.data(), count);
+    }
+
+    /** Advances the sample counters past samples lost before sampleIndex, so that sample
+        numbers follow the hardware timestamp, and registers the gaps to be filled */
+    void skipMissingSamples (int sampleIndex, int packetNum, int64 numMissing)
+    {
+        apGapFiller.addGap (sampleIndex, numMissing);
+        apSampleNumber += numMissing;
+        apSamplesSkipped += numMissing;
+
+        if constexpr (Traits::hasLfp)
+        {
+            // One LFP sample per superframe; the LFP sample of this packet is numbered after the AP loop
+            const int64 lfpMissing = apSamplesSkipped / Traits::superFrameSize - lfpSamplesSkipped;
+
+            if (lfpMissing > 0)
+            {
+                lfpGapFiller.addGap (packetNum, lfpMissing);
+                lfpSampleNumber += lfpMissing;
+                lfpSamplesSkipped += lfpMissing;
+            }
+        }
+    }
+
+    /** Counts the error flags of every sample in a batch that has errors (slow path) */
+    void countStatusErrors (int count)
+    {
+        for (int packetNum = 0; packetNum < count; packetNum++)
+        {
+            for (int i = 0; i < Traits::superFrameSize; i++)
+            {
+                const uint16_t status = getStatus (packetNum, i);
+
+                if (status & StatusErrorCounters::errorMask)
+                    statusErrors->registerStatus (status, apSampleNumbers[packetNum * Traits::superFrameSize + i]);
+            }
+        }
+    }
+
+    std::vector<Neuropixels::electrodePacket> packets;
+    std::vector<Neuropixels::PacketInfo> packetInfo;
+    std::vector<int16_t> packetData;
+
+    std::vector<float> apSamples;
+    std::vector<int64> apSampleNumbers;
+    std::vector<uint64> apEventCodes;
+    std::vector<double> apTimestamps;
+
+    std::vector<float> lfpSamples;
+    std::vector<int64> lfpSampleNumbers;
+    std::vector<uint64> lfpEventCodes;
+    std::vector<double> lfpTimestamps;
+};
+
+#endif // __ACQUISITIONENGINE_H_2C4C2D67__
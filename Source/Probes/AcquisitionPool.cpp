@@ -0,0 +1,236 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "AcquisitionPool.h"
+
+#include <limits>
+
+#if JUCE_WINDOWS
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#elif JUCE_LINUX
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+// Number of streams a single worker is expected to keep up with
+#define STREAMS_PER_WORKER 4
+
+/** Pins the calling thread to one core. Unlike Thread::setCurrentThreadAffinityMask, this
+    supports any number of cores; returns false if the core does not exist or pinning fails */
+static bool pinCurrentThreadToCore (int core)
+{
+    if (! isPositiveAndBelow (core, SystemStats::getNumCpus()))
+        return false;
+
+#if JUCE_WINDOWS
+    // Cores are numbered across processor groups (of up to 64 cores each)
+    const WORD numGroups = GetActiveProcessorGroupCount();
+
+    for (WORD group = 0; group < numGroups; group++)
+    {
+        const int groupSize = (int) GetActiveProcessorCount (group);
+
+        if (core < groupSize)
+        {
+            GROUP_AFFINITY affinity {};
+            affinity.Group = group;
+            affinity.Mask = KAFFINITY (1) << core;
+
+            return SetThreadGroupAffinity (GetCurrentThread(), &affinity, nullptr) != 0;
+        }
+
+        core -= groupSize;
+    }
+
+    return false;
+#elif JUCE_LINUX
+    if (core >= CPU_SETSIZE)
+        return false;
+
+    cpu_set_t cores;
+    CPU_ZERO (&cores);
+    CPU_SET (core, &cores);
+
+    return pthread_setaffinity_np (pthread_self(), sizeof (cores), &cores) == 0;
+#else
+    // Threads cannot be pinned on macOS
+    return false;
+#endif
+}
+
+AcquisitionWorker::AcquisitionWorker (const String& name, int cpuCore_)
+    : Thread (name),
+      cpuCore (cpuCore_)
+{
+}
+
+void AcquisitionWorker::run()
+{
+    pinned = cpuCore >= 0 && pinCurrentThreadToCore (cpuCore);
+
+    if (cpuCore >= 0 && ! pinned)
+        LOGE (getThreadName(), " could not be pinned to core ", cpuCore, " (", SystemStats::getNumCpus(), " cores)");
+
+    const double ticksPerMicrosecond = double (Time::getHighResolutionTicksPerSecond()) / 1.0e6;
+    const int numTasks = tasks.size();
+
+    std::vector<int64> dueTicks ((size_t) numTasks, 0);
+
+    for (auto task : tasks)
+        task->prepareToPoll();
+
+    timer.resetStatistics();
+    busyTicks = 0;
+    numPolls = 0;
+    startTicks = Time::getHighResolutionTicks();
+
+    int firstTask = 0;
+
+    while (! threadShouldExit() && numTasks > 0)
+    {
+        int64 nextDue = std::numeric_limits<int64>::max();
+
+        // Rotate the starting point so that no stream is always served last
+        for (int n = 0; n < numTasks; n++)
+        {
+            const int i = (firstTask + n) % numTasks;
+
+            const int64 now = Time::getHighResolutionTicks();
+
+            if (dueTicks[i] <= now)
+            {
+                const double waitUs = tasks[i]->poll();
+                const int64 afterPoll = Time::getHighResolutionTicks();
+
+                busyTicks += afterPoll - now;
+                numPolls++;
+
+                dueTicks[i] = afterPoll + int64 (waitUs * ticksPerMicrosecond);
+            }
+
+            nextDue = jmin (nextDue, dueTicks[i]);
+        }
+
+        firstTask = (firstTask + 1) % numTasks;
+
+        timer.waitUntil (nextDue, *this);
+    }
+
+    stopTicks = Time::getHighResolutionTicks();
+
+    for (auto task : tasks)
+        task->finishPolling();
+}
+
+String AcquisitionWorker::getSummary() const
+{
+    const int64 elapsedTicks = stopTicks - startTicks;
+
+    if (elapsedTicks <= 0)
+        return "not run";
+
+    auto percent = [&] (int64 ticks)
+    { return String (100.0 * double (ticks) / double (elapsedTicks), 1) + "%"; };
+
+    return String (tasks.size()) + " streams"
+           + (pinned ? " on core " + String (cpuCore) : cpuCore >= 0 ? " (not pinned to core " + String (cpuCore) + ")" : String())
+           + ", busy " + percent (busyTicks)
+           + ", sleep " + percent (timer.getSleepTicks())
+           + ", spin " + percent (timer.getSpinTicks())
+           + ", " + String (numPolls.load()) + " polls";
+}
+
+AcquisitionPool::AcquisitionPool (const String& name_)
+    : name (name_)
+{
+}
+
+AcquisitionPool::~AcquisitionPool()
+{
+    stop();
+}
+
+int AcquisitionPool::getAutomaticNumWorkers (int numTasks)
+{
+    const int maxWorkers = jmax (1, SystemStats::getNumCpus() / 2);
+
+    return jlimit (1, maxWorkers, (numTasks + STREAMS_PER_WORKER - 1) / STREAMS_PER_WORKER);
+}
+
+bool AcquisitionPool::addTasks (const Array<AcquisitionTask*>& newTasks)
+{
+    if (! isEnabled() || newTasks.size() == 0)
+        return false;
+
+    tasks.addArray (newTasks);
+
+    return true;
+}
+
+void AcquisitionPool::start()
+{
+    jassert (workers.size() == 0);
+
+    if (tasks.size() == 0)
+        return;
+
+    int numWorkers = settings.numWorkers < 0 ? getAutomaticNumWorkers (tasks.size())
+                                             : jmin (settings.numWorkers, tasks.size());
+
+    for (int i = 0; i < numWorkers; i++)
+    {
+        const int cpuCore = settings.cpuCores.size() > 0 ? settings.cpuCores[i % settings.cpuCores.size()] : -1;
+
+        workers.add (new AcquisitionWorker (name + " worker " + String (i), cpuCore));
+    }
+
+    for (int i = 0; i < tasks.size(); i++)
+        workers[i % numWorkers]->addTask (tasks[i]);
+
+    LOGC (name, ": running ", tasks.size(), " streams on ", numWorkers, " threads");
+
+    for (auto worker : workers)
+        worker->startThread (Thread::Priority::highest);
+}
+
+void AcquisitionPool::stop()
+{
+    for (auto worker : workers)
+        worker->signalThreadShouldExit();
+
+    for (auto worker : workers)
+    {
+        worker->stopThread (1000);
+
+        LOGC (worker->getThreadName(), ": ", worker->getSummary());
+    }
+
+    workers.clear();
+    tasks.clear();
+}
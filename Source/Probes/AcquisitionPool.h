@@ -0,0 +1,152 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __ACQUISITIONPOOL_H_2C4C2D67__
+#define __ACQUISITIONPOOL_H_2C4C2D67__
+
+#include "PollingScheduler.h"
+
+/**
+
+	A stream that can be serviced either by its own thread or by
+	an AcquisitionPool worker. All methods are called on the thread
+	that services the stream.
+
+*/
+class AcquisitionTask
+{
+public:
+    /** Destructor */
+    virtual ~AcquisitionTask() {}
+
+    /** Resets timing state; called before the first poll() */
+    virtual void prepareToPoll() = 0;
+
+    /** Reads and processes whatever data is ready, and returns
+        the number of microseconds until the next poll is due */
+    virtual double poll() = 0;
+
+    /** Called after the last poll() */
+    virtual void finishPolling() {}
+};
+
+/**
+
+	Services a list of AcquisitionTasks from one thread, always
+	polling the task whose deadline comes first.
+
+*/
+class AcquisitionWorker : public Thread
+{
+public:
+    /** Constructor -- cpuCore < 0 leaves the thread unpinned */
+    AcquisitionWorker (const String& name, int cpuCore);
+
+    /** Adds a task; only call before the thread is started */
+    void addTask (AcquisitionTask* task) { tasks.add (task); }
+
+    /** Returns the number of tasks serviced by this worker */
+    int getNumTasks() const { return tasks.size(); }
+
+    /** Polls tasks until the thread is asked to exit */
+    void run() override;
+
+    /** Returns a one-line summary of how the worker spent its time */
+    String getSummary() const;
+
+private:
+    Array<AcquisitionTask*> tasks;
+
+    const int cpuCore;
+    std::atomic<bool> pinned { false };
+
+    DeadlineTimer timer;
+
+    std::atomic<int64> startTicks { 0 };
+    std::atomic<int64> stopTicks { 0 };
+    std::atomic<int64> busyTicks { 0 };
+    std::atomic<int64> numPolls { 0 };
+};
+
+/**
+
+	Runs the acquisition for all data sources on a basestation on a
+	small number of worker threads, instead of one thread per stream.
+
+	Tasks are added by the data sources as acquisition starts, and are
+	distributed round-robin across the workers when start() is called.
+	Workers can be pinned to specific cores and run at the highest
+	thread priority the OS allows.
+
+	Configured with the "NP THREADS" config message.
+
+*/
+class AcquisitionPool
+{
+public:
+    /** Thread configuration for one basestation */
+    struct Settings
+    {
+        /** Number of worker threads (0 = one thread per stream, -1 = automatic) */
+        int numWorkers = 0;
+
+        /** Cores to pin workers to, assigned in order (empty = no pinning) */
+        Array<int> cpuCores;
+    };
+
+    /** Constructor */
+    AcquisitionPool (const String& name);
+
+    /** Destructor */
+    ~AcquisitionPool();
+
+    /** Returns true if streams should be run by the pool rather than by their own threads */
+    bool isEnabled() const { return settings.numWorkers != 0; }
+
+    /** Queues tasks to be run when start() is called; returns false (and queues nothing)
+        if the pool is disabled or there are no tasks, in which case the caller must
+        start its own thread */
+    bool addTasks (const Array<AcquisitionTask*>& tasks);
+
+    /** Starts the workers for all queued tasks */
+    void start();
+
+    /** Stops the workers, logs their summaries and clears the task list */
+    void stop();
+
+    /** Returns the number of worker threads currently running */
+    int getNumWorkers() const { return workers.size(); }
+
+    /** Returns the number of workers used for numTasks tasks when numWorkers is automatic */
+    static int getAutomaticNumWorkers (int numTasks);
+
+    Settings settings;
+
+private:
+    String name;
+
+    Array<AcquisitionTask*> tasks;
+    OwnedArray<AcquisitionWorker> workers;
+};
+
+#endif // __ACQUISITIONPOOL_H_2C4C2D67__
@@ -0,0 +1,116 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "BufferBudget.h"
+
+#include <cmath>
+
+// Shortest time a buffer holds, whatever the budget; several maximum-size read batches (1024 superframes)
+#define MIN_BUFFER_SECONDS 1.0
+
+int64 BufferBudget::getBytesPerSample (int numChannels)
+{
+    return int64 (numChannels) * int64 (sizeof (float)) + int64 (sizeof (int64) + sizeof (double) + sizeof (uint64));
+}
+
+void BufferBudget::clear()
+{
+    streams.clear();
+
+    bufferSeconds = 0.0;
+    totalBytes = 0;
+    overBudget = false;
+}
+
+void BufferBudget::addStream (const String& name, int numChannels, double sampleRate)
+{
+    Stream stream;
+    stream.name = name;
+    stream.numChannels = numChannels;
+    stream.sampleRate = sampleRate;
+
+    streams.push_back (stream);
+}
+
+void BufferBudget::allocate()
+{
+    double bytesPerSecond = 0.0;
+
+    for (const auto& stream : streams)
+        bytesPerSecond += stream.sampleRate * double (getBytesPerSample (stream.numChannels));
+
+    bufferSeconds = jmax (MIN_BUFFER_SECONDS, settings.maxStallSeconds);
+    overBudget = false;
+
+    if (settings.budgetMegabytes > 0 && bytesPerSecond > 0.0)
+    {
+        const double budgetSeconds = double (settings.budgetMegabytes) * 1024.0 * 1024.0 / bytesPerSecond;
+
+        if (budgetSeconds < MIN_BUFFER_SECONDS)
+            overBudget = true;
+
+        bufferSeconds = jlimit (MIN_BUFFER_SECONDS, bufferSeconds, budgetSeconds);
+    }
+
+    totalBytes = 0;
+
+    for (auto& stream : streams)
+    {
+        stream.numSamples = (int) std::ceil (stream.sampleRate * bufferSeconds);
+        stream.bytes = int64 (stream.numSamples) * getBytesPerSample (stream.numChannels);
+
+        totalBytes += stream.bytes;
+    }
+}
+
+String BufferBudget::getReportString() const
+{
+    Array<var> entries;
+
+    for (const auto& stream : streams)
+    {
+        DynamicObject::Ptr s = new DynamicObject();
+
+        s->setProperty (Identifier ("name"), stream.name);
+        s->setProperty (Identifier ("channels"), stream.numChannels);
+        s->setProperty (Identifier ("sample_rate_hz"), stream.sampleRate);
+        s->setProperty (Identifier ("samples"), stream.numSamples);
+        s->setProperty (Identifier ("megabytes"), double (stream.bytes) / (1024.0 * 1024.0));
+
+        entries.add (s.get());
+    }
+
+    DynamicObject output;
+
+    output.setProperty (Identifier ("max_stall_s"), settings.maxStallSeconds);
+    output.setProperty (Identifier ("budget_megabytes"), settings.budgetMegabytes);
+    output.setProperty (Identifier ("buffer_s"), bufferSeconds);
+    output.setProperty (Identifier ("total_megabytes"), double (totalBytes) / (1024.0 * 1024.0));
+    output.setProperty (Identifier ("over_budget"), overBudget);
+    output.setProperty (Identifier ("streams"), entries);
+
+    MemoryOutputStream f;
+    output.writeAsJSON (f, JSON::FormatOptions {}.withIndentLevel (0).withSpacing (JSON::Spacing::singleLine).withMaxDecimalPlaces (4));
+
+    return f.toString();
+}
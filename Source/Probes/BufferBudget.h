@@ -0,0 +1,109 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __BUFFERBUDGET_H_2C4C2D67__
+#define __BUFFERBUDGET_H_2C4C2D67__
+
+#include <DataThreadHeaders.h>
+
+#include <vector>
+
+/**
+
+	Sizes the DataBuffers that hold each stream's samples until the
+	SourceNode reads them.
+
+	Every buffer holds the same length of time: the configured maximum
+	downstream stall, reduced if all buffers together would exceed the
+	memory budget (but never below MIN_BUFFER_SECONDS, which always fits
+	several of the largest read batches). Buffers therefore scale with
+	each stream's sample rate and channel count, rather than holding a
+	fixed number of samples.
+
+*/
+class BufferBudget
+{
+public:
+    /** User-configurable limits, shared by all streams of the plugin */
+    struct Settings
+    {
+        /** Time the buffers can absorb while the signal chain is not reading them */
+        double maxStallSeconds = 5.0;
+
+        /** Memory available to all source buffers together (0 = no limit) */
+        int64 budgetMegabytes = 4096;
+    };
+
+    /** One stream's buffer */
+    struct Stream
+    {
+        String name;
+        int numChannels = 0;
+        double sampleRate = 0.0;
+
+        int numSamples = 0; // set by allocate()
+        int64 bytes = 0;
+    };
+
+    /** Returns the bytes a DataBuffer uses per sample (the channels, plus a sample number,
+        a timestamp and an event code) */
+    static int64 getBytesPerSample (int numChannels);
+
+    /** Removes all streams */
+    void clear();
+
+    /** Adds a stream; streams are numbered in the order they are added */
+    void addStream (const String& name, int numChannels, double sampleRate);
+
+    /** Computes the size of every stream's buffer from the settings */
+    void allocate();
+
+    /** Returns the number of streams */
+    int getNumStreams() const { return (int) streams.size(); }
+
+    /** Returns a stream's buffer size, after allocate() */
+    const Stream& getStream (int index) const { return streams[(size_t) index]; }
+
+    /** Returns the time every buffer can absorb, after allocate() */
+    double getBufferSeconds() const { return bufferSeconds; }
+
+    /** Returns the bytes allocated for all streams, after allocate() */
+    int64 getTotalBytes() const { return totalBytes; }
+
+    /** Returns true if even the minimum buffer sizes exceed the budget */
+    bool exceedsBudget() const { return overBudget; }
+
+    /** Returns the settings and every stream's buffer as a single-line JSON string */
+    String getReportString() const;
+
+    Settings settings;
+
+private:
+    std::vector<Stream> streams;
+
+    double bufferSeconds = 0.0;
+    int64 totalBytes = 0;
+    bool overBudget = false;
+};
+
+#endif // __BUFFERBUDGET_H_2C4C2D67__
@@ -0,0 +1,176 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "CaptureReplay.h"
+
+// Capacity of the simulated FIFO, in seconds of data
+#define REPLAY_FIFO_SECONDS 1.0
+
+// Timestamps at the start of an electrodePacket record (one per AP sample of the superframe)
+#define ELECTRODE_PACKET_TIMESTAMPS 12
+
+bool CaptureReplay::open (const File& file)
+{
+    mappedFile = std::make_unique<MemoryMappedFile> (file, MemoryMappedFile::readOnly);
+
+    if (mappedFile->getData() == nullptr || mappedFile->getSize() < sizeof (PacketCapture::FileHeader))
+    {
+        LOGE ("Unable to open packet capture file ", file.getFullPathName());
+        mappedFile.reset();
+        return false;
+    }
+
+    memcpy (&header, mappedFile->getData(), sizeof (header));
+
+    recordBytes = int (header.headerBytes + header.payloadBytes);
+
+    if (memcmp (header.magic, "NPXCAP1", 8) != 0
+        || header.version != PacketCapture::currentVersion
+        || recordBytes <= 0
+        || header.packetIntervalUs <= 0.0
+        || mappedFile->getSize() < header.dataOffset + header.capacityRecords * uint64 (recordBytes))
+    {
+        LOGE ("Not a valid packet capture file: ", file.getFullPathName());
+        mappedFile.reset();
+        return false;
+    }
+
+    // Once the ring has wrapped, the oldest record is the one after the newest
+    if (header.numRecordsWritten > header.capacityRecords)
+    {
+        numRecords = int64 (header.capacityRecords);
+        firstRecord = int64 (header.numRecordsWritten % header.capacityRecords);
+    }
+    else
+    {
+        numRecords = int64 (header.numRecordsWritten);
+        firstRecord = 0;
+    }
+
+    // Every record starts with the 100 kHz timestamp of its first sample
+    if (numRecords > 0)
+    {
+        uint32 firstTimestamp, lastTimestamp;
+        memcpy (&firstTimestamp, getRecord (0), sizeof (uint32));
+        memcpy (&lastTimestamp, getRecord (numRecords - 1), sizeof (uint32));
+
+        loopTimestampSpan = lastTimestamp - firstTimestamp + uint32 (roundToInt (header.packetIntervalUs / 10.0));
+    }
+
+    LOGC ("Opened packet capture ", file.getFullPathName(), " (", header.partNumber, ", ", numRecords, " packets)");
+
+    return numRecords > 0;
+}
+
+const char* CaptureReplay::getRecord (int64 i) const
+{
+    const int64 slot = (firstRecord + i) % int64 (header.capacityRecords);
+
+    return static_cast<const char*> (mappedFile->getData()) + header.dataOffset + slot * recordBytes;
+}
+
+void CaptureReplay::start (int64 nowTicks)
+{
+    const double packetIntervalUs = header.packetIntervalUs / jmax (speed, 1.0e-6);
+
+    fifo.start (packetIntervalUs, int (REPLAY_FIFO_SECONDS * 1.0e6 / header.packetIntervalUs), nowTicks);
+
+    numOverflowedAtLastRead = 0;
+    position = 0;
+}
+
+void CaptureReplay::copyRecord (int64 index, char* headerOut, char* payloadOut) const
+{
+    const char* record = getRecord (index % numRecords);
+
+    memcpy (headerOut, record, header.headerBytes);
+
+    if (header.payloadBytes > 0)
+        memcpy (payloadOut, record + header.headerBytes, header.payloadBytes);
+
+    const uint32 shift = uint32 (index / numRecords) * loopTimestampSpan;
+
+    if (shift == 0)
+        return;
+
+    const int numTimestamps = header.format == 0 ? ELECTRODE_PACKET_TIMESTAMPS : 1;
+
+    for (int i = 0; i < numTimestamps; i++)
+    {
+        uint32 timestamp;
+        memcpy (&timestamp, headerOut + i * sizeof (uint32), sizeof (uint32));
+        timestamp += shift;
+        memcpy (headerOut + i * sizeof (uint32), &timestamp, sizeof (uint32));
+    }
+}
+
+int CaptureReplay::read (void* headers, void* payloads, int maxRecords, int64 nowTicks)
+{
+    if (mappedFile == nullptr || isFinished())
+        return 0;
+
+    int count = maxRecords;
+
+    if (speed > 0.0)
+    {
+        count = fifo.read (maxRecords, nowTicks);
+
+        // Packets that overflowed the FIFO are skipped, as they would be on the hardware
+        const int64 numOverflowed = fifo.getNumOverflowedPackets();
+        position += numOverflowed - numOverflowedAtLastRead;
+        numOverflowedAtLastRead = numOverflowed;
+    }
+
+    if (! looping)
+        count = (int) jlimit (int64 (0), numRecords - jmin (position, numRecords), int64 (count));
+
+    char* headerOut = static_cast<char*> (headers);
+    char* payloadOut = static_cast<char*> (payloads);
+
+    for (int i = 0; i < count; i++)
+    {
+        copyRecord (position++, headerOut, payloadOut);
+
+        headerOut += header.headerBytes;
+
+        if (header.payloadBytes > 0)
+            payloadOut += header.payloadBytes;
+    }
+
+    return count;
+}
+
+void CaptureReplay::getFifoState (int64 nowTicks, int& packetsAvailable, int& headroom) const
+{
+    if (speed > 0.0)
+    {
+        packetsAvailable = fifo.getPacketsAvailable (nowTicks);
+        headroom = fifo.getHeadroom (nowTicks);
+    }
+    else
+    {
+        packetsAvailable = 0;
+        headroom = 1;
+    }
+}
@@ -0,0 +1,106 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef __CAPTUREREPLAY_H_2C4C2D67__
+#define __CAPTUREREPLAY_H_2C4C2D67__
+
+#include "PacketCapture.h"
+#include "PollingScheduler.h"
+
+/**
+
+	Plays back a file written by PacketCapture, so that the packets can be
+	fed to an AcquisitionEngine in place of the Neuropixels API.
+
+	Records are read oldest first. Packets become available at the
+	nominal packet rate multiplied by the replay speed (via a
+	SimulatedFifo, so packets are dropped if the reader falls too far
+	behind, like on the hardware), or all at once if the speed is 0.
+
+	When looping, the 100 kHz timestamps of each pass are shifted by the
+	duration of the capture, so that they keep increasing as they would
+	on the hardware.
+
+*/
+class CaptureReplay
+{
+public:
+    /** Maps a capture file; returns false if it cannot be read */
+    bool open (const File& file);
+
+    /** Returns the header of the open file */
+    const PacketCapture::FileHeader& getHeader() const { return header; }
+
+    /** Returns the number of records that can be replayed */
+    int64 getNumRecords() const { return numRecords; }
+
+    /** Sets the replay rate relative to real time (0 = as fast as possible) */
+    void setSpeed (double speed_) { speed = jmax (0.0, speed_); }
+
+    /** Returns the replay rate relative to real time */
+    double getSpeed() const { return speed; }
+
+    /** Determines whether playback restarts from the first record after the last one */
+    void setLooping (bool shouldLoop) { looping = shouldLoop; }
+
+    /** Rewinds to the first record and starts the packet clock */
+    void start (int64 nowTicks);
+
+    /** Copies up to maxRecords available records into separate header and payload
+        buffers (payloads may be null if the file has no payload); returns the number copied */
+    int read (void* headers, void* payloads, int maxRecords, int64 nowTicks);
+
+    /** Returns the simulated FIFO fill level */
+    void getFifoState (int64 nowTicks, int& packetsAvailable, int& headroom) const;
+
+    /** Returns the number of packets dropped because they were not read in time */
+    int64 getNumOverflowedPackets() const { return fifo.getNumOverflowedPackets(); }
+
+    /** Returns true once every record has been read (never true when looping) */
+    bool isFinished() const { return ! looping && position >= numRecords; }
+
+private:
+    /** Returns record i, counting from the oldest record in the file */
+    const char* getRecord (int64 i) const;
+
+    /** Copies record `index` (counting from the start of playback) into the output buffers */
+    void copyRecord (int64 index, char* headerOut, char* payloadOut) const;
+
+    std::unique_ptr<MemoryMappedFile> mappedFile;
+    PacketCapture::FileHeader header;
+
+    int recordBytes = 0;
+    int64 numRecords = 0;
+    int64 firstRecord = 0; // ring slot of the oldest record
+    uint32 loopTimestampSpan = 0; // 100 kHz ticks from the first record of one pass to the first of the next
+
+    double speed = 1.0;
+    bool looping = true;
+
+    SimulatedFifo fifo;
+    int64 numOverflowedAtLastRead = 0;
+    int64 position = 0; // records played (or skipped) since start(), across passes
+};
+
+#endif // __CAPTUREREPLAY_H_2C4C2D67__
@@ -0,0 +1,99 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "EventTransitions.h"
+
+void EventTransitions::reset (uint64 invertMask_)
+{
+    invertMask = invertMask_;
+    lastStatus = 0;
+    eventCode = invertMask;
+
+    transitions.clear();
+    transitions.reserve (64);
+
+    runs.clear();
+    runs.reserve (64);
+
+    filledCount = 0;
+
+    startBatch();
+}
+
+void EventTransitions::startBatch()
+{
+    transitions.clear();
+    runs.clear();
+
+    runs.push_back ({ 0, eventCode });
+}
+
+void EventTransitions::add (int sampleIndex, int64 sampleNumber, uint16_t status)
+{
+    uint32 changed = uint32 ((status ^ lastStatus) & statusMask) >> statusShift;
+
+    lastStatus = status;
+    eventCode = uint64 (status >> statusShift) ^ invertMask; // AUX_IO<0:13>
+
+    for (int bit = 0; changed != 0; bit++, changed >>= 1)
+    {
+        if (changed & 1)
+            transitions.push_back ({ sampleIndex, sampleNumber, (uint8) bit, ((eventCode >> bit) & 1) != 0 });
+    }
+
+    if (runs.back().startIndex == sampleIndex)
+        runs.back().eventCode = eventCode;
+    else
+        runs.push_back ({ sampleIndex, eventCode });
+}
+
+void EventTransitions::expand (uint64* eventCodes, int numSamples)
+{
+    if (runs.size() == 1 && runs[0].eventCode == filledCode && numSamples <= filledCount)
+        return;
+
+    for (size_t r = 0; r < runs.size(); r++)
+    {
+        const int end = r + 1 < runs.size() ? runs[r + 1].startIndex : numSamples;
+
+        std::fill (eventCodes + runs[r].startIndex, eventCodes + end, runs[r].eventCode);
+    }
+
+    filledCode = runs[0].eventCode;
+    filledCount = runs.size() == 1 ? numSamples : 0;
+}
+
+void EventTransitions::expand (float* syncChannel, int startIndex, int numSamples) const
+{
+    const int endIndex = startIndex + numSamples;
+
+    for (size_t r = 0; r < runs.size(); r++)
+    {
+        const int runStart = jmax (runs[r].startIndex, startIndex);
+        const int runEnd = r + 1 < runs.size() ? jmin (runs[r + 1].startIndex, endIndex) : endIndex;
+
+        if (runStart < runEnd)
+            std::fill (syncChannel + (runStart - startIndex), syncChannel + (runEnd - startIndex), (float) runs[r].eventCode);
+    }
+}
@@ -0,0 +1,106 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef __EVENTTRANSITIONS_H_2C4C2D67__
+#define __EVENTTRANSITIONS_H_2C4C2D67__
+
+#include <DataThreadHeaders.h>
+
+#include <vector>
+
+/**
+
+	Changes of one stream's digital inputs (the sync and AUX bits of the
+	packet status words) within a batch.
+
+	Acquisition loops compare each status word with the previous one
+	(a single XOR for all inputs) and only call add() when an input
+	changed, which happens a few times per second. The per-sample event
+	codes that DataBuffer requires, and the float sync channel, are then
+	expanded from the list in runs; the event code buffer is not touched
+	at all for batches in which no input changed.
+
+*/
+class EventTransitions
+{
+public:
+    /** One input changing state */
+    struct Transition
+    {
+        int sampleIndex; // index of the first sample with the new state, within the batch
+        int64 sampleNumber;
+        uint8 bit; // event code bit (0 = sync input)
+        bool rising;
+    };
+
+    /** Status word bits that carry the inputs (event code bit 0 = status bit 6) */
+    static constexpr uint16_t statusMask = 0xFFC0;
+    static constexpr int statusShift = 6;
+
+    /** Clears the list and sets all inputs low (call before acquisition starts) */
+    void reset (uint64 invertMask);
+
+    /** Starts a new batch */
+    void startBatch();
+
+    /** Returns the status word the next sample should be compared with */
+    uint16_t getLastStatus() const { return lastStatus; }
+
+    /** Records the inputs that changed at a sample (only called when (status ^ getLastStatus()) & statusMask) */
+    void add (int sampleIndex, int64 sampleNumber, uint16_t status);
+
+    /** Writes the event code of every sample in the batch */
+    void expand (uint64* eventCodes, int numSamples);
+
+    /** Writes the event codes of samples [startIndex, startIndex + numSamples) of the batch
+        as floats, from syncChannel[0] on (for the sync channel) */
+    void expand (float* syncChannel, int startIndex, int numSamples) const;
+
+    /** Returns the changes in the current batch */
+    const std::vector<Transition>& getTransitions() const { return transitions; }
+
+    /** Returns the event code after the most recent sample */
+    uint64 getEventCode() const { return eventCode; }
+
+private:
+    /** Samples from startIndex have the same event code */
+    struct Run
+    {
+        int startIndex;
+        uint64 eventCode;
+    };
+
+    uint64 invertMask = 0;
+    uint16_t lastStatus = 0;
+    uint64 eventCode = 0;
+
+    std::vector<Transition> transitions;
+    std::vector<Run> runs;
+
+    /** The first filledCount entries of the event code buffer are known to hold filledCode */
+    uint64 filledCode = 0;
+    int filledCount = 0;
+};
+
+#endif // __EVENTTRANSITIONS_H_2C4C2D67__
@@ -0,0 +1,206 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "GapFiller.h"
+
+#include <limits>
+
+// Samples per addToBuffer() call when a batch is split around gaps
+#define GAP_CHUNK_SAMPLES 1024
+
+String GapFiller::getModeName (Mode mode)
+{
+    switch (mode)
+    {
+        case ADVANCE:
+            return "ADVANCE";
+        case ZERO:
+            return "ZERO";
+        case HOLD:
+            return "HOLD";
+        case FILL_NAN:
+            return "NAN";
+        default:
+            return "OFF";
+    }
+}
+
+bool GapFiller::parseMode (const String& name, Mode& mode)
+{
+    for (Mode m : { OFF, ADVANCE, ZERO, HOLD, FILL_NAN })
+    {
+        if (name.equalsIgnoreCase (getModeName (m)))
+        {
+            mode = m;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void GapFiller::prepare (const Settings& settings_, int numDataChannels_, int numChannels_, double sampleRate_)
+{
+    settings = settings_;
+    numDataChannels = numDataChannels_;
+    numChannels = numChannels_;
+    sampleRate = sampleRate_;
+
+    gaps.clear();
+    lastEventCode = 0;
+
+    if (settings.mode < ZERO)
+        return;
+
+    gaps.reserve (16);
+    lastValues.assign (numChannels, 0.0f);
+
+    scratchSamples.resize ((size_t) numChannels * GAP_CHUNK_SAMPLES);
+    scratchSampleNumbers.resize (GAP_CHUNK_SAMPLES);
+    scratchTimestamps.resize (GAP_CHUNK_SAMPLES);
+    scratchEventCodes.resize (GAP_CHUNK_SAMPLES);
+}
+
+void GapFiller::addGap (int sampleIndex, int64 numMissing)
+{
+    if (settings.mode < ZERO || numMissing > settings.maxFillSamples)
+        return;
+
+    gaps.push_back ({ sampleIndex, int (numMissing) });
+}
+
+void GapFiller::write (DataBuffer* buffer,
+                       float* samples,
+                       int64* sampleNumbers,
+                       double* timestamps,
+                       uint64* eventCodes,
+                       int numSamples)
+{
+    if (settings.mode < ZERO)
+    {
+        if (buffer != nullptr)
+            buffer->addToBuffer (samples, sampleNumbers, timestamps, eventCodes, numSamples);
+
+        return;
+    }
+
+    if (buffer != nullptr)
+    {
+        if (gaps.empty())
+        {
+            buffer->addToBuffer (samples, sampleNumbers, timestamps, eventCodes, numSamples);
+        }
+        else
+        {
+            int position = 0;
+
+            for (const Gap& gap : gaps)
+            {
+                writeSegment (buffer, samples, sampleNumbers, timestamps, eventCodes, numSamples, position, gap.sampleIndex - position);
+
+                const int64 nextSampleNumber = sampleNumbers[gap.sampleIndex];
+                const double nextTimestamp = timestamps[gap.sampleIndex];
+
+                if (gap.sampleIndex > 0)
+                    writeFill (buffer, gap, nextSampleNumber, nextTimestamp, samples + gap.sampleIndex - 1, numSamples, eventCodes[gap.sampleIndex - 1]);
+                else
+                    writeFill (buffer, gap, nextSampleNumber, nextTimestamp, lastValues.data(), 1, lastEventCode);
+
+                position = gap.sampleIndex;
+            }
+
+            writeSegment (buffer, samples, sampleNumbers, timestamps, eventCodes, numSamples, position, numSamples - position);
+        }
+    }
+
+    gaps.clear();
+
+    rememberLastSample (samples, eventCodes, numSamples);
+}
+
+void GapFiller::writeSegment (DataBuffer* buffer, const float* samples, int64* sampleNumbers, double* timestamps, uint64* eventCodes, int numSamples, int start, int length)
+{
+    while (length > 0)
+    {
+        const int chunk = jmin (length, GAP_CHUNK_SAMPLES);
+
+        for (int ch = 0; ch < numChannels; ch++)
+            memcpy (scratchSamples.data() + (size_t) ch * chunk, samples + (size_t) ch * numSamples + start, (size_t) chunk * sizeof (float));
+
+        buffer->addToBuffer (scratchSamples.data(), sampleNumbers + start, timestamps + start, eventCodes + start, chunk);
+
+        start += chunk;
+        length -= chunk;
+    }
+}
+
+void GapFiller::writeFill (DataBuffer* buffer, const Gap& gap, int64 nextSampleNumber, double nextTimestamp, const float* holdValues, int holdStride, uint64 eventCode)
+{
+    const int64 firstSampleNumber = nextSampleNumber - gap.numMissing;
+    const double firstTimestamp = nextTimestamp - double (gap.numMissing) / sampleRate;
+
+    for (int filled = 0; filled < gap.numMissing;)
+    {
+        const int chunk = jmin (gap.numMissing - filled, GAP_CHUNK_SAMPLES);
+
+        for (int ch = 0; ch < numChannels; ch++)
+        {
+            float value;
+
+            if (ch >= numDataChannels)
+                value = (float) eventCode; // sync channel keeps the last state of the inputs
+            else if (settings.mode == HOLD)
+                value = holdValues[(size_t) ch * holdStride];
+            else if (settings.mode == FILL_NAN)
+                value = std::numeric_limits<float>::quiet_NaN();
+            else
+                value = 0.0f;
+
+            std::fill_n (scratchSamples.data() + (size_t) ch * chunk, chunk, value);
+        }
+
+        for (int i = 0; i < chunk; i++)
+        {
+            scratchSampleNumbers[i] = firstSampleNumber + filled + i;
+            scratchTimestamps[i] = firstTimestamp + double (filled + i) / sampleRate;
+        }
+
+        std::fill_n (scratchEventCodes.data(), chunk, eventCode);
+
+        buffer->addToBuffer (scratchSamples.data(), scratchSampleNumbers.data(), scratchTimestamps.data(), scratchEventCodes.data(), chunk);
+
+        filled += chunk;
+    }
+}
+
+void GapFiller::rememberLastSample (const float* samples, const uint64* eventCodes, int numSamples)
+{
+    if (numSamples == 0)
+        return;
+
+    for (int ch = 0; ch < numChannels; ch++)
+        lastValues[ch] = samples[(size_t) ch * numSamples + numSamples - 1];
+
+    lastEventCode = eventCodes[numSamples - 1];
+}
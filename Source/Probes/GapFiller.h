@@ -0,0 +1,126 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef __GAPFILLER_H_2C4C2D67__
+#define __GAPFILLER_H_2C4C2D67__
+
+#include <DataThreadHeaders.h>
+
+#include <vector>
+
+/**
+
+	Writes one stream's decoded batches to its DataBuffer, inserting fill
+	samples where the hardware timestamp showed that samples were lost.
+
+	When gap reconstruction is enabled, the acquisition engine advances
+	its sample counter by the number of missing samples at each timestamp
+	jump, so sample numbers stay locked to hardware time, and registers
+	the gap with addGap(). write() then sends the batch in segments, with
+	the missing samples (zero, the last value before the gap, or NaN)
+	added in bulk between them. Batches without gaps are passed to the
+	DataBuffer unchanged.
+
+*/
+class GapFiller
+{
+public:
+    enum Mode
+    {
+        OFF = 0, // sample numbers ignore lost samples
+        ADVANCE, // sample numbers skip lost samples; nothing is inserted
+        ZERO, // lost samples are inserted as zeros
+        HOLD, // lost samples repeat the last sample before the gap
+        FILL_NAN // lost samples are inserted as NaN
+    };
+
+    /** User-configurable gap handling, stored per probe */
+    struct Settings
+    {
+        Mode mode = OFF;
+
+        /** Longest gap that is filled; longer gaps only advance the sample numbers */
+        int maxFillSamples = 30000;
+    };
+
+    /** Returns the name of a mode, as used by the "NP GAPFILL" config message */
+    static String getModeName (Mode mode);
+
+    /** Parses a mode name; returns false if it is not recognized */
+    static bool parseMode (const String& name, Mode& mode);
+
+    /** Applies the settings and allocates the buffers used to write segments;
+        numChannels includes the sync channel, if there is one */
+    void prepare (const Settings& settings, int numDataChannels, int numChannels, double sampleRate);
+
+    /** Registers missing samples before the sample at sampleIndex in the current batch */
+    void addGap (int sampleIndex, int64 numMissing);
+
+    /** Returns true if gaps were registered in the current batch (which must then be written in one call) */
+    bool hasGaps() const { return ! gaps.empty(); }
+
+    /** Writes a channel-major batch (and any fill samples) to the buffer (which may be null),
+        then clears the gaps */
+    void write (DataBuffer* buffer,
+                float* samples,
+                int64* sampleNumbers,
+                double* timestamps,
+                uint64* eventCodes,
+                int numSamples);
+
+private:
+    /** Samples are lost before sampleIndex */
+    struct Gap
+    {
+        int sampleIndex;
+        int numMissing;
+    };
+
+    /** Writes samples [start, start + length) of the batch through the scratch buffer */
+    void writeSegment (DataBuffer* buffer, const float* samples, int64* sampleNumbers, double* timestamps, uint64* eventCodes, int numSamples, int start, int length);
+
+    /** Writes the fill samples for one gap, numbered and timed backwards from the first sample after it */
+    void writeFill (DataBuffer* buffer, const Gap& gap, int64 nextSampleNumber, double nextTimestamp, const float* holdValues, int holdStride, uint64 eventCode);
+
+    /** Stores the last sample of the batch, for gaps at the start of the next batch */
+    void rememberLastSample (const float* samples, const uint64* eventCodes, int numSamples);
+
+    Settings settings;
+
+    int numDataChannels = 0;
+    int numChannels = 0;
+    double sampleRate = 30000.0;
+
+    std::vector<Gap> gaps;
+
+    std::vector<float> lastValues;
+    uint64 lastEventCode = 0;
+
+    std::vector<float> scratchSamples;
+    std::vector<int64> scratchSampleNumbers;
+    std::vector<double> scratchTimestamps;
+    std::vector<uint64> scratchEventCodes;
+};
+
+#endif // __GAPFILLER_H_2C4C2D67__
@@ -0,0 +1,198 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "HardwareClock.h"
+
+// Observations, and the span they cover, needed before the least-squares fit is used
+#define MIN_OBSERVATIONS_FOR_FIT 1000
+#define MIN_FIT_SPAN_SECONDS 2.0
+
+// Reads later than this (and, once the fit is used, than REJECTION_RESIDUALS x the RMS residual) are rejected
+#define MIN_REJECTION_SECONDS 0.001
+#define REJECTION_RESIDUALS 4.0
+
+// Fastest change of the published offset, in seconds per second of hardware time
+#define MAX_OFFSET_SLEW 0.001
+
+HardwareClock::HardwareClock()
+{
+    reset (Time::getHighResolutionTicks());
+}
+
+void HardwareClock::reset (int64 startTicks_)
+{
+    const SpinLock::ScopedLockType sl (lock);
+
+    startTicks = startTicks_;
+    firstTick = 0;
+    numRejected = 0;
+    lastX = 0.0;
+    minNominalOffset = 0.0;
+    published = Fit();
+
+    regression.reset();
+}
+
+HardwareClock::Fit HardwareClock::addObservation (int64 hardwareTick, int64 hostTicks)
+{
+    const SpinLock::ScopedLockType sl (lock);
+
+    if (regression.getNumPoints() == 0)
+        firstTick = hardwareTick;
+
+    const double x = double (hardwareTick - firstTick);
+    const double y = Time::highResolutionTicksToSeconds (hostTicks - startTicks);
+    const double nominalOffset = y - x / nominalTicksPerSecond;
+
+    if (regression.getNumPoints() == 0)
+    {
+        minNominalOffset = nominalOffset;
+        regression.add (x, y);
+        published = computeFit();
+        lastX = x;
+
+        return published;
+    }
+
+    // Until the fit is used, the earliest read at the nominal rate is the best estimate of the latency
+    const double lateness = isSettled() ? y - regression.predict (x, 1.0 / nominalTicksPerSecond)
+                                        : nominalOffset - minNominalOffset;
+
+    const double maxLateness = isSettled() ? jmax (MIN_REJECTION_SECONDS, REJECTION_RESIDUALS * regression.getRmsResidual())
+                                           : MIN_REJECTION_SECONDS;
+
+    if (lateness > maxLateness)
+        numRejected++;
+    else
+        regression.add (x, y);
+
+    minNominalOffset = jmin (minNominalOffset, nominalOffset);
+
+    updatePublishedFit (x);
+
+    return published;
+}
+
+bool HardwareClock::isSettled() const
+{
+    return regression.getNumPoints() >= MIN_OBSERVATIONS_FOR_FIT && lastX >= MIN_FIT_SPAN_SECONDS * nominalTicksPerSecond;
+}
+
+HardwareClock::Fit HardwareClock::computeFit() const
+{
+    Fit fit;
+
+    // x is relative to firstTick, so callers can pass unwrapped ticks
+    fit.originTick = double (firstTick) + regression.getMeanX();
+    fit.originSeconds = regression.getMeanY();
+    fit.secondsPerTick = isSettled() ? regression.getSlope (1.0 / nominalTicksPerSecond) : 1.0 / nominalTicksPerSecond;
+
+    return fit;
+}
+
+void HardwareClock::updatePublishedFit (double x)
+{
+    const Fit target = computeFit();
+
+    // Limit the change of the offset at the newest tick to the slew over the time since the previous observation
+    const double tick = double (firstTick) + x;
+    const double maxChange = MAX_OFFSET_SLEW * jmax (0.0, x - lastX) / nominalTicksPerSecond;
+    const double change = target.toSeconds (tick) - published.toSeconds (tick);
+
+    published.originSeconds = published.toSeconds (tick) + jlimit (-maxChange, maxChange, change);
+    published.originTick = tick;
+    published.secondsPerTick = target.secondsPerTick;
+
+    lastX = jmax (lastX, x);
+}
+
+HardwareClock::Fit HardwareClock::getFit() const
+{
+    const SpinLock::ScopedLockType sl (lock);
+
+    return published;
+}
+
+void HardwareClock::StreamTimestamps::convert (const Fit& fit, double* timestamps, int numSamples)
+{
+    if (numSamples <= 0)
+        return;
+
+    for (int i = 0; i < numSamples; i++)
+        timestamps[i] = fit.toSeconds (timestamps[i]);
+
+    if (timestamps[0] <= lastSeconds)
+    {
+        const double samplePeriod = numSamples > 1 ? timestamps[1] - timestamps[0] : fit.secondsPerTick;
+        const double shift = lastSeconds + samplePeriod - timestamps[0];
+
+        for (int i = 0; i < numSamples; i++)
+            timestamps[i] += shift;
+    }
+
+    lastSeconds = timestamps[numSamples - 1];
+}
+
+double HardwareClock::getDriftPpm() const
+{
+    const Fit fit = getFit();
+
+    if (fit.secondsPerTick <= 0.0)
+        return 0.0;
+
+    return (1.0 / (fit.secondsPerTick * nominalTicksPerSecond) - 1.0) * 1.0e6;
+}
+
+double HardwareClock::getSampleRate (double nominalSampleRate) const
+{
+    return nominalSampleRate * (1.0 + getDriftPpm() * 1.0e-6);
+}
+
+double HardwareClock::getResidualUs() const
+{
+    const SpinLock::ScopedLockType sl (lock);
+
+    return regression.getRmsResidual() * 1.0e6;
+}
+
+int64 HardwareClock::getNumObservations() const
+{
+    const SpinLock::ScopedLockType sl (lock);
+
+    return regression.getNumPoints();
+}
+
+int64 HardwareClock::getNumRejected() const
+{
+    const SpinLock::ScopedLockType sl (lock);
+
+    return numRejected;
+}
+
+String HardwareClock::getSummary() const
+{
+    return String (getDriftPpm(), 3) + " ppm drift, " + String (getSampleRate (30000.0), 4) + " Hz AP rate, "
+           + String (getResidualUs(), 1) + " us RMS residual (" + String (getNumObservations()) + " reads, "
+           + String (getNumRejected()) + " rejected as late)";
+}
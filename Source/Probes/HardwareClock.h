@@ -0,0 +1,149 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef __HARDWARECLOCK_H_2C4C2D67__
+#define __HARDWARECLOCK_H_2C4C2D67__
+
+#include <DataThreadHeaders.h>
+
+#include "LinearRegression.h"
+
+/**
+
+	Model of one basestation's 100 kHz packet timestamp counter against
+	the host's monotonic clock.
+
+	Every acquisition thread on the basestation adds one observation per
+	batch (the unwrapped hardware timestamp of its newest sample and the
+	host time at which the read returned); a streaming least-squares fit
+	(LinearRegression) maps hardware ticks to host seconds since the start
+	of acquisition. Every basestation is reset with the same start time,
+	so timestamps from different basestations and other devices share
+	one time base.
+
+	Reads that return late (e.g. because the thread was descheduled) are
+	rejected, as they would bias the fit; the fit includes the (roughly
+	constant) transfer latency of the data. Until the fit has settled
+	(enough observations over a long enough span), lateness is measured
+	against the earliest read at the nominal rate, and the fit uses the
+	nominal rate.
+
+	The fit returned to the acquisition threads follows the least-squares
+	fit, but its offset changes by at most MAX_OFFSET_SLEW seconds per
+	second, so that successive batches are converted consistently; a
+	StreamTimestamps keeps each stream's timestamps increasing even so.
+
+*/
+class HardwareClock
+{
+public:
+    /** Nominal rate of the packet timestamp counter */
+    static constexpr double nominalTicksPerSecond = 100000.0;
+
+    /** Linear map from hardware ticks to host seconds */
+    struct Fit
+    {
+        double originTick = 0.0;
+        double originSeconds = 0.0;
+        double secondsPerTick = 1.0 / nominalTicksPerSecond;
+
+        /** Converts an unwrapped hardware tick to seconds since the start of acquisition */
+        double toSeconds (double tick) const { return originSeconds + (tick - originTick) * secondsPerTick; }
+    };
+
+    /** Converts one stream's batches of hardware ticks to seconds */
+    struct StreamTimestamps
+    {
+        /** Timestamp of the last sample of the previous batch */
+        double lastSeconds = -std::numeric_limits<double>::infinity();
+
+        /** Forgets the previous batch (call when acquisition starts) */
+        void reset() { lastSeconds = -std::numeric_limits<double>::infinity(); }
+
+        /** Converts a batch in place, shifting it to start after the previous batch if the fit
+            has moved back */
+        void convert (const Fit& fit, double* timestamps, int numSamples);
+    };
+
+    /** Constructor */
+    HardwareClock();
+
+    /** Clears the model and sets the host time that timestamps are measured from */
+    void reset (int64 startTicks);
+
+    /** Adds one observation and returns the updated fit (acquisition threads) */
+    Fit addObservation (int64 hardwareTick, int64 hostTicks);
+
+    /** Returns the current fit */
+    Fit getFit() const;
+
+    /** Returns the hardware clock rate error relative to the host clock, in parts per million
+        (positive = the hardware clock runs fast) */
+    double getDriftPpm() const;
+
+    /** Returns the actual rate of a stream with the given nominal sample rate, in host seconds */
+    double getSampleRate (double nominalSampleRate) const;
+
+    /** Returns the RMS difference between the observations and the fit, in microseconds */
+    double getResidualUs() const;
+
+    /** Returns the number of observations used by the fit */
+    int64 getNumObservations() const;
+
+    /** Returns the number of observations rejected as late */
+    int64 getNumRejected() const;
+
+    /** Returns a one-line description of the fit, for the log */
+    String getSummary() const;
+
+private:
+    /** Returns true once the least-squares fit is used (lock must be held) */
+    bool isSettled() const;
+
+    /** Returns the fit for the current sums (lock must be held) */
+    Fit computeFit() const;
+
+    /** Moves the published fit towards computeFit() by at most the slew limit (lock must be held) */
+    void updatePublishedFit (double x);
+
+    mutable SpinLock lock;
+
+    int64 startTicks = 0;
+    int64 firstTick = 0;
+
+    int64 numRejected = 0;
+
+    /** Latest observed tick (relative to firstTick) and the lowest host time minus the nominal
+        time of the tick seen so far, i.e. the earliest read */
+    double lastX = 0.0;
+    double minNominalOffset = 0.0;
+
+    /** Fit returned to the acquisition threads */
+    Fit published;
+
+    /** x = ticks since firstTick, y = host seconds since startTicks */
+    LinearRegression regression;
+};
+
+#endif // __HARDWARECLOCK_H_2C4C2D67__
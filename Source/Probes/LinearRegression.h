@@ -0,0 +1,98 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef __LINEARREGRESSION_H_2C4C2D67__
+#define __LINEARREGRESSION_H_2C4C2D67__
+
+#include <DataThreadHeaders.h>
+
+/**
+
+	Streaming least-squares fit of y = meanY + slope * (x - meanX).
+
+	Uses Welford-style updates of the means and co-moments, so the fit
+	stays accurate over the millions of points of a multi-hour recording.
+	Not thread safe.
+
+*/
+class LinearRegression
+{
+public:
+    /** Removes all points */
+    void reset()
+    {
+        numPoints = 0;
+        meanX = meanY = 0.0;
+        cxx = cxy = cyy = 0.0;
+    }
+
+    /** Adds one point */
+    void add (double x, double y)
+    {
+        numPoints++;
+
+        const double dx = x - meanX;
+        const double dy = y - meanY;
+
+        meanX += dx / double (numPoints);
+        meanY += dy / double (numPoints);
+
+        cxx += dx * (x - meanX);
+        cxy += dx * (y - meanY);
+        cyy += dy * (y - meanY);
+    }
+
+    /** Returns true once the slope can be estimated */
+    bool hasSlope() const { return numPoints > 1 && cxx > 0.0; }
+
+    /** Returns the fitted slope, or defaultSlope if there are not enough points */
+    double getSlope (double defaultSlope) const { return hasSlope() ? cxy / cxx : defaultSlope; }
+
+    /** Returns the fitted value at x (using defaultSlope if there are not enough points) */
+    double predict (double x, double defaultSlope) const { return meanY + getSlope (defaultSlope) * (x - meanX); }
+
+    /** Returns the RMS difference between the points and the fit */
+    double getRmsResidual() const
+    {
+        if (! hasSlope())
+            return 0.0;
+
+        return std::sqrt (jmax (0.0, (cyy - cxy * cxy / cxx) / double (numPoints)));
+    }
+
+    int64 getNumPoints() const { return numPoints; }
+    double getMeanX() const { return meanX; }
+    double getMeanY() const { return meanY; }
+
+private:
+    int64 numPoints = 0;
+
+    double meanX = 0.0;
+    double meanY = 0.0;
+    double cxx = 0.0;
+    double cxy = 0.0;
+    double cyy = 0.0;
+};
+
+#endif // __LINEARREGRESSION_H_2C4C2D67__
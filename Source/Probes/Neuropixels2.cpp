@@ -724,18 +724,18 @@ void Neuropixels2::startAcquisition()
     if (surveyModeActive && ! isEnabledForSurvey)
         return;
 
-    ap_timestamp = 0;
     apBuffer->clear();
 
     apView->reset();
 
-    last_npx_timestamp = 0;
-    passedOneSecond = false;
+    const float microvoltsPerBit = 1000000.0f / bitScaling / amplifierGain;
+    setSampleScaling (microvoltsPerBit, microvoltsPerBit);
 
-    SKIP = sendSync ? 385 : 384;
+    acquisitionEngine.setOutputs (apBuffer, apView.get());
+    acquisitionEngine.reset (sendSync, invertSyncLine);
 
     LOGD ("  Starting thread.");
-    startThread();
+    startAcquisitionThread();
 }
 
 void Neuropixels2::stopAcquisition()
@@ -746,97 +746,7 @@ void Neuropixels2::stopAcquisition()
 
 void Neuropixels2::run()
 {
-    while (! threadShouldExit())
-    {
-        int count = MAXPACKETS;
-
-        errorCode = Neuropixels::readPackets (
-            basestation->slot,
-            headstage->port,
-            dock,
-            source,
-            &packetInfo[0],
-            &data[0],
-            384,
-            count,
-            &count);
-
-        if (errorCode == Neuropixels::SUCCESS && count > 0)
-        {
-            for (int packetNum = 0; packetNum < count; packetNum++)
-            {
-                eventCode = packetInfo[packetNum].Status >> 6;
-
-                if (invertSyncLine)
-                    eventCode = ~eventCode;
-
-                uint32_t npx_timestamp = packetInfo[packetNum].Timestamp;
-
-                uint32_t timestamp_jump = npx_timestamp - last_npx_timestamp;
-
-                if (timestamp_jump > MAX_ALLOWABLE_TIMESTAMP_JUMP)
-                {
-                    if (passedOneSecond && timestamp_jump < MAX_HEADSTAGE_CLK_SAMPLE)
-                    {
-                        String msg = "NPX TIMESTAMP JUMP: " + String (timestamp_jump) + ", expected 3 or 4...Possible data loss on slot " + String (basestation->slot_c) + ", probe " + String (headstage->port_c) + " at sample number " + String (ap_timestamp);
-
-                        LOGC (msg);
-
-                        basestation->neuropixThread->sendBroadcastMessage (msg);
-                    }
-                }
-
-                last_npx_timestamp = npx_timestamp;
-
-                for (int j = 0; j < 384; j++)
-                {
-                    apSamples[j * count + packetNum] =
-                        float (data[packetNum * 384 + j]) / bitScaling / amplifierGain * 1000000.0f; // convert to microvolts
-
-                    // apView->addSample (apSamples[(j * count) + packetNum], j);
-                }
-
-                ap_timestamps[packetNum] = ap_timestamp++;
-                event_codes[packetNum] = eventCode;
-
-                if (sendSync)
-                    apSamples[(384 * count) + packetNum] = (float) eventCode;
-            }
-
-            apBuffer->addToBuffer (apSamples, ap_timestamps, timestamp_s, event_codes, count);
-            apView->addToBuffer (apSamples, count);
-        }
-        else if (errorCode != Neuropixels::SUCCESS)
-        {
-            LOGD ("readPackets error code: ", errorCode, " for Basestation ", int (basestation->slot), ", probe ", int (headstage->port));
-        }
-
-        if (! passedOneSecond)
-        {
-            if (ap_timestamp > 30000)
-                passedOneSecond = true;
-        }
-
-        int packetsAvailable;
-        int headroom;
-
-        Neuropixels::getPacketFifoStatus (
-            basestation->slot,
-            headstage->port,
-            dock,
-            source,
-            &packetsAvailable,
-            &headroom);
-
-        fifoFillPercentage = float (packetsAvailable) / float (packetsAvailable + headroom);
-
-        if (packetsAvailable < MAXPACKETS)
-        {
-            int uSecToWait = (MAXPACKETS - packetsAvailable) * 30;
-
-            std::this_thread::sleep_for (std::chrono::microseconds (uSecToWait));
-        }
-    }
+    acquisitionEngine.run (*this);
 }
 
 bool Neuropixels2::runBist (BIST bistType)
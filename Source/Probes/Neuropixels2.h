@@ -25,8 +25,7 @@
 #define __NEUROPIX2_H_2C4C2D67__
 
 #include "../NeuropixComponents.h"
-
-#define MAXPACKETS 64 * 12
+#include "AcquisitionEngine.h"
 
 /**
 
@@ -94,24 +93,17 @@ public:
     /** Acquires data from the probe */
     void run() override; // acquire data
 
-private:
-
-    int SKIP;
-
-    float apSamples[385 * MAXPACKETS];
-    int64 ap_timestamps[MAXPACKETS];
-    uint64 event_codes[MAXPACKETS];
+    /** Lets the basestation run the acquisition engine on a shared worker thread */
+    Array<AcquisitionTask*> getAcquisitionTasks() override { return { &acquisitionEngine }; }
 
-    int16_t data[MAXPACKETS * 384];
-
-    Neuropixels::streamsource_t source = Neuropixels::SourceAP;
-
-    Neuropixels::PacketInfo packetInfo[MAXPACKETS];
+private:
 
     Array<String> availableReferences;
 
     float bitScaling = 16384.0f;
     float amplifierGain = 80.0f;
+
+    AcquisitionEngine<NP2Traits> acquisitionEngine { this, apScaling, lfpScaling, Neuropixels::SourceAP };
 };
 
 #endif // _NEUROPIX2_H_2C4C2D67__
\ No newline at end of file
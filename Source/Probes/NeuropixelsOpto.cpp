@@ -446,8 +446,6 @@ void NeuropixelsOpto::startAcquisition()
     if (surveyModeActive && ! isEnabledForSurvey)
         return;
 
-    ap_timestamp = 0;
-    lfp_timestamp = 0;
     //std::cout << "... and clearing buffers" << std::endl;
     apBuffer->clear();
     lfpBuffer->clear();
@@ -455,10 +453,14 @@ void NeuropixelsOpto::startAcquisition()
     apView->reset();
     lfpView->reset();
 
-    SKIP = sendSync ? 385 : 384;
+    setSampleScaling (1.2f / 1024.0f * 1000000.0f / settings.availableApGains[settings.apGainIndex],
+                      1.2f / 1024.0f * 1000000.0f / settings.availableLfpGains[settings.lfpGainIndex]);
+
+    acquisitionEngine.setOutputs (apBuffer, apView.get(), lfpBuffer, lfpView.get());
+    acquisitionEngine.reset (sendSync, invertSyncLine);
 
     LOGD ("  NP Opto starting thread.");
-    startThread();
+    startAcquisitionThread();
 }
 
 void NeuropixelsOpto::stopAcquisition()
@@ -469,122 +471,7 @@ void NeuropixelsOpto::stopAcquisition()
 
 void NeuropixelsOpto::run()
 {
-    while (! threadShouldExit())
-    {
-        int count = MAXPACKETS;
-
-        errorCode = Neuropixels::readElectrodeData (
-            basestation->slot,
-            headstage->port,
-            dock,
-            &packet[0],
-            &count,
-            count);
-
-        if (errorCode == Neuropixels::SUCCESS && count > 0)
-        {
-            for (int packetNum = 0; packetNum < count; packetNum++)
-            {
-                for (int i = 0; i < 12; i++)
-                {
-                    eventCode = packet[packetNum].Status[i] >> 6; // AUX_IO<0:13>
-
-                    if (invertSyncLine)
-                        eventCode = ~eventCode;
-
-                    uint32_t npx_timestamp = packet[packetNum].timestamp[i];
-
-                    uint32_t timestamp_jump = npx_timestamp - last_npx_timestamp;
-
-                    if (timestamp_jump > MAX_ALLOWABLE_TIMESTAMP_JUMP)
-                    {
-                        if (passedOneSecond && timestamp_jump < MAX_HEADSTAGE_CLK_SAMPLE)
-                        {
-                            String msg = "NPX TIMESTAMP JUMP: " + String (timestamp_jump) + ", expected 3 or 4...Possible data loss on slot " + String (basestation->slot_c) + ", probe " + String (headstage->port_c) + " at sample number " + String (ap_timestamp);
-
-                            LOGC (msg);
-
-                            basestation->neuropixThread->sendBroadcastMessage (msg);
-                        }
-                    }
-
-                    last_npx_timestamp = npx_timestamp;
-
-                    for (int j = 0; j < 384; j++)
-                    {
-                        apSamples[j * (12 * count) + i + (packetNum * 12)] =
-                            float (packet[packetNum].apData[i][j]) * 1.2f / 1024.0f * 1000000.0f
-                                / settings.availableApGains[settings.apGainIndex]
-                            - ap_offsets[j][0]; // convert to microvolts
-
-                        // apView->addSample (apSamples[j * (12 * count) + i + (packetNum * 12)], j);
-
-                        if (i == 0)
-                        {
-                            lfpSamples[(j * count) + packetNum] =
-                                float (packet[packetNum].lfpData[j]) * 1.2f / 1024.0f * 1000000.0f
-                                    / settings.availableLfpGains[settings.lfpGainIndex]
-                                - lfp_offsets[j][0]; // convert to microvolts
-
-                            // lfpView->addSample (lfpSamples[(j * count) + packetNum], j);
-                        }
-                    }
-
-                    ap_timestamps[i + packetNum * 12] = ap_timestamp++;
-                    event_codes[i + packetNum * 12] = eventCode;
-
-                    if (sendSync)
-                        apSamples[384 * (12 * count) + i + (packetNum * 12)] = (float) eventCode;
-                }
-
-                lfp_timestamps[packetNum] = lfp_timestamp++;
-                lfp_event_codes[packetNum] = eventCode;
-
-                if (sendSync)
-                    lfpSamples[(384 * count) + packetNum] = (float) eventCode;
-            }
-
-            apBuffer->addToBuffer (apSamples, ap_timestamps, timestamp_s, event_codes, 12 * count);
-            apView->addToBuffer (apSamples, 12 * count);
-            lfpBuffer->addToBuffer (lfpSamples, lfp_timestamps, timestamp_s, lfp_event_codes, count);
-            lfpView->addToBuffer (lfpSamples, count);
-
-            if (ap_offsets[0][0] == 0)
-            {
-                updateOffsets (apSamples, ap_timestamp, true);
-                updateOffsets (lfpSamples, lfp_timestamp, false);
-            }
-        }
-        else if (errorCode != Neuropixels::SUCCESS)
-        {
-            LOGD ("readPackets error code: ", errorCode, " for Basestation ", int (basestation->slot), ", probe ", int (headstage->port));
-        }
-
-        int packetsAvailable;
-        int headroom;
-
-        if (! passedOneSecond)
-        {
-            if (ap_timestamp > 30000)
-                passedOneSecond = true;
-        }
-
-        Neuropixels::getElectrodeDataFifoState (
-            basestation->slot,
-            headstage->port,
-            dock,
-            &packetsAvailable,
-            &headroom);
-
-        fifoFillPercentage = float (packetsAvailable) / float (packetsAvailable + headroom);
-
-        if (packetsAvailable < MAXPACKETS)
-        {
-            int uSecToWait = (MAXPACKETS - packetsAvailable) * 400;
-
-            std::this_thread::sleep_for (std::chrono::microseconds (uSecToWait));
-        }
-    }
+    acquisitionEngine.run (*this);
 }
 
 bool NeuropixelsOpto::runBist (BIST bistType)
@@ -25,8 +25,7 @@
 #define __NEUROPIXNHP_ACTIVE_H_2C4C2D67__
 
 #include "../NeuropixComponents.h"
-
-#define MAXPACKETS 64
+#include "AcquisitionEngine.h"
 
 /**
 
@@ -97,17 +96,11 @@ public:
     /** Acquires data from the probe */
     void run() override; // acquire data
 
-private:
-    Neuropixels::electrodePacket packet[MAXPACKETS];
-
-    int SKIP;
+    /** Lets the basestation run the acquisition engine on a shared worker thread */
+    Array<AcquisitionTask*> getAcquisitionTasks() override { return { &acquisitionEngine }; }
 
-    float apSamples[385 * 12 * MAXPACKETS];
-    float lfpSamples[385 * MAXPACKETS];
-    int64 ap_timestamps[12 * MAXPACKETS];
-    uint64 event_codes[12 * MAXPACKETS];
-    int64 lfp_timestamps[MAXPACKETS];
-    uint64 lfp_event_codes[MAXPACKETS];
+private:
+    AcquisitionEngine<NHPActiveTraits> acquisitionEngine { this, apScaling, lfpScaling };
 };
 
 #endif // __NEUROPIXNHP_ACTIVE_H_2C4C2D67__
\ No newline at end of file
@@ -25,8 +25,7 @@
 #define __NEUROPIXNHP_PASSIVE_H_2C4C2D67__
 
 #include "../NeuropixComponents.h"
-
-#define MAXPACKETS 64
+#include "AcquisitionEngine.h"
 
 /**
 
@@ -94,19 +93,13 @@ public:
     /** Acquires data from the probe */
     void run() override; // acquire data
 
-private:
-    Neuropixels::electrodePacket packet[SAMPLECOUNT];
+    /** Lets the basestation run the acquisition engine on a shared worker thread */
+    Array<AcquisitionTask*> getAcquisitionTasks() override { return { &acquisitionEngine }; }
 
+private:
     Array<int> channel_map;
 
-    int SKIP;
-
-    float apSamples[385 * 12 * MAXPACKETS];
-    float lfpSamples[385 * MAXPACKETS];
-    int64 ap_timestamps[12 * MAXPACKETS];
-    uint64 event_codes[12 * MAXPACKETS];
-    int64 lfp_timestamps[MAXPACKETS];
-    uint64 lfp_event_codes[MAXPACKETS];
+    AcquisitionEngine<NHPPassiveTraits> acquisitionEngine { this, apScaling, lfpScaling };
 };
 
 #endif // _NEUROPIXNHP_PASSIVE_2C4C2D67__
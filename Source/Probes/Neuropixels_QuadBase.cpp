@@ -422,10 +422,7 @@ void Neuropixels_QuadBase::startAcquisition()
         for (int shank = 0; shank < 4; shank++)
         {
             acquisitionThreads.add (
-                new AcquisitionThread (basestation->slot,
-                                       headstage->port,
-                                       dock,
-                                       shank,
+                new AcquisitionThread (shank,
                                        quadBaseBuffers[shank],
                                        this,
                                        apView.get()));
@@ -442,8 +439,24 @@ void Neuropixels_QuadBase::startAcquisition()
 
         jassert (quadBaseBuffers[shank]->getNumSamples() == 0);
 
-        acquisitionThreads[shank]->startThread();
+        acquisitionThreads[shank]->prepare();
     }
+
+    if (! basestation->acquisitionPool.addTasks (getAcquisitionTasks()))
+    {
+        for (int shank = 0; shank < 4; shank++)
+            acquisitionThreads[shank]->startThread();
+    }
+}
+
+Array<AcquisitionTask*> Neuropixels_QuadBase::getAcquisitionTasks()
+{
+    Array<AcquisitionTask*> tasks;
+
+    for (auto thread : acquisitionThreads)
+        tasks.add (thread->getAcquisitionTask());
+
+    return tasks;
 }
 
 void Neuropixels_QuadBase::stopAcquisition()
@@ -456,196 +469,45 @@ void Neuropixels_QuadBase::stopAcquisition()
     }
 }
 
+static Neuropixels::streamsource_t getStreamSourceForShank (int shank)
+{
+    if (shank == 1)
+        return Neuropixels::streamsource_t::SourceLFP;
+    else if (shank == 2)
+        return Neuropixels::streamsource_t::SourceSt2;
+    else if (shank == 3)
+        return Neuropixels::streamsource_t::SourceSt3;
+
+    return Neuropixels::streamsource_t::SourceAP;
+}
+
 AcquisitionThread::AcquisitionThread (
-    int slot_,
-    int port_,
-    int dock_,
     int shank_,
     DataBuffer* buffer_,
     Probe* probe_,
-    ActivityView* apView_) : Thread ("AcquisitionThread" + String (shank)),
-                             slot (slot_),
-                             port (port_),
-                             dock (dock_),
-                             shank (shank_),
+    ActivityView* apView_) : Thread ("AcquisitionThread" + String (shank_)),
                              buffer (buffer_),
+                             shank (shank_),
                              probe (probe_),
                              apView (apView_),
-                             ap_sample_rate (30000.0f),
-                             ap_timestamp (0),
-                             last_npx_timestamp (0),
-                             sendSync (false),
-                             passedOneSecond (false),
-                             eventCode (0)
+                             acquisitionEngine (probe_, apScaling, apScaling, getStreamSourceForShank (shank_))
 {
-    if (shank == 0)
-        stream_source = Neuropixels::streamsource_t::SourceAP;
-    else if (shank == 1)
-        stream_source = Neuropixels::streamsource_t::SourceLFP;
-    else if (shank == 2)
-        stream_source = Neuropixels::streamsource_t::SourceSt2;
-    else if (shank == 3)
-        stream_source = Neuropixels::streamsource_t::SourceSt3;
 }
 
-void AcquisitionThread::run()
+void AcquisitionThread::prepare()
 {
-    Neuropixels::NP_ErrorCode errorCode;
+    apScaling.setScale (QuadBaseShankTraits::numChannels, 1000000.0f / 4096.0f / 80.0f);
 
-    ap_timestamp = 0;
-    last_npx_timestamp = 0;
-    passedOneSecond = false;
-
-    bool syncBitStatus = true;
-
-    SKIP = probe->sendSync ? 385 : 384;
+    acquisitionEngine.setOutputs (buffer, apView, nullptr, nullptr, shank);
+    acquisitionEngine.setReportsFifoFill (shank == 0); // all shanks share one FIFO
+    acquisitionEngine.reset (probe->sendSync, probe->invertSyncLine);
+}
 
+void AcquisitionThread::run()
+{
     LOGD ("  Starting thread for shank ", shank);
 
-    while (! threadShouldExit())
-    {
-        int shank_channel_count = 384;
-
-        int count = MAXPACKETS;
-
-        errorCode = Neuropixels::readPackets (
-            slot,
-            port,
-            dock,
-            stream_source,
-            &packetInfo[0],
-            &data[0],
-            shank_channel_count,
-            count,
-            &count);
-
-        if (errorCode == Neuropixels::SUCCESS && count > 0)
-        {
-            for (int packetNum = 0; packetNum < count; packetNum++)
-            {
-
-                eventCode = packetInfo[packetNum].Status >> 6;
-
-                if (invertSyncLine)
-                    eventCode = ~eventCode;
-
-                uint32_t npx_timestamp = packetInfo[packetNum].Timestamp;
-
-                uint32_t timestamp_jump = npx_timestamp - last_npx_timestamp;
-
-                if (timestamp_jump > MAX_ALLOWABLE_TIMESTAMP_JUMP)
-                {
-                    if (passedOneSecond && timestamp_jump < MAX_HEADSTAGE_CLK_SAMPLE)
-                    {
-                        String msg = "NPX TIMESTAMP JUMP: " + String (timestamp_jump) + ", expected 3 or 4...Possible data loss on slot " + String (slot) + ", probe " + String (port) + " at sample number " + String (ap_timestamp);
-
-                        LOGC (msg);
-
-                        probe->basestation->neuropixThread->sendBroadcastMessage (msg);
-                    }
-                }
-
-                if (packetInfo[packetNum].Status & ELECTRODEPACKET_STATUS_ERR_COUNT)
-                {
-                    String msg = "NPX PACKET COUNT ERROR on slot " + String (slot) + ", probe " + String (port) + " at sample number " + String (ap_timestamp);
-                    LOGC (msg);
-                    //probe->basestation->neuropixThread->sendBroadcastMessage (msg);
-                }
-
-                if (packetInfo[packetNum].Status & ELECTRODEPACKET_STATUS_ERR_SERDES)
-                {
-                    String msg = "NPX SERDES ERROR on slot " + String (slot) + ", probe " + String (port) + " at sample number " + String (ap_timestamp);
-                    LOGC (msg);
-                    //probe->basestation->neuropixThread->sendBroadcastMessage (msg);
-                }
-
-                if (packetInfo[packetNum].Status & ELECTRODEPACKET_STATUS_ERR_LOCK)
-                {
-                    String msg = "NPX LOCK ERROR on slot " + String (slot) + ", probe " + String (port) + " at sample number " + String (ap_timestamp);
-                    LOGC (msg);
-                    //probe->basestation->neuropixThread->sendBroadcastMessage (msg);
-                }
-
-                if (packetInfo[packetNum].Status & ELECTRODEPACKET_STATUS_ERR_POP)
-                {
-                    String msg = "NPX FIFO OVERFLOW (POP) on slot " + String (slot) + ", probe " + String (port) + " at sample number " + String (ap_timestamp);
-                    LOGC (msg);
-                    //probe->basestation->neuropixThread->sendBroadcastMessage (msg);
-                }
-
-                if (packetInfo[packetNum].Status & ELECTRODEPACKET_STATUS_ERR_SYNC)
-                {
-                    String msg = "NPX SYNC ERROR on slot " + String (slot) + ", probe " + String (port) + " at sample number " + String (ap_timestamp);
-                    LOGC (msg);
-                    //probe->basestation->neuropixThread->sendBroadcastMessage (msg);
-                }
-
-                last_npx_timestamp = npx_timestamp;
-
-                for (int j = 0; j < shank_channel_count; j++)
-                {
-                    apSamples[packetNum + count * j] =
-                        float (data[packetNum * shank_channel_count + j]) / 4096.0f / 80.0f * 1000000.0f; // convert to microvolts
-
-                    // apView->addSample (apSamples[packetNum + count * j], j + shank * 384, shank);
-                }
-
-                if (sendSync)
-                {
-                    apSamples[packetNum + count * 384] = (float) eventCode;
-                }
-
-                ap_timestamps[packetNum] = ap_timestamp++;
-                event_codes[packetNum] = eventCode;
-            }
-
-            // int64 startTime = 0;
-            // if (shank == 0)
-            // {
-            //     startTime = juce::Time::getHighResolutionTicks();
-            // }
-
-            buffer->addToBuffer (apSamples, ap_timestamps, timestamp_s, event_codes, count);
-            apView->addToBuffer (apSamples, count, shank);
-
-            // if (shank == 0 && startTime != 0)
-            // {
-            //     float elapsedTime =  Time::highResolutionTicksToSeconds (juce::Time::getHighResolutionTicks() - startTime) * 1000.0f; // elapsed time in milliseconds
-            //     LOGC ("Elapsed time for first AP packet: " + String (elapsedTime) + " ms");
-            // }
-        }
-        else if (errorCode != Neuropixels::SUCCESS)
-        {
-            std::cout << "readPackets error code: " << errorCode << " for Basestation " << slot << ", probe " << port << std::endl;
-        }
-
-        if (! passedOneSecond)
-        {
-            if (ap_timestamp > 30000)
-                passedOneSecond = true;
-        }
-
-        int packetsAvailable;
-        int headroom;
-
-        Neuropixels::getPacketFifoStatus (
-            slot,
-            port,
-            dock,
-            static_cast<Neuropixels::streamsource_t> (0),
-            &packetsAvailable,
-            &headroom);
-
-        if (shank == 0)
-            probe->fifoFillPercentage = float (packetsAvailable) / float (packetsAvailable + headroom);
-
-        if (packetsAvailable < MAXPACKETS)
-        {
-            int uSecToWait = (MAXPACKETS - packetsAvailable) * 30;
-
-            std::this_thread::sleep_for (std::chrono::microseconds (uSecToWait));
-        }
-    }
+    acquisitionEngine.run (*this);
 }
 
 bool Neuropixels_QuadBase::runBist (BIST bistType)
@@ -25,62 +25,37 @@
 #define __NEUROPIXP2C_H_2C4C2D67__
 
 #include "../NeuropixComponents.h"
-
-#define MAXPACKETS 64 * 12 * 4
+#include "AcquisitionEngine.h"
 
 class AcquisitionThread : public Thread
 {
 public:
-    AcquisitionThread (int slot,
-                       int port,
-                       int dock,
-                       int shank,
+    AcquisitionThread (int shank,
                        DataBuffer* buffer,
                        Probe* probe,
                        ActivityView* apView);
 
+    /** Configures the acquisition engine; call before starting the thread */
+    void prepare();
+
     /** Acquires data from the probe */
     void run() override; // acquire data
 
+    /** Returns the acquisition engine, for running on a shared worker thread instead */
+    AcquisitionTask* getAcquisitionTask() { return &acquisitionEngine; }
+
     /** Pointer to data buffer */
     DataBuffer* buffer;
 
 private:
-
-    int SKIP;
-
-    float apSamples[(384 * 4 + 1) * MAXPACKETS];
-    int64 ap_timestamps[MAXPACKETS];
-    uint64 event_codes[MAXPACKETS];
-
-    float ap_sample_rate;
-    int64 ap_timestamp;
-
-    float ap_offsets[384][100];
-    float lfp_offsets[384][100];
-
-    double timestamp_s[12 * MAXPACKETS];
-
-    uint32_t last_npx_timestamp;
-    bool passedOneSecond;
-    bool sendSync;
-
-    int16_t data[MAXPACKETS * 384];
-    uint64 eventCode;
-
-    Neuropixels::streamsource_t source = Neuropixels::SourceAP;
-
-    Neuropixels::PacketInfo packetInfo[MAXPACKETS];
-
-    Neuropixels::streamsource_t stream_source;
     int shank;
-    int slot;
-    int port;
-    int dock;
 
     Probe* probe;
-    bool invertSyncLine = false;
     ActivityView* apView;
+
+    PacketDecoder::ChannelScaling apScaling;
+
+    AcquisitionEngine<QuadBaseShankTraits> acquisitionEngine;
 };
 
 /**
@@ -149,6 +124,9 @@ public:
     /** Acquisition happens in sub-threads -- this one is not used */
     void run() override {} // not used
 
+    /** Returns the acquisition engines for all four shanks */
+    Array<AcquisitionTask*> getAcquisitionTasks() override;
+
 private:
     Neuropixels::NP_ErrorCode errorCode;
 
@@ -25,8 +25,7 @@
 #define __NEUROPIXUHD_H_2C4C2D67__
 
 #include "../NeuropixComponents.h"
-
-#define MAXPACKETS 64
+#include "AcquisitionEngine.h"
 
 /**
 
@@ -97,22 +96,16 @@ public:
     /** Acquires data from the probe */
     void run() override;
 
+    /** Lets the basestation run the acquisition engine on a shared worker thread */
+    Array<AcquisitionTask*> getAcquisitionTasks() override { return { &acquisitionEngine }; }
+
 private:
     /** Creates arrays of selected electrodes for each available config */
     void createElectrodeConfigurations();
 
-    Neuropixels::electrodePacket packet[MAXPACKETS];
-
     bool switchable;
 
-    int SKIP;
-
-    float apSamples[385 * 12 * MAXPACKETS];
-    float lfpSamples[385 * MAXPACKETS];
-    int64 ap_timestamps[12 * MAXPACKETS];
-    uint64 event_codes[12 * MAXPACKETS];
-    int64 lfp_timestamps[MAXPACKETS];
-    uint64 lfp_event_codes[MAXPACKETS];
+    AcquisitionEngine<UHDTraits> acquisitionEngine { this, apScaling, lfpScaling };
 
     Array<String> availableElectrodeConfigurations;
 
@@ -0,0 +1,127 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "OffsetTracker.h"
+
+#include <cmath>
+
+// Samples are ignored for this long after the start of acquisition or a reset, while the amplifiers settle
+#define SETTLE_SECONDS 5.0
+
+String OffsetTracker::getModeName (Mode mode)
+{
+    switch (mode)
+    {
+        case ONCE:
+            return "ONCE";
+        case CONTINUOUS:
+            return "CONTINUOUS";
+        default:
+            return "OFF";
+    }
+}
+
+bool OffsetTracker::parseMode (const String& name, Mode& mode)
+{
+    for (Mode m : { OFF, ONCE, CONTINUOUS })
+    {
+        if (name.equalsIgnoreCase (getModeName (m)))
+        {
+            mode = m;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void OffsetTracker::prepare (const Settings& settings_, int numChannels_, float sampleRate_)
+{
+    const bool keepEstimates = settings_.mode == settings.mode && numChannels_ == numChannels && ! resetPending.exchange (false);
+
+    settings = settings_;
+    numChannels = numChannels_;
+    sampleRate = sampleRate_;
+
+    // Sample numbers restart with each acquisition
+    if (keepEstimates)
+        firstSampleNumber = int64 (SETTLE_SECONDS * sampleRate);
+    else
+        clear (0);
+}
+
+void OffsetTracker::clear (int64 settleFrom)
+{
+    offsets.assign ((size_t) numChannels, 0.0f);
+    firstSampleNumber = settleFrom + int64 (SETTLE_SECONDS * sampleRate);
+    numAveraged = 0;
+}
+
+bool OffsetTracker::process (const float* samples, int numSamples, int64 sampleNumber)
+{
+    if (resetPending.exchange (false))
+    {
+        clear (sampleNumber);
+        return true;
+    }
+
+    const int64 timeConstantSamples = jmax (int64 (1), int64 (settings.timeConstantSeconds * sampleRate));
+
+    if (settings.mode == OFF
+        || numSamples <= 0
+        || sampleNumber < firstSampleNumber
+        || (settings.mode == ONCE && numAveraged >= timeConstantSamples))
+        return false;
+
+    // A plain mean until one time constant of data has been seen, then an exponential moving average
+    numAveraged += numSamples;
+
+    const float weight = (float) jmax (double (numSamples) / double (numAveraged),
+                                       1.0 - std::exp (-double (numSamples) / double (timeConstantSamples)));
+
+    const float weightPerSample = weight / float (numSamples);
+
+    for (int ch = 0; ch < numChannels; ch++)
+    {
+        const float* channel = samples + (size_t) ch * numSamples;
+
+        // Independent partial sums, so that the additions are not one serial chain
+        float sums[8] = {};
+
+        int i = 0;
+
+        for (; i + 8 <= numSamples; i += 8)
+            for (int k = 0; k < 8; k++)
+                sums[k] += channel[i + k];
+
+        for (; i < numSamples; i++)
+            sums[0] += channel[i];
+
+        const float sum = ((sums[0] + sums[1]) + (sums[2] + sums[3])) + ((sums[4] + sums[5]) + (sums[6] + sums[7]));
+
+        // The batch was decoded with the current offset, so its mean is the remaining error
+        offsets[(size_t) ch] += weightPerSample * sum;
+    }
+
+    return true;
+}
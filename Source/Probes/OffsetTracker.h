@@ -0,0 +1,107 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __OFFSETTRACKER_H_2C4C2D67__
+#define __OFFSETTRACKER_H_2C4C2D67__
+
+#include <DataThreadHeaders.h>
+
+#include <atomic>
+#include <vector>
+
+/**
+
+	Running estimate of the DC offset of each channel of one band.
+
+	The offsets are subtracted by the packet decoder, so each batch it
+	produces should average zero; process() folds the batch mean of every
+	channel into the estimate, which costs one addition per sample and
+	one multiply-add per channel. The weight of a batch starts at 1/n
+	(a plain mean of everything seen so far) and falls to the weight of an
+	exponential moving average with the configured time constant.
+
+	Samples from the first seconds of acquisition (and after reset()) are
+	ignored while the amplifiers settle. In ONCE mode the estimate is
+	frozen after one time constant of data and kept for later recordings;
+	in CONTINUOUS mode it keeps tracking slow drifts.
+
+*/
+class OffsetTracker
+{
+public:
+    enum Mode
+    {
+        OFF = 0, // no offsets are subtracted
+        ONCE, // offsets are measured once, then held
+        CONTINUOUS // offsets follow the running mean of each channel
+    };
+
+    /** User-configurable offset correction, stored per probe */
+    struct Settings
+    {
+        Mode mode = ONCE;
+
+        /** Time constant of the running mean (and length of the ONCE measurement) */
+        float timeConstantSeconds = 2.0f;
+    };
+
+    /** Returns the name of a mode, as used by the "NP OFFSETS" config message */
+    static String getModeName (Mode mode);
+
+    /** Parses a mode name; returns false if it is not recognized */
+    static bool parseMode (const String& name, Mode& mode);
+
+    /** Applies the settings when acquisition starts. The estimates are kept, unless
+        the mode or the number of channels changed or reset() was called. */
+    void prepare (const Settings& settings, int numChannels, float sampleRate);
+
+    /** Discards the estimates, e.g. after a gain or reference change (any thread) */
+    void reset() { resetPending = true; }
+
+    /** Updates the estimates from a channel-major batch, decoded with the current offsets;
+        returns true if getOffsets() changed */
+    bool process (const float* samples, int numSamples, int64 sampleNumber);
+
+    /** Returns the current offset of each channel */
+    const std::vector<float>& getOffsets() const { return offsets; }
+
+private:
+    /** Clears the estimates and waits for the amplifiers to settle after settleFrom */
+    void clear (int64 settleFrom);
+
+    Settings settings;
+    int numChannels = 0;
+    float sampleRate = 30000.0f;
+
+    std::vector<float> offsets;
+
+    /** First sample number used for the estimates */
+    int64 firstSampleNumber = 0;
+
+    /** Samples that contributed to the estimates */
+    int64 numAveraged = 0;
+
+    std::atomic<bool> resetPending { false };
+};
+
+#endif // __OFFSETTRACKER_H_2C4C2D67__
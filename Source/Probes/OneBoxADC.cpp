@@ -72,6 +72,8 @@ void OneBoxADC::initialize (bool signalChainIsLoading)
 void OneBoxADC::startAcquisition()
 {
     sample_number = 0;
+    hardware_tick = 0;
+    timestampConverter.reset();
     apBuffer->clear();
 
     LOGD ("  Starting thread.");
@@ -262,6 +264,10 @@ void OneBoxADC::run()
     int packetsAvailable;
     int headroom;
 
+    uint32_t last_npx_timestamp = 0;
+
+    scheduler.prepare (pollingSettings, 1.0e6 / 30000.0, MAXPACKETS);
+
     while (! threadShouldExit())
     {
         int count = MAXPACKETS;
@@ -278,14 +284,29 @@ void OneBoxADC::run()
                                                   count,
                                                   &count);
 
-        if (errorCode == Neuropixels::SUCCESS && count > 0)
+        if (errorCode != Neuropixels::SUCCESS)
+            count = 0;
+
+        const int64 readTicks = Time::getHighResolutionTicks();
+
+        scheduler.packetsRead (count, MAXPACKETS, readTicks);
+
+        if (count > 0)
         {
+            scheduler.startProcessing();
+
             for (int packetNum = 0; packetNum < count; packetNum++)
             {
                 uint64 eventCode = packetInfo[packetNum].Status >> 6;
 
                 uint32_t npx_timestamp = packetInfo[packetNum].Timestamp;
 
+                // Unwrap the 32-bit counter, starting from its absolute value like the probe streams
+                hardware_tick = sample_number == 0 ? int64 (npx_timestamp) : hardware_tick + int32_t (npx_timestamp - last_npx_timestamp);
+                last_npx_timestamp = npx_timestamp;
+
+                timestamps[packetNum] = double (hardware_tick);
+
                 for (int j = 0; j < NUM_ADCS; j++)
                 {
                     adcSamples[j * count + packetNum] = float (data[packetNum * NUM_ADCS_AND_COMPARATORS + j]) * bitVolts; // convert to volts
@@ -302,24 +323,34 @@ void OneBoxADC::run()
                 event_codes[packetNum] = eventCode;
             }
 
+            const HardwareClock::Fit fit = basestation->clock.addObservation (hardware_tick, readTicks);
+
+            timestampConverter.convert (fit, timestamps, count);
+
             apBuffer->addToBuffer (adcSamples,
                                    sample_numbers,
                                    timestamps,
                                    event_codes,
                                    count);
+
+            scheduler.stopProcessing();
         }
         else if (errorCode != Neuropixels::SUCCESS)
         {
             LOGD ("readPackets error code: ", errorCode, " for ADCs");
         }
 
-        Neuropixels::ADC_getPacketFifoStatus (basestation->slot, &packetsAvailable, &headroom);
+        const int64 now = Time::getHighResolutionTicks();
 
-        if (packetsAvailable < MAXPACKETS)
+        if (scheduler.shouldQueryFifo (now))
         {
-            int uSecToWait = (MAXPACKETS - packetsAvailable) * 30;
+            Neuropixels::ADC_getPacketFifoStatus (basestation->slot, &packetsAvailable, &headroom);
 
-            std::this_thread::sleep_for (std::chrono::microseconds (uSecToWait));
+            scheduler.fifoStatusRead (packetsAvailable, headroom, now);
         }
+
+        scheduler.waitForNextRead (*this);
     }
+
+    LOGC ("ADC acquisition thread for slot ", basestation->slot, ": ", scheduler.getSummary());
 }
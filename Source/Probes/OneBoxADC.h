@@ -116,6 +116,15 @@ private:
     /** Sample number for acquisition */
     int64 sample_number;
 
+    /** Unwrapped 100 kHz timestamp of the newest sample */
+    int64 hardware_tick;
+
+    /** Keeps the timestamps increasing across batches */
+    HardwareClock::StreamTimestamps timestampConverter;
+
+    /** Decides when to read from the ADC FIFO */
+    PollingScheduler scheduler;
+
     /** Holds incoming samples*/
     DataBuffer* sampleBuffer;
 
@@ -0,0 +1,289 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "PacketCapture.h"
+
+// Time the staging FIFO can absorb while the flusher is stalled
+#define STAGING_DURATION_US 500000.0
+
+// How often the flusher moves staged records into the ring files
+#define FLUSH_INTERVAL_MS 20
+
+/**
+
+	Background thread shared by all open captures.
+
+*/
+class PacketCapture::Flusher : public Thread
+{
+public:
+    Flusher() : Thread ("Packet capture flusher")
+    {
+        startThread();
+    }
+
+    ~Flusher()
+    {
+        stopThread (1000);
+    }
+
+    void addCapture (PacketCapture* capture)
+    {
+        const ScopedLock lock (capturesLock);
+        captures.addIfNotAlreadyThere (capture);
+    }
+
+    void removeCapture (PacketCapture* capture)
+    {
+        const ScopedLock lock (capturesLock);
+        captures.removeFirstMatchingValue (capture);
+    }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            {
+                const ScopedLock lock (capturesLock);
+
+                for (auto capture : captures)
+                    capture->flush();
+            }
+
+            wait (FLUSH_INTERVAL_MS);
+        }
+    }
+
+private:
+    CriticalSection capturesLock;
+    Array<PacketCapture*> captures;
+};
+
+PacketCapture::PacketCapture (const Layout& layout_)
+    : layout (layout_),
+      recordBytes (int (layout_.headerBytes + layout_.payloadBytes))
+{
+}
+
+PacketCapture::~PacketCapture()
+{
+    if (flusher != nullptr)
+    {
+        (*flusher)->removeCapture (this);
+        flusher.reset();
+    }
+
+    if (mappedFile != nullptr)
+    {
+        flush();
+
+        LOGC ("Packet capture ", file.getFullPathName(), ": ", (int64) numRecordsWritten, " packets, ", (int64) numRecordsDropped, " dropped");
+    }
+}
+
+File PacketCapture::getDefaultFile (const File& directory, int slot, int port, int dock, int source)
+{
+    String name = "capture_slot" + String (slot) + "_port" + String (port) + "_dock" + String (dock);
+
+    if (source > 0)
+        name += "_source" + String (source);
+
+    name += "_" + Time::getCurrentTime().formatted ("%Y-%m-%d_%H-%M-%S") + ".npxcap";
+
+    return directory.getChildFile (name);
+}
+
+bool PacketCapture::open (const File& file_, int64 sizeBytes, const FileHeader& stream)
+{
+    file = file_;
+
+    if (sizeBytes < int64 (dataOffset) + recordBytes)
+    {
+        LOGE ("Packet capture size is too small: ", sizeBytes, " bytes");
+        return false;
+    }
+
+    capacityRecords = uint64 (sizeBytes - int64 (dataOffset)) / uint64 (recordBytes);
+
+    const int64 fileSize = int64 (dataOffset + capacityRecords * uint64 (recordBytes));
+
+    // Only set the size of the file (writing the whole ring would stall the start of acquisition);
+    // its blocks are allocated when the flusher thread first writes them, never by the acquisition thread
+    {
+        file.getParentDirectory().createDirectory();
+
+        FileOutputStream out (file);
+
+        if (out.failedToOpen() || ! out.setPosition (0) || out.truncate().failed())
+        {
+            LOGE ("Unable to create packet capture file ", file.getFullPathName());
+            return false;
+        }
+
+        if (! out.setPosition (fileSize - 1) || ! out.writeByte (0))
+        {
+            LOGE ("Unable to allocate ", fileSize, " bytes for packet capture file ", file.getFullPathName());
+            return false;
+        }
+
+        out.flush();
+
+        if (out.getStatus().failed())
+        {
+            LOGE ("Unable to allocate ", fileSize, " bytes for packet capture file ", file.getFullPathName());
+            return false;
+        }
+    }
+
+    mappedFile = std::make_unique<MemoryMappedFile> (file, MemoryMappedFile::readWrite);
+
+    if (mappedFile->getData() == nullptr || int64 (mappedFile->getSize()) < fileSize)
+    {
+        LOGE ("Unable to map packet capture file ", file.getFullPathName());
+        mappedFile.reset();
+        return false;
+    }
+
+    FileHeader* header = getHeader();
+
+    *header = stream;
+
+    memcpy (header->magic, "NPXCAP1", 8);
+    header->version = currentVersion;
+    header->format = layout.format;
+    header->headerBytes = layout.headerBytes;
+    header->payloadBytes = layout.payloadBytes;
+    header->numChannels = layout.numChannels;
+    header->reserved = 0;
+    header->partNumber[sizeof (header->partNumber) - 1] = 0;
+    header->packetIntervalUs = layout.packetIntervalUs;
+    header->dataOffset = dataOffset;
+    header->capacityRecords = capacityRecords;
+    header->numRecordsWritten = 0;
+    header->numRecordsDropped = 0;
+    header->startTimeMs = Time::currentTimeMillis();
+
+    numRecordsWritten = 0;
+    numRecordsDropped = 0;
+
+    const int stagingRecords = jmax (1024, int (STAGING_DURATION_US / layout.packetIntervalUs));
+
+    staging.resize ((size_t) stagingRecords * recordBytes);
+    stagingFifo = std::make_unique<AbstractFifo> (stagingRecords);
+
+    flusher = std::make_unique<SharedResourcePointer<Flusher>>();
+    (*flusher)->addCapture (this);
+
+    LOGC ("Capturing packets from slot ", stream.slot, ", port ", stream.port, ", dock ", stream.dock, " to ", file.getFullPathName(), " (", (int64) capacityRecords, " packets)");
+
+    return true;
+}
+
+PacketCapture::FileHeader* PacketCapture::getHeader() const
+{
+    return static_cast<FileHeader*> (mappedFile->getData());
+}
+
+void PacketCapture::write (const void* headers, const void* payloads, int numRecords)
+{
+    if (stagingFifo == nullptr)
+        return;
+
+    int start1, size1, start2, size2;
+    stagingFifo->prepareToWrite (numRecords, start1, size1, start2, size2);
+
+    auto copy = [&] (int firstRecord, int stagingIndex, int count)
+    {
+        char* dest = staging.data() + (size_t) stagingIndex * recordBytes;
+        const char* header = static_cast<const char*> (headers) + (size_t) firstRecord * layout.headerBytes;
+
+        if (layout.payloadBytes == 0)
+        {
+            memcpy (dest, header, (size_t) count * recordBytes);
+            return;
+        }
+
+        const char* payload = static_cast<const char*> (payloads) + (size_t) firstRecord * layout.payloadBytes;
+
+        for (int i = 0; i < count; i++)
+        {
+            memcpy (dest, header, layout.headerBytes);
+            memcpy (dest + layout.headerBytes, payload, layout.payloadBytes);
+
+            dest += recordBytes;
+            header += layout.headerBytes;
+            payload += layout.payloadBytes;
+        }
+    };
+
+    if (size1 > 0)
+        copy (0, start1, size1);
+
+    if (size2 > 0)
+        copy (size1, start2, size2);
+
+    stagingFifo->finishedWrite (size1 + size2);
+
+    if (size1 + size2 < numRecords)
+        numRecordsDropped += numRecords - size1 - size2;
+}
+
+void PacketCapture::flush()
+{
+    const ScopedLock lock (flushLock);
+
+    if (mappedFile == nullptr)
+        return;
+
+    int start1, size1, start2, size2;
+    stagingFifo->prepareToRead (stagingFifo->getNumReady(), start1, size1, start2, size2);
+
+    char* ring = static_cast<char*> (mappedFile->getData()) + dataOffset;
+
+    auto copy = [&] (int stagingIndex, int count)
+    {
+        while (count > 0)
+        {
+            const uint64 ringIndex = numRecordsWritten % capacityRecords;
+            const int chunk = (int) jmin (uint64 (count), capacityRecords - ringIndex);
+
+            memcpy (ring + ringIndex * recordBytes,
+                    staging.data() + (size_t) stagingIndex * recordBytes,
+                    (size_t) chunk * recordBytes);
+
+            numRecordsWritten += chunk;
+            stagingIndex += chunk;
+            count -= chunk;
+        }
+    };
+
+    copy (start1, size1);
+    copy (start2, size2);
+
+    stagingFifo->finishedRead (size1 + size2);
+
+    FileHeader* header = getHeader();
+    header->numRecordsWritten = numRecordsWritten;
+    header->numRecordsDropped = (uint64) numRecordsDropped.load();
+}
@@ -0,0 +1,154 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef __PACKETCAPTURE_H_2C4C2D67__
+#define __PACKETCAPTURE_H_2C4C2D67__
+
+#include <DataThreadHeaders.h>
+
+#include <atomic>
+#include <memory>
+
+/**
+
+	Records the packets returned by the Neuropixels API, unmodified, into
+	a fixed-size memory-mapped ring file, so that timing and decoding
+	problems seen during acquisition can be reproduced offline.
+
+	The acquisition thread only copies each batch into an in-memory
+	staging FIFO (records are dropped and counted if it is full); a
+	shared background thread moves staged records into the mapped file
+	and keeps the file header up to date. Once the ring is full, the
+	oldest records are overwritten.
+
+	File layout: a FileHeader, padded to dataOffset bytes, followed by
+	capacityRecords fixed-size records. Each record is headerBytes of
+	packet header (an electrodePacket or a PacketInfo) followed by
+	payloadBytes of int16 samples (PacketInfo streams only). Record i
+	(counting from the start of acquisition) is stored in slot
+	i % capacityRecords.
+
+*/
+class PacketCapture
+{
+public:
+    /** User-configurable capture options, stored per probe */
+    struct Settings
+    {
+        bool enabled = false;
+
+        /** Size of the ring file */
+        int sizeMegabytes = 1024;
+    };
+
+    /** Shape of the records in a capture file */
+    struct Layout
+    {
+        uint32 format = 0; // 0 = electrodePacket records, 1 = PacketInfo + int16 payload
+        uint32 headerBytes = 0;
+        uint32 payloadBytes = 0;
+        uint32 numChannels = 0;
+        double packetIntervalUs = 0.0; // nominal time between records
+    };
+
+    /** Written at the start of every capture file */
+    struct FileHeader
+    {
+        char magic[8]; // "NPXCAP1"
+        uint32 version;
+        uint32 format;
+        uint32 headerBytes;
+        uint32 payloadBytes;
+        uint32 numChannels;
+        int32 source;
+        int32 slot;
+        int32 port;
+        int32 dock;
+        uint32 reserved;
+        double packetIntervalUs;
+        uint64 dataOffset;
+        uint64 capacityRecords;
+        uint64 numRecordsWritten; // total records written since the start of acquisition
+        uint64 numRecordsDropped; // records lost because the staging FIFO was full
+        int64 startTimeMs; // wall-clock time of the first record
+        char partNumber[32]; // probe part number, null-terminated
+        uint64 serialNumber;
+        float apMicrovoltsPerBit; // AP scale factor at the time of capture
+        float lfpMicrovoltsPerBit;
+    };
+
+    static constexpr uint32 currentVersion = 1;
+    static constexpr uint64 dataOffset = 4096;
+
+    /** Constructor */
+    PacketCapture (const Layout& layout);
+
+    /** Destructor -- flushes any staged records and closes the file */
+    ~PacketCapture();
+
+    /** Creates and maps the ring file and starts flushing; returns false on failure.
+        The stream description (source, slot, port, dock, part number, serial number
+        and scale factors) is copied from `stream`; the other fields are filled in */
+    bool open (const File& file, int64 sizeBytes, const FileHeader& stream);
+
+    /** Copies numRecords records into the staging FIFO (acquisition thread; never blocks).
+        headers holds numRecords packet headers; payloads holds numRecords payloads,
+        or may be null if the layout has no payload */
+    void write (const void* headers, const void* payloads, int numRecords);
+
+    /** Moves staged records into the ring file (flusher thread) */
+    void flush();
+
+    /** Returns the file being written */
+    const File& getFile() const { return file; }
+
+    /** Returns the number of records lost because the staging FIFO was full */
+    int64 getNumRecordsDropped() const { return numRecordsDropped; }
+
+    /** Returns the name of a new capture file for a stream */
+    static File getDefaultFile (const File& directory, int slot, int port, int dock, int source);
+
+private:
+    class Flusher;
+
+    FileHeader* getHeader() const;
+
+    const Layout layout;
+    const int recordBytes;
+
+    File file;
+    std::unique_ptr<MemoryMappedFile> mappedFile;
+    uint64 capacityRecords = 0;
+    uint64 numRecordsWritten = 0;
+
+    std::vector<char> staging;
+    std::unique_ptr<AbstractFifo> stagingFifo;
+    std::atomic<int64> numRecordsDropped { 0 };
+
+    CriticalSection flushLock;
+
+    std::unique_ptr<SharedResourcePointer<Flusher>> flusher;
+};
+
+#endif // __PACKETCAPTURE_H_2C4C2D67__
@@ -0,0 +1,258 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "PacketDecoder.h"
+
+#include <DataThreadHeaders.h>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NP_DECODE_SSE2 1
+#include <immintrin.h>
+
+#if defined(_MSC_VER) && ! defined(__clang__)
+#define NP_TARGET_AVX2
+#else
+#define NP_TARGET_AVX2 __attribute__ ((target ("avx2")))
+#endif
+#endif
+
+// Number of input rows converted per pass, chosen so that one pass over
+// all channels stays in L1 while the output rows are being written
+#define DECODE_ROW_BLOCK 16
+
+static_assert (sizeof (Neuropixels::electrodePacket) % sizeof (int16_t) == 0,
+               "electrodePacket must be addressable as an array of int16");
+
+static void decodeRegionScalar (const int16_t* input,
+                                int rowStart,
+                                int rowEnd,
+                                int inputStride,
+                                int channelStart,
+                                int channelEnd,
+                                const float* scale,
+                                const float* offset,
+                                float* output,
+                                int outputStride)
+{
+    for (int ch = channelStart; ch < channelEnd; ch++)
+    {
+        float* out = output + (size_t) ch * outputStride;
+
+        for (int row = rowStart; row < rowEnd; row++)
+            out[row] = float (input[(size_t) row * inputStride + ch]) * scale[ch] - offset[ch];
+    }
+}
+
+#ifdef NP_DECODE_SSE2
+
+/** Loads 4 consecutive int16 values and converts them to float */
+static inline __m128 loadInt16x4 (const int16_t* src)
+{
+    __m128i v = _mm_loadl_epi64 ((const __m128i*) src);
+    v = _mm_srai_epi32 (_mm_unpacklo_epi16 (v, v), 16); // sign-extend to 32 bits
+    return _mm_cvtepi32_ps (v);
+}
+
+/** Converts 4 rows x 4 channels per iteration, transposing in registers */
+static void decodeRegionSse2 (const int16_t* input,
+                              int rowStart,
+                              int rowEnd,
+                              int inputStride,
+                              int channelStart,
+                              int channelEnd,
+                              const float* scale,
+                              const float* offset,
+                              float* output,
+                              int outputStride)
+{
+    const int rowTileEnd = rowStart + ((rowEnd - rowStart) & ~3);
+    const int channelTileEnd = channelStart + ((channelEnd - channelStart) & ~3);
+
+    for (int ch = channelStart; ch < channelTileEnd; ch += 4)
+    {
+        const __m128 s = _mm_loadu_ps (scale + ch);
+        const __m128 o = _mm_loadu_ps (offset + ch);
+
+        float* out0 = output + (size_t) ch * outputStride;
+        float* out1 = out0 + outputStride;
+        float* out2 = out1 + outputStride;
+        float* out3 = out2 + outputStride;
+
+        for (int row = rowStart; row < rowTileEnd; row += 4)
+        {
+            const int16_t* in = input + (size_t) row * inputStride + ch;
+
+            __m128 r0 = _mm_sub_ps (_mm_mul_ps (loadInt16x4 (in), s), o);
+            __m128 r1 = _mm_sub_ps (_mm_mul_ps (loadInt16x4 (in + inputStride), s), o);
+            __m128 r2 = _mm_sub_ps (_mm_mul_ps (loadInt16x4 (in + 2 * inputStride), s), o);
+            __m128 r3 = _mm_sub_ps (_mm_mul_ps (loadInt16x4 (in + 3 * inputStride), s), o);
+
+            _MM_TRANSPOSE4_PS (r0, r1, r2, r3);
+
+            _mm_storeu_ps (out0 + row, r0);
+            _mm_storeu_ps (out1 + row, r1);
+            _mm_storeu_ps (out2 + row, r2);
+            _mm_storeu_ps (out3 + row, r3);
+        }
+    }
+
+    decodeRegionScalar (input, rowTileEnd, rowEnd, inputStride, channelStart, channelTileEnd, scale, offset, output, outputStride);
+    decodeRegionScalar (input, rowStart, rowEnd, inputStride, channelTileEnd, channelEnd, scale, offset, output, outputStride);
+}
+
+/** Converts 4 rows x 8 channels per iteration, transposing each 128-bit half in registers */
+NP_TARGET_AVX2 static void decodeRegionAvx2 (const int16_t* input,
+                                             int rowStart,
+                                             int rowEnd,
+                                             int inputStride,
+                                             int channelStart,
+                                             int channelEnd,
+                                             const float* scale,
+                                             const float* offset,
+                                             float* output,
+                                             int outputStride)
+{
+    const int rowTileEnd = rowStart + ((rowEnd - rowStart) & ~3);
+    const int channelTileEnd = channelStart + ((channelEnd - channelStart) & ~7);
+
+    for (int ch = channelStart; ch < channelTileEnd; ch += 8)
+    {
+        const __m256 s = _mm256_loadu_ps (scale + ch);
+        const __m256 o = _mm256_loadu_ps (offset + ch);
+
+        float* out = output + (size_t) ch * outputStride;
+
+        for (int row = rowStart; row < rowTileEnd; row += 4)
+        {
+            const int16_t* in = input + (size_t) row * inputStride + ch;
+
+            __m256 r[4];
+
+            for (int k = 0; k < 4; k++)
+            {
+                const __m128i raw = _mm_loadu_si128 ((const __m128i*) (in + k * inputStride));
+                r[k] = _mm256_sub_ps (_mm256_mul_ps (_mm256_cvtepi32_ps (_mm256_cvtepi16_epi32 (raw)), s), o);
+            }
+
+            __m128 lo0 = _mm256_castps256_ps128 (r[0]);
+            __m128 lo1 = _mm256_castps256_ps128 (r[1]);
+            __m128 lo2 = _mm256_castps256_ps128 (r[2]);
+            __m128 lo3 = _mm256_castps256_ps128 (r[3]);
+
+            __m128 hi0 = _mm256_extractf128_ps (r[0], 1);
+            __m128 hi1 = _mm256_extractf128_ps (r[1], 1);
+            __m128 hi2 = _mm256_extractf128_ps (r[2], 1);
+            __m128 hi3 = _mm256_extractf128_ps (r[3], 1);
+
+            _MM_TRANSPOSE4_PS (lo0, lo1, lo2, lo3);
+            _MM_TRANSPOSE4_PS (hi0, hi1, hi2, hi3);
+
+            _mm_storeu_ps (out + row, lo0);
+            _mm_storeu_ps (out + outputStride + row, lo1);
+            _mm_storeu_ps (out + 2 * (size_t) outputStride + row, lo2);
+            _mm_storeu_ps (out + 3 * (size_t) outputStride + row, lo3);
+            _mm_storeu_ps (out + 4 * (size_t) outputStride + row, hi0);
+            _mm_storeu_ps (out + 5 * (size_t) outputStride + row, hi1);
+            _mm_storeu_ps (out + 6 * (size_t) outputStride + row, hi2);
+            _mm_storeu_ps (out + 7 * (size_t) outputStride + row, hi3);
+        }
+    }
+
+    decodeRegionScalar (input, rowTileEnd, rowEnd, inputStride, channelStart, channelTileEnd, scale, offset, output, outputStride);
+    decodeRegionSse2 (input, rowStart, rowEnd, inputStride, channelTileEnd, channelEnd, scale, offset, output, outputStride);
+}
+
+static bool cpuHasAvx2()
+{
+    static const bool hasAvx2 = SystemStats::hasAVX2();
+    return hasAvx2;
+}
+
+#endif
+
+void PacketDecoder::decode (const int16_t* input,
+                            int numRows,
+                            int inputStride,
+                            const ChannelScaling& scaling,
+                            float* output,
+                            int outputStride)
+{
+    const int numChannels = scaling.getNumChannels();
+    const float* scale = scaling.scale.data();
+    const float* offset = scaling.offset.data();
+
+    for (int rowStart = 0; rowStart < numRows; rowStart += DECODE_ROW_BLOCK)
+    {
+        const int rowEnd = jmin (rowStart + DECODE_ROW_BLOCK, numRows);
+
+#ifdef NP_DECODE_SSE2
+        if (cpuHasAvx2())
+            decodeRegionAvx2 (input, rowStart, rowEnd, inputStride, 0, numChannels, scale, offset, output, outputStride);
+        else
+            decodeRegionSse2 (input, rowStart, rowEnd, inputStride, 0, numChannels, scale, offset, output, outputStride);
+#else
+        decodeRegionScalar (input, rowStart, rowEnd, inputStride, 0, numChannels, scale, offset, output, outputStride);
+#endif
+    }
+}
+
+void PacketDecoder::decodeApSuperFrames (const Neuropixels::electrodePacket* packets,
+                                         int numPackets,
+                                         const ChannelScaling& scaling,
+                                         float* output,
+                                         int outputStride)
+{
+    for (int packetNum = 0; packetNum < numPackets; packetNum++)
+    {
+        decode (&packets[packetNum].apData[0][0],
+                NP1_PROBE_SUPERFRAMESIZE,
+                NP1_PROBE_CHANNEL_COUNT,
+                scaling,
+                output + packetNum * NP1_PROBE_SUPERFRAMESIZE,
+                outputStride);
+    }
+}
+
+void PacketDecoder::decodeLfpSuperFrames (const Neuropixels::electrodePacket* packets,
+                                          int numPackets,
+                                          const ChannelScaling& scaling,
+                                          float* output,
+                                          int outputStride)
+{
+    // Consecutive LFP rows are one electrodePacket apart
+    decode (&packets[0].lfpData[0],
+            numPackets,
+            (int) (sizeof (Neuropixels::electrodePacket) / sizeof (int16_t)),
+            scaling,
+            output,
+            outputStride);
+}
+
+const char* PacketDecoder::getInstructionSetName()
+{
+#ifdef NP_DECODE_SSE2
+    return cpuHasAvx2() ? "AVX2" : "SSE2";
+#else
+    return "scalar";
+#endif
+}
@@ -0,0 +1,102 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __PACKETDECODER_H_2C4C2D67__
+#define __PACKETDECODER_H_2C4C2D67__
+
+#include <cstdint>
+#include <vector>
+
+#include "../API/NeuropixAPI.h"
+
+/**
+
+	Converts raw Neuropixels ADC words into channel-major
+	floating point samples (in microvolts).
+
+	Input is always sample-major (one row of channels per sample),
+	which is the layout of both electrodePacket::apData and the
+	payload returned by readPackets. Output is written in the
+	channel-major layout expected by DataBuffer::addToBuffer.
+
+	Uses AVX2 (selected at runtime) or SSE2 where available, with
+	a scalar fallback for other architectures.
+
+*/
+class PacketDecoder
+{
+public:
+    /** Per-channel conversion factors: output = raw * scale - offset */
+    struct ChannelScaling
+    {
+        std::vector<float> scale;
+        std::vector<float> offset;
+
+        /** Sets the same scale factor (microvolts per bit) for all channels, and clears offsets */
+        void setScale (int numChannels, float microvoltsPerBit)
+        {
+            scale.assign ((size_t) numChannels, microvoltsPerBit);
+            offset.assign ((size_t) numChannels, 0.0f);
+        }
+
+        /** Copies offsets (in microvolts); channels without an entry get no offset */
+        void setOffsets (const std::vector<float>& offsets)
+        {
+            for (size_t ch = 0; ch < offset.size(); ch++)
+                offset[ch] = ch < offsets.size() ? offsets[ch] : 0.0f;
+        }
+
+        int getNumChannels() const { return (int) scale.size(); }
+    };
+
+    /** Transposes and scales a block of sample-major int16 rows.
+
+		Sample `row` of channel `ch` is read from input[row * inputStride + ch]
+		and written to output[ch * outputStride + row].
+	*/
+    static void decode (const int16_t* input,
+                        int numRows,
+                        int inputStride,
+                        const ChannelScaling& scaling,
+                        float* output,
+                        int outputStride);
+
+    /** Decodes the AP band of a block of NP1-style superframes (12 samples per packet) */
+    static void decodeApSuperFrames (const Neuropixels::electrodePacket* packets,
+                                     int numPackets,
+                                     const ChannelScaling& scaling,
+                                     float* output,
+                                     int outputStride);
+
+    /** Decodes the LFP band of a block of NP1-style superframes (1 sample per packet) */
+    static void decodeLfpSuperFrames (const Neuropixels::electrodePacket* packets,
+                                      int numPackets,
+                                      const ChannelScaling& scaling,
+                                      float* output,
+                                      int outputStride);
+
+    /** Returns the name of the instruction set used by decode() */
+    static const char* getInstructionSetName();
+};
+
+#endif // __PACKETDECODER_H_2C4C2D67__
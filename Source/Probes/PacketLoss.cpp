@@ -0,0 +1,381 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "PacketLoss.h"
+#include "../NeuropixThread.h"
+
+// How often lost packets and status errors are summarized
+#define REPORT_INTERVAL_MS 1000
+
+// Width of one status error histogram window
+#define STATUS_WINDOW_MS 1000
+
+void PacketLossCounters::registerJump (uint32_t timestampJump, int64 sampleNumber)
+{
+    numEvents.fetch_add (1, std::memory_order_relaxed);
+    numMissingSamples.fetch_add (getMissingSamples (timestampJump), std::memory_order_relaxed);
+
+    int64 expected = -1;
+    firstSampleNumber.compare_exchange_strong (expected, sampleNumber, std::memory_order_relaxed);
+
+    expected = -1;
+    firstSinceReport.compare_exchange_strong (expected, sampleNumber, std::memory_order_relaxed);
+
+    lastSampleNumber.store (sampleNumber, std::memory_order_relaxed);
+}
+
+void PacketLossCounters::reset()
+{
+    numEvents = 0;
+    numMissingSamples = 0;
+    firstSampleNumber = -1;
+    lastSampleNumber = -1;
+    firstSinceReport = -1;
+}
+
+PacketLossCounters::Snapshot PacketLossCounters::getSnapshot() const
+{
+    Snapshot snapshot;
+
+    snapshot.numEvents = numEvents.load (std::memory_order_relaxed);
+    snapshot.numMissingSamples = numMissingSamples.load (std::memory_order_relaxed);
+    snapshot.firstSampleNumber = firstSampleNumber.load (std::memory_order_relaxed);
+    snapshot.lastSampleNumber = lastSampleNumber.load (std::memory_order_relaxed);
+
+    return snapshot;
+}
+
+int64 PacketLossCounters::getMissingSamples (uint32_t timestampJump)
+{
+    // One sample every 3.33 ticks, so a jump of 3 or 4 ticks means no loss
+    return jmax (int64 (0), int64 (std::round (double (timestampJump) * 0.3)) - 1);
+}
+
+StatusErrorCounters::StatusErrorCounters()
+{
+    reset();
+}
+
+const char* StatusErrorCounters::getErrorName (int errorType)
+{
+    static const char* names[numErrorTypes] = { "COUNT", "SERDES", "LOCK", "POP", "SYNC" };
+
+    return names[errorType];
+}
+
+uint16_t StatusErrorCounters::getErrorBit (int errorType)
+{
+    static const uint16_t bits[numErrorTypes] = { ELECTRODEPACKET_STATUS_ERR_COUNT,
+                                                  ELECTRODEPACKET_STATUS_ERR_SERDES,
+                                                  ELECTRODEPACKET_STATUS_ERR_LOCK,
+                                                  ELECTRODEPACKET_STATUS_ERR_POP,
+                                                  ELECTRODEPACKET_STATUS_ERR_SYNC };
+
+    return bits[errorType];
+}
+
+int64 StatusErrorCounters::getCurrentWindow() const
+{
+    return int64 (Time::getMillisecondCounter() - startTimeMs) / STATUS_WINDOW_MS;
+}
+
+void StatusErrorCounters::registerStatus (uint16_t status, int64 sampleNumber)
+{
+    const int64 index = getCurrentWindow();
+    Window& window = windows[index % numWindows];
+
+    int64 windowIndex = window.index.load (std::memory_order_relaxed);
+
+    if (windowIndex != index && window.index.compare_exchange_strong (windowIndex, index))
+    {
+        // First error in this window since it was last used; errors counted by another
+        // acquisition thread while it is being cleared may be lost from the histogram
+        for (auto& count : window.counts)
+            count.store (0, std::memory_order_relaxed);
+    }
+
+    for (int type = 0; type < numErrorTypes; type++)
+    {
+        if (status & getErrorBit (type))
+        {
+            totals[type].fetch_add (1, std::memory_order_relaxed);
+            window.counts[type].fetch_add (1, std::memory_order_relaxed);
+        }
+    }
+
+    lastErrorSampleNumber.store (sampleNumber, std::memory_order_relaxed);
+}
+
+void StatusErrorCounters::reset()
+{
+    for (auto& window : windows)
+    {
+        window.index = -1;
+
+        for (auto& count : window.counts)
+            count = 0;
+    }
+
+    for (auto& total : totals)
+        total = 0;
+
+    lastErrorSampleNumber = -1;
+    startTimeMs = Time::getMillisecondCounter();
+}
+
+StatusErrorCounters::Counts StatusErrorCounters::getTotals() const
+{
+    Counts counts;
+
+    for (int type = 0; type < numErrorTypes; type++)
+        counts[type] = totals[type].load (std::memory_order_relaxed);
+
+    return counts;
+}
+
+StatusErrorCounters::Counts StatusErrorCounters::getRecent (int numSeconds) const
+{
+    Counts counts {};
+
+    const int64 current = getCurrentWindow();
+
+    for (const auto& window : windows)
+    {
+        const int64 index = window.index.load (std::memory_order_relaxed);
+
+        if (index < 0 || index > current || current - index >= numSeconds)
+            continue;
+
+        for (int type = 0; type < numErrorTypes; type++)
+            counts[type] += window.counts[type].load (std::memory_order_relaxed);
+    }
+
+    return counts;
+}
+
+std::map<int64, StatusErrorCounters::Counts> StatusErrorCounters::getHistogram() const
+{
+    std::map<int64, Counts> histogram;
+
+    const int64 current = getCurrentWindow();
+
+    for (const auto& window : windows)
+    {
+        const int64 index = window.index.load (std::memory_order_relaxed);
+
+        if (index < 0 || index > current || current - index >= numWindows)
+            continue;
+
+        Counts& counts = histogram[index];
+
+        for (int type = 0; type < numErrorTypes; type++)
+            counts[type] = window.counts[type].load (std::memory_order_relaxed);
+    }
+
+    return histogram;
+}
+
+PacketLossReporter::PacketLossReporter (NeuropixThread* neuropixThread_)
+    : Thread ("Packet loss reporter"),
+      neuropixThread (neuropixThread_)
+{
+}
+
+PacketLossReporter::~PacketLossReporter()
+{
+    stopThread (1000);
+}
+
+void PacketLossReporter::start (const Array<Probe*>& probes_)
+{
+    stop();
+
+    probes = probes_;
+    reported.clear();
+
+    for (auto probe : probes)
+    {
+        probe->packetLoss.reset();
+        probe->statusErrors.reset();
+        reported[probe] = PacketLossCounters::Snapshot();
+        reportedStatusErrors[probe] = StatusErrorCounters::Counts {};
+    }
+
+    startThread (Thread::Priority::low);
+}
+
+void PacketLossReporter::stop()
+{
+    if (isThreadRunning())
+    {
+        signalThreadShouldExit();
+        notify();
+        stopThread (1000);
+    }
+}
+
+void PacketLossReporter::run()
+{
+    while (! threadShouldExit())
+    {
+        wait (REPORT_INTERVAL_MS);
+
+        report();
+    }
+}
+
+void PacketLossReporter::report()
+{
+    for (auto probe : probes)
+    {
+        reportStatusErrors (probe);
+
+        const PacketLossCounters::Snapshot current = probe->packetLoss.getSnapshot();
+        PacketLossCounters::Snapshot& previous = reported[probe];
+
+        if (current.numEvents == previous.numEvents)
+            continue;
+
+        const int64 firstSample = probe->packetLoss.takeFirstSampleSinceLastReport();
+
+        String msg = "NPX TIMESTAMP JUMP: " + String (current.numEvents - previous.numEvents) + " jump(s), "
+                     + String (current.numMissingSamples - previous.numMissingSamples) + " samples missing...Possible data loss on slot "
+                     + String (probe->basestation->slot) + ", probe " + String (probe->headstage->port)
+                     + " between sample numbers " + String (firstSample) + " and " + String (current.lastSampleNumber);
+
+        LOGC (msg);
+
+        neuropixThread->sendBroadcastMessage (msg);
+
+        previous = current;
+    }
+}
+
+void PacketLossReporter::reportStatusErrors (Probe* probe)
+{
+    const StatusErrorCounters::Counts current = probe->statusErrors.getTotals();
+    StatusErrorCounters::Counts& previous = reportedStatusErrors[probe];
+
+    if (current == previous)
+        return;
+
+    StringArray counts;
+
+    for (int type = 0; type < StatusErrorCounters::numErrorTypes; type++)
+    {
+        if (current[type] != previous[type])
+            counts.add (String (current[type] - previous[type]) + " " + StatusErrorCounters::getErrorName (type));
+    }
+
+    String msg = "NPX STATUS ERRORS: " + counts.joinIntoString (", ") + " on slot "
+                 + String (probe->basestation->slot) + ", probe " + String (probe->headstage->port)
+                 + " (last at sample number " + String (probe->statusErrors.getLastErrorSampleNumber()) + ")";
+
+    LOGC (msg);
+
+    neuropixThread->sendBroadcastMessage (msg);
+
+    previous = current;
+}
+
+String PacketLossReporter::getStatsString (const Array<Probe*>& probes)
+{
+    Array<var> entries;
+
+    for (auto probe : probes)
+    {
+        const PacketLossCounters::Snapshot loss = probe->packetLoss.getSnapshot();
+
+        DynamicObject::Ptr p = new DynamicObject();
+
+        p->setProperty (Identifier ("name"), probe->displayName);
+        p->setProperty (Identifier ("slot"), probe->basestation->slot);
+        p->setProperty (Identifier ("port"), probe->headstage->port);
+        p->setProperty (Identifier ("dock"), probe->dock);
+
+        p->setProperty (Identifier ("timestamp_jumps"), loss.numEvents);
+        p->setProperty (Identifier ("missing_samples"), loss.numMissingSamples);
+        p->setProperty (Identifier ("first_jump_sample_number"), loss.firstSampleNumber);
+        p->setProperty (Identifier ("last_jump_sample_number"), loss.lastSampleNumber);
+
+        p->setProperty (Identifier ("fifo_fill_percent"), 100.0 * probe->fifoFillPercentage);
+
+        const StatusErrorCounters::Counts totals = probe->statusErrors.getTotals();
+
+        DynamicObject::Ptr errors = new DynamicObject();
+
+        for (int type = 0; type < StatusErrorCounters::numErrorTypes; type++)
+            errors->setProperty (Identifier (StatusErrorCounters::getErrorName (type)), totals[type]);
+
+        p->setProperty (Identifier ("status_errors"), errors.get());
+
+        Array<var> windows;
+
+        for (const auto& window : probe->statusErrors.getHistogram())
+        {
+            DynamicObject::Ptr w = new DynamicObject();
+
+            w->setProperty (Identifier ("second"), window.first);
+
+            for (int type = 0; type < StatusErrorCounters::numErrorTypes; type++)
+                w->setProperty (Identifier (StatusErrorCounters::getErrorName (type)), window.second[type]);
+
+            windows.add (w.get());
+        }
+
+        p->setProperty (Identifier ("status_error_windows"), windows);
+
+        entries.add (p.get());
+    }
+
+    Array<var> basestationEntries;
+    Array<Basestation*> basestations;
+
+    for (auto probe : probes)
+        basestations.addIfNotAlreadyThere (probe->basestation);
+
+    for (auto basestation : basestations)
+    {
+        DynamicObject::Ptr b = new DynamicObject();
+
+        b->setProperty (Identifier ("slot"), basestation->slot);
+        b->setProperty (Identifier ("clock_drift_ppm"), basestation->clock.getDriftPpm());
+        b->setProperty (Identifier ("ap_sample_rate_hz"), basestation->clock.getSampleRate (30000.0));
+        b->setProperty (Identifier ("clock_residual_us"), basestation->clock.getResidualUs());
+        b->setProperty (Identifier ("clock_observations"), basestation->clock.getNumObservations());
+        b->setProperty (Identifier ("clock_rejected"), basestation->clock.getNumRejected());
+
+        basestationEntries.add (b.get());
+    }
+
+    DynamicObject output;
+
+    output.setProperty (Identifier ("probes"), entries);
+    output.setProperty (Identifier ("basestations"), basestationEntries);
+
+    MemoryOutputStream f;
+    output.writeAsJSON (f, JSON::FormatOptions {}.withIndentLevel (0).withSpacing (JSON::Spacing::singleLine).withMaxDecimalPlaces (4));
+
+    return f.toString();
+}
@@ -0,0 +1,213 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef __PACKETLOSS_H_2C4C2D67__
+#define __PACKETLOSS_H_2C4C2D67__
+
+#include <DataThreadHeaders.h>
+
+#include "../API/NeuropixAPI.h"
+
+#include <array>
+#include <atomic>
+#include <map>
+
+class NeuropixThread;
+class Probe;
+
+/**
+
+	Counts jumps in the 100 kHz hardware timestamp (i.e. lost packets)
+	for one probe.
+
+	Updated by the acquisition thread(s) with a few atomic operations
+	per jump, so a burst of loss does not slow acquisition down further;
+	PacketLossReporter turns the counts into log and broadcast messages.
+
+*/
+class PacketLossCounters
+{
+public:
+    /** Cumulative counts since the last reset */
+    struct Snapshot
+    {
+        int64 numEvents = 0;
+        int64 numMissingSamples = 0;
+        int64 firstSampleNumber = -1; // AP sample number of the first jump (-1 = none)
+        int64 lastSampleNumber = -1; // AP sample number of the most recent jump
+    };
+
+    /** Registers a timestamp jump seen at an AP sample number (acquisition thread) */
+    void registerJump (uint32_t timestampJump, int64 sampleNumber);
+
+    /** Clears all counts (call while no acquisition thread is running) */
+    void reset();
+
+    /** Returns the cumulative counts (thread safe) */
+    Snapshot getSnapshot() const;
+
+    /** Returns the sample number of the first jump since the previous call, or -1 */
+    int64 takeFirstSampleSinceLastReport() { return firstSinceReport.exchange (-1); }
+
+    /** Number of 30 kHz samples missing for a jump of the 100 kHz timestamp */
+    static int64 getMissingSamples (uint32_t timestampJump);
+
+private:
+    std::atomic<int64> numEvents { 0 };
+    std::atomic<int64> numMissingSamples { 0 };
+    std::atomic<int64> firstSampleNumber { -1 };
+    std::atomic<int64> lastSampleNumber { -1 };
+    std::atomic<int64> firstSinceReport { -1 };
+};
+
+/**
+
+	Counts the error flags in packet status words for one probe, in
+	total and per one-second window (for the last numWindows seconds).
+
+	The acquisition engines only call registerStatus() for samples whose
+	status word has an error bit set, which they find by OR-ing the status
+	words of each batch together, so error-free batches cost one pass
+	over the status words.
+
+*/
+class StatusErrorCounters
+{
+public:
+    enum ErrorType
+    {
+        ERR_COUNT = 0,
+        ERR_SERDES,
+        ERR_LOCK,
+        ERR_POP,
+        ERR_SYNC,
+        numErrorTypes
+    };
+
+    /** Status bits that indicate an error */
+    static constexpr uint16_t errorMask = ELECTRODEPACKET_STATUS_ERR_COUNT
+                                          | ELECTRODEPACKET_STATUS_ERR_SERDES
+                                          | ELECTRODEPACKET_STATUS_ERR_LOCK
+                                          | ELECTRODEPACKET_STATUS_ERR_POP
+                                          | ELECTRODEPACKET_STATUS_ERR_SYNC;
+
+    /** Number of one-second windows kept for the histogram */
+    static constexpr int numWindows = 60;
+
+    /** Error counts by type */
+    typedef std::array<int64, numErrorTypes> Counts;
+
+    /** Constructor */
+    StatusErrorCounters();
+
+    /** Counts the error flags set in one status word (acquisition thread) */
+    void registerStatus (uint16_t status, int64 sampleNumber);
+
+    /** Clears all counts and restarts the window clock (call while no acquisition thread is running) */
+    void reset();
+
+    /** Returns the number of errors of each type since the last reset */
+    Counts getTotals() const;
+
+    /** Returns the number of errors of each type in the most recent numSeconds windows */
+    Counts getRecent (int numSeconds) const;
+
+    /** Returns the counts of every window in the histogram that has errors, keyed by seconds since the last reset */
+    std::map<int64, Counts> getHistogram() const;
+
+    /** Returns the AP sample number of the most recent error (-1 = none) */
+    int64 getLastErrorSampleNumber() const { return lastErrorSampleNumber; }
+
+    /** Returns the short name of an error type, as used in messages and exported statistics */
+    static const char* getErrorName (int errorType);
+
+    /** Returns the status bit of an error type */
+    static uint16_t getErrorBit (int errorType);
+
+private:
+    /** Seconds since the last reset */
+    int64 getCurrentWindow() const;
+
+    struct Window
+    {
+        std::atomic<int64> index { -1 };
+        std::atomic<int64> counts[numErrorTypes];
+    };
+
+    Window windows[numWindows];
+
+    std::atomic<int64> totals[numErrorTypes];
+    std::atomic<int64> lastErrorSampleNumber { -1 };
+
+    uint32 startTimeMs = 0;
+};
+
+/**
+
+	Low-priority thread that periodically logs and broadcasts one summary
+	message per probe that lost packets or received packets with status
+	errors since the previous report, instead of one message per event.
+
+	Also provides the statistics returned by the "NP STATS" config message.
+
+*/
+class PacketLossReporter : public Thread
+{
+public:
+    /** Constructor */
+    PacketLossReporter (NeuropixThread* neuropixThread);
+
+    /** Destructor */
+    ~PacketLossReporter();
+
+    /** Clears the probes' counters and starts reporting on them */
+    void start (const Array<Probe*>& probes);
+
+    /** Sends a final report and stops the thread */
+    void stop();
+
+    /** Reports loss every REPORT_INTERVAL_MS */
+    void run() override;
+
+    /** Returns the packet loss, status errors and FIFO fill of every probe, and the
+        clock drift of their basestations, as JSON */
+    static String getStatsString (const Array<Probe*>& probes);
+
+private:
+    /** Sends one message per probe with new loss or status errors since the previous report */
+    void report();
+
+    /** Sends one message if a probe has new status errors since the previous report */
+    void reportStatusErrors (Probe* probe);
+
+    NeuropixThread* neuropixThread;
+
+    Array<Probe*> probes;
+
+    /** Counts at the time of the previous report */
+    std::map<Probe*, PacketLossCounters::Snapshot> reported;
+    std::map<Probe*, StatusErrorCounters::Counts> reportedStatusErrors;
+};
+
+#endif // __PACKETLOSS_H_2C4C2D67__
@@ -0,0 +1,324 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "PollingScheduler.h"
+
+// How often the FIFO fill level is refreshed for the FIFO monitor
+#define FIFO_QUERY_INTERVAL_US 100000.0
+
+// Reads smaller than this are too coarse to update the arrival rate estimate
+#define MIN_PACKETS_FOR_RATE_ESTIMATE 4
+
+// Extra spin time on top of the measured oversleep
+#define SPIN_MARGIN_US 50.0
+
+DeadlineTimer::DeadlineTimer()
+    : microsecondsPerTick (1.0e6 / double (Time::getHighResolutionTicksPerSecond()))
+{
+}
+
+void DeadlineTimer::waitUntil (int64 deadlineTicks, Thread& thread)
+{
+    int64 now = Time::getHighResolutionTicks();
+
+    const double remainingUs = double (deadlineTicks - now) * microsecondsPerTick;
+
+    if (remainingUs <= 0.0)
+        return;
+
+    const double sleepUs = remainingUs - oversleepUs - SPIN_MARGIN_US;
+
+    if (sleepUs > 0.0)
+    {
+        std::this_thread::sleep_for (std::chrono::microseconds (int64 (sleepUs)));
+
+        const int64 afterSleep = Time::getHighResolutionTicks();
+        const double actualUs = double (afterSleep - now) * microsecondsPerTick;
+
+        oversleepUs = 0.9 * oversleepUs + 0.1 * jlimit (0.0, 5000.0, actualUs - sleepUs);
+
+        sleepTicks += afterSleep - now;
+        now = afterSleep;
+    }
+
+    const int64 spinStart = now;
+
+    while (now < deadlineTicks && ! thread.threadShouldExit())
+    {
+        std::this_thread::yield();
+        now = Time::getHighResolutionTicks();
+    }
+
+    spinTicks += now - spinStart;
+}
+
+void DeadlineTimer::resetStatistics()
+{
+    sleepTicks = 0;
+    spinTicks = 0;
+}
+
+PollingScheduler::PollingScheduler()
+    : microsecondsPerTick (1.0e6 / double (Time::getHighResolutionTicksPerSecond()))
+{
+    for (auto& count : processingHistogram)
+        count = 0;
+}
+
+void PollingScheduler::prepare (const Settings& settings_, double nominalPacketIntervalUs_, int maxPacketsPerRead_)
+{
+    settings = settings_;
+    nominalPacketIntervalUs = nominalPacketIntervalUs_;
+    maxPacketsPerRead = maxPacketsPerRead_;
+
+    packetIntervalUs = nominalPacketIntervalUs;
+
+    const int64 now = Time::getHighResolutionTicks();
+
+    packetsAtReference = 0.0;
+    referenceTicks = now;
+    lastReadTicks = now;
+    lastFifoQueryTicks = 0;
+    backlogged = false;
+
+    startTicks = now;
+    processStartTicks = now;
+
+    timer.resetStatistics();
+    processTicks = 0;
+    numReads = 0;
+    numPackets = 0;
+    numFifoQueries = 0;
+    minHeadroom = -1;
+    maxFifoFill = 0.0;
+
+    for (auto& count : processingHistogram)
+        count = 0;
+}
+
+void PollingScheduler::packetsRead (int numRead, int numRequested, int64 nowTicks)
+{
+    numReads++;
+    numPackets += numRead;
+
+    const double expectedPackets = packetsAtReference + ticksToMicroseconds (nowTicks - referenceTicks) / packetIntervalUs;
+
+    if (numRead >= numRequested && expectedPackets - double (numRead) >= 1.0)
+    {
+        // More packets are probably waiting, so read again straight away
+        backlogged = true;
+    }
+    else
+    {
+        // The FIFO has been drained: if the previous read drained it too,
+        // numRead packets arrived since then
+        if (! backlogged && numRead >= MIN_PACKETS_FOR_RATE_ESTIMATE)
+        {
+            const double observedIntervalUs = ticksToMicroseconds (nowTicks - lastReadTicks) / double (numRead);
+
+            packetIntervalUs = 0.95 * packetIntervalUs
+                               + 0.05 * jlimit (0.5 * nominalPacketIntervalUs, 2.0 * nominalPacketIntervalUs, observedIntervalUs);
+        }
+
+        backlogged = false;
+    }
+
+    packetsAtReference = 0.0;
+    referenceTicks = nowTicks;
+    lastReadTicks = nowTicks;
+}
+
+bool PollingScheduler::shouldQueryFifo (int64 nowTicks) const
+{
+    return lastFifoQueryTicks == 0 || ticksToMicroseconds (nowTicks - lastFifoQueryTicks) >= FIFO_QUERY_INTERVAL_US;
+}
+
+void PollingScheduler::fifoStatusRead (int packetsAvailable, int headroom, int64 nowTicks)
+{
+    numFifoQueries++;
+
+    if (minHeadroom < 0 || headroom < minHeadroom)
+        minHeadroom = headroom;
+
+    if (packetsAvailable + headroom > 0)
+        maxFifoFill = jmax (maxFifoFill.load(), double (packetsAvailable) / double (packetsAvailable + headroom));
+
+    lastFifoQueryTicks = nowTicks;
+
+    packetsAtReference = double (packetsAvailable);
+    referenceTicks = nowTicks;
+
+    if (packetsAvailable >= maxPacketsPerRead)
+        backlogged = true;
+}
+
+int PollingScheduler::getTargetBatchSize() const
+{
+    const int minBatch = jlimit (1, maxPacketsPerRead, settings.minBatchPackets);
+
+    if (settings.targetLatencyUs <= 0.0)
+        return maxPacketsPerRead;
+
+    return jlimit (minBatch, maxPacketsPerRead, int (settings.targetLatencyUs / packetIntervalUs));
+}
+
+double PollingScheduler::getTimeUntilNextRead (int64 nowTicks) const
+{
+    if (backlogged)
+        return 0.0;
+
+    const double expectedPackets = packetsAtReference + ticksToMicroseconds (nowTicks - referenceTicks) / packetIntervalUs;
+    const double missingPackets = double (getTargetBatchSize()) - expectedPackets;
+
+    return jmax (0.0, missingPackets * packetIntervalUs);
+}
+
+void PollingScheduler::waitForNextRead (Thread& thread)
+{
+    wait (getTimeUntilNextRead (Time::getHighResolutionTicks()), thread);
+}
+
+void PollingScheduler::wait (double microseconds, Thread& thread)
+{
+    if (microseconds > 0.0)
+        timer.waitUntil (Time::getHighResolutionTicks() + int64 (microseconds / microsecondsPerTick), thread);
+}
+
+void PollingScheduler::startProcessing()
+{
+    processStartTicks = Time::getHighResolutionTicks();
+}
+
+void PollingScheduler::stopProcessing()
+{
+    const int64 ticks = Time::getHighResolutionTicks() - processStartTicks;
+
+    processTicks += ticks;
+
+    const double us = jmax (minProcessingBinUs, ticksToMicroseconds (ticks));
+
+    processingHistogram[jmin (numProcessingBins - 1, int (4.0 * std::log2 (us / minProcessingBinUs)))]++;
+}
+
+PollingScheduler::Statistics PollingScheduler::getStatistics() const
+{
+    Statistics stats;
+
+    stats.elapsedSeconds = ticksToMicroseconds (Time::getHighResolutionTicks() - startTicks) / 1e6;
+    stats.sleepSeconds = ticksToMicroseconds (timer.getSleepTicks()) / 1e6;
+    stats.spinSeconds = ticksToMicroseconds (timer.getSpinTicks()) / 1e6;
+    stats.processSeconds = ticksToMicroseconds (processTicks) / 1e6;
+    stats.numReads = numReads;
+    stats.numPackets = numPackets;
+    stats.numFifoQueries = numFifoQueries;
+    stats.packetIntervalUs = packetIntervalUs;
+    stats.minHeadroom = minHeadroom;
+    stats.maxFifoFill = maxFifoFill;
+
+    return stats;
+}
+
+double PollingScheduler::getProcessingPercentileUs (double percentile) const
+{
+    int64 counts[numProcessingBins];
+    int64 total = 0;
+
+    for (int i = 0; i < numProcessingBins; i++)
+        total += (counts[i] = processingHistogram[i]);
+
+    if (total == 0)
+        return 0.0;
+
+    const int64 rank = jmax (int64 (1), int64 (std::ceil (double (total) * jlimit (0.0, 100.0, percentile) / 100.0)));
+
+    int64 cumulative = 0;
+
+    for (int i = 0; i < numProcessingBins; i++)
+    {
+        cumulative += counts[i];
+
+        // Geometric centre of the bin
+        if (cumulative >= rank)
+            return minProcessingBinUs * std::pow (2.0, (double (i) + 0.5) / 4.0);
+    }
+
+    return minProcessingBinUs * std::pow (2.0, double (numProcessingBins) / 4.0);
+}
+
+String PollingScheduler::getSummary() const
+{
+    const Statistics stats = getStatistics();
+
+    if (stats.elapsedSeconds <= 0.0 || stats.numReads == 0)
+        return "no reads";
+
+    auto percent = [&] (double seconds)
+    { return String (100.0 * seconds / stats.elapsedSeconds, 1) + "%"; };
+
+    return "decode " + percent (stats.processSeconds)
+           + ", sleep " + percent (stats.sleepSeconds)
+           + ", spin " + percent (stats.spinSeconds)
+           + ", " + String (stats.numReads) + " reads"
+           + " (mean " + String (double (stats.numPackets) / double (stats.numReads), 1) + " packets)"
+           + ", " + String (stats.numFifoQueries) + " FIFO queries"
+           + ", packet interval " + String (stats.packetIntervalUs, 2) + " us";
+}
+
+void SimulatedFifo::start (double packetIntervalUs, int capacityPackets, int64 nowTicks)
+{
+    packetIntervalTicks = packetIntervalUs * 1.0e-6 * double (Time::getHighResolutionTicksPerSecond());
+    capacity = capacityPackets;
+
+    startTicks = nowTicks;
+    numConsumed = 0;
+    numOverflowed = 0;
+}
+
+int64 SimulatedFifo::getNumArrived (int64 nowTicks) const
+{
+    return int64 (double (nowTicks - startTicks) / packetIntervalTicks);
+}
+
+int SimulatedFifo::getPacketsAvailable (int64 nowTicks) const
+{
+    return (int) jmin (int64 (capacity), getNumArrived (nowTicks) - numConsumed - numOverflowed);
+}
+
+int SimulatedFifo::getHeadroom (int64 nowTicks) const
+{
+    return capacity - getPacketsAvailable (nowTicks);
+}
+
+int SimulatedFifo::read (int numRequested, int64 nowTicks)
+{
+    const int64 waiting = getNumArrived (nowTicks) - numConsumed - numOverflowed;
+
+    if (waiting > capacity)
+        numOverflowed += waiting - capacity;
+
+    const int numRead = jmin (numRequested, getPacketsAvailable (nowTicks));
+
+    numConsumed += numRead;
+
+    return numRead;
+}
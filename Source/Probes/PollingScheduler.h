@@ -0,0 +1,237 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __POLLINGSCHEDULER_H_2C4C2D67__
+#define __POLLINGSCHEDULER_H_2C4C2D67__
+
+#include <DataThreadHeaders.h>
+
+#include <atomic>
+
+/**
+
+	Waits for a deadline given in high-resolution ticks: sleeps until
+	shortly before it and spins (yielding) for the remainder. The spin
+	window tracks the measured oversleep of the OS timer.
+
+*/
+class DeadlineTimer
+{
+public:
+    /** Constructor */
+    DeadlineTimer();
+
+    /** Returns once deadlineTicks has passed, or the thread is asked to exit */
+    void waitUntil (int64 deadlineTicks, Thread& thread);
+
+    /** Clears the time statistics */
+    void resetStatistics();
+
+    /** Total time spent sleeping and spinning (thread safe) */
+    int64 getSleepTicks() const { return sleepTicks; }
+    int64 getSpinTicks() const { return spinTicks; }
+
+private:
+    /** Measured oversleep of the OS timer, used as the spin window */
+    double oversleepUs = 200.0;
+
+    const double microsecondsPerTick;
+
+    std::atomic<int64> sleepTicks { 0 };
+    std::atomic<int64> spinTicks { 0 };
+};
+
+/**
+
+	Decides when a DataSource thread should read from its hardware FIFO.
+
+	Instead of querying the FIFO fill level on every iteration and sleeping
+	for a fixed time per missing packet, the scheduler learns the packet
+	arrival rate from the reads themselves and computes a deadline at which
+	the requested batch should be ready, which the thread waits for with a
+	DeadlineTimer.
+
+	All decisions are made from the tick values passed in, so the scheduler
+	can be driven by SimulatedFifo (or any other clock) as well as by the
+	real hardware.
+
+*/
+class PollingScheduler
+{
+public:
+    /** User-configurable polling behaviour */
+    struct Settings
+    {
+        /** Maximum time a sample should wait in the FIFO, in microseconds (0 = wait for a full read batch) */
+        double targetLatencyUs = 0.0;
+
+        /** Fewest packets to wait for before reading */
+        int minBatchPackets = 1;
+
+        /** Largest read, in 12-sample superframes (0 = the probe's default batch) */
+        int readBatchSuperFrames = 0;
+
+        /** Upper limit for readBatchSuperFrames (about 410 ms at 30 kHz) */
+        static constexpr int maxReadBatchSuperFrames = 1024;
+
+        /** Duration of one superframe at 30 kHz, in microseconds */
+        static constexpr double superFrameDurationUs = 400.0;
+    };
+
+    /** Time spent in each phase of the acquisition loop */
+    struct Statistics
+    {
+        double elapsedSeconds = 0.0;
+        double sleepSeconds = 0.0;
+        double spinSeconds = 0.0;
+        double processSeconds = 0.0;
+        int64 numReads = 0;
+        int64 numPackets = 0;
+        int64 numFifoQueries = 0;
+        double packetIntervalUs = 0.0;
+        int minHeadroom = -1; // smallest FIFO headroom seen, in packets (-1 = never queried)
+        double maxFifoFill = 0.0; // largest FIFO fill level seen (0-1)
+    };
+
+    /** Constructor */
+    PollingScheduler();
+
+    /** Resets all estimates; call before acquisition starts */
+    void prepare (const Settings& settings, double nominalPacketIntervalUs, int maxPacketsPerRead);
+
+    /** Registers the result of a read (called after every read, including empty ones) */
+    void packetsRead (int numPackets, int numRequested, int64 nowTicks);
+
+    /** Returns true if the FIFO fill level should be queried on this iteration */
+    bool shouldQueryFifo (int64 nowTicks) const;
+
+    /** Registers the result of a FIFO status query */
+    void fifoStatusRead (int packetsAvailable, int headroom, int64 nowTicks);
+
+    /** Returns the number of microseconds until the next read is due (0 = read immediately) */
+    double getTimeUntilNextRead (int64 nowTicks) const;
+
+    /** Returns the number of packets the next read should wait for */
+    int getTargetBatchSize() const;
+
+    /** Returns the current estimate of the time between packets */
+    double getPacketIntervalUs() const { return packetIntervalUs; }
+
+    /** Sleeps and then spins until the next read is due, or the thread is asked to exit */
+    void waitForNextRead (Thread& thread);
+
+    /** Sleeps and then spins for the given time, or until the thread is asked to exit */
+    void wait (double microseconds, Thread& thread);
+
+    /** Brackets the decoding of a batch, for the time statistics */
+    void startProcessing();
+    void stopProcessing();
+
+    /** Returns time statistics since prepare() was called (thread safe) */
+    Statistics getStatistics() const;
+
+    /** Returns the given percentile (0-100) of the time taken to decode one batch,
+        in microseconds, to within a quarter octave (thread safe) */
+    double getProcessingPercentileUs (double percentile) const;
+
+    /** Returns a one-line summary of the statistics */
+    String getSummary() const;
+
+private:
+    double ticksToMicroseconds (int64 ticks) const { return double (ticks) * microsecondsPerTick; }
+
+    /** Batch decode times are counted in quarter-octave bins from 0.25 us to about 4 s */
+    static constexpr int numProcessingBins = 96;
+    static constexpr double minProcessingBinUs = 0.25;
+
+    Settings settings;
+
+    double nominalPacketIntervalUs = 400.0;
+    int maxPacketsPerRead = 64;
+
+    /** Learned from drained reads, clamped to a factor of 2 around the nominal value */
+    double packetIntervalUs = 400.0;
+
+    /** Estimated number of packets in the FIFO at referenceTicks */
+    double packetsAtReference = 0.0;
+    int64 referenceTicks = 0;
+
+    int64 lastReadTicks = 0;
+    int64 lastFifoQueryTicks = 0;
+    bool backlogged = false;
+
+    DeadlineTimer timer;
+
+    int64 startTicks = 0;
+    int64 processStartTicks = 0;
+
+    const double microsecondsPerTick;
+
+    std::atomic<int64> processTicks { 0 };
+    std::atomic<int64> numReads { 0 };
+    std::atomic<int64> numPackets { 0 };
+    std::atomic<int64> numFifoQueries { 0 };
+    std::atomic<int> minHeadroom { -1 };
+    std::atomic<double> maxFifoFill { 0.0 };
+
+    std::atomic<int64> processingHistogram[numProcessingBins];
+};
+
+/**
+
+	Software model of a hardware packet FIFO: packets arrive at a fixed
+	rate from the moment start() is called and are removed by read().
+	Used by SimulatedProbe, and useful for exercising PollingScheduler
+	without hardware.
+
+*/
+class SimulatedFifo
+{
+public:
+    /** Starts filling the FIFO */
+    void start (double packetIntervalUs, int capacityPackets, int64 nowTicks);
+
+    /** Returns the number of packets waiting at nowTicks */
+    int getPacketsAvailable (int64 nowTicks) const;
+
+    /** Returns the free space at nowTicks */
+    int getHeadroom (int64 nowTicks) const;
+
+    /** Removes up to numRequested packets and returns the number removed */
+    int read (int numRequested, int64 nowTicks);
+
+    /** Returns the number of packets that were lost because the FIFO was full */
+    int64 getNumOverflowedPackets() const { return numOverflowed; }
+
+private:
+    int64 getNumArrived (int64 nowTicks) const;
+
+    double packetIntervalTicks = 1.0;
+    int capacity = 0;
+
+    int64 startTicks = 0;
+    int64 numConsumed = 0;
+    int64 numOverflowed = 0;
+};
+
+#endif // __POLLINGSCHEDULER_H_2C4C2D67__
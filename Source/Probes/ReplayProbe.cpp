@@ -0,0 +1,128 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "ReplayProbe.h"
+#include "Geometry.h"
+
+String ReplayProbe::getSimulatedPartNumber (const PacketCapture::FileHeader& header)
+{
+    const String partNumber (header.partNumber);
+
+    Array<ElectrodeMetadata> electrodeMetadata;
+    ProbeMetadata probeMetadata;
+
+    if (partNumber == "NP1300")
+        return partNumber;
+
+    if (partNumber.isNotEmpty() && Geometry::forPartNumber (partNumber, electrodeMetadata, probeMetadata))
+    {
+        if (probeMetadata.type != ProbeType::QUAD_BASE)
+            return partNumber;
+
+        return "NP2013";
+    }
+
+    return header.format == 0 ? "PRB_1_4_0480_1" : "NP2003";
+}
+
+ReplayProbe::ReplayProbe (Basestation* bs,
+                          Headstage* hs,
+                          Flex* fl,
+                          std::unique_ptr<CaptureReplay> replay_)
+    : SimulatedProbe (bs, hs, fl, 1, getSimulatedPartNumber (replay_->getHeader()), (int) replay_->getHeader().serialNumber),
+      replay (std::move (replay_))
+{
+    const PacketCapture::FileHeader& header = replay->getHeader();
+
+    channel_count = (int) header.numChannels;
+
+    if (header.format == 0)
+    {
+        if (header.numChannels == NHPPassiveTraits::numChannels)
+            acquisitionEngine = std::make_unique<AcquisitionEngine<NHPPassiveTraits>> (this, apScaling, lfpScaling);
+        else
+            acquisitionEngine = std::make_unique<AcquisitionEngine<NP1Traits>> (this, apScaling, lfpScaling);
+    }
+    else
+    {
+        Array<ElectrodeMetadata> electrodeMetadata;
+        ProbeMetadata probeMetadata;
+
+        const bool isQuadBase = Geometry::forPartNumber (String (header.partNumber), electrodeMetadata, probeMetadata)
+                                && probeMetadata.type == ProbeType::QUAD_BASE;
+
+        if (isQuadBase)
+            acquisitionEngine = std::make_unique<AcquisitionEngine<QuadBaseShankTraits>> (this, apScaling, lfpScaling, (Neuropixels::streamsource_t) header.source);
+        else
+            acquisitionEngine = std::make_unique<AcquisitionEngine<NP2Traits>> (this, apScaling, lfpScaling, (Neuropixels::streamsource_t) header.source);
+    }
+
+    if (! acquisitionEngine->setReplay (replay.get()))
+        isValid = false;
+}
+
+bool ReplayProbe::generatesLfpData()
+{
+    return replay->getHeader().format == 0;
+}
+
+void ReplayProbe::startAcquisition()
+{
+    if (surveyModeActive && ! isEnabledForSurvey)
+        return;
+
+    apBuffer->clear();
+    apView->reset();
+
+    if (generatesLfpData())
+    {
+        lfpBuffer->clear();
+        lfpView->reset();
+    }
+
+    const PacketCapture::FileHeader& header = replay->getHeader();
+
+    // Files without scale factors are shown in bits
+    setSampleScaling (header.apMicrovoltsPerBit > 0.0f ? header.apMicrovoltsPerBit : 1.0f,
+                      header.lfpMicrovoltsPerBit > 0.0f ? header.lfpMicrovoltsPerBit : 1.0f);
+
+    if (generatesLfpData())
+        acquisitionEngine->setOutputs (apBuffer, apView.get(), lfpBuffer, lfpView.get());
+    else
+        acquisitionEngine->setOutputs (apBuffer, apView.get());
+
+    acquisitionEngine->reset (sendSync, invertSyncLine);
+
+    startAcquisitionThread();
+}
+
+void ReplayProbe::stopAcquisition()
+{
+    signalThreadShouldExit();
+}
+
+void ReplayProbe::run()
+{
+    acquisitionEngine->run (*this);
+}
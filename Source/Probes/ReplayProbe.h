@@ -0,0 +1,78 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef __REPLAYPROBE_H_2C4C2D67__
+#define __REPLAYPROBE_H_2C4C2D67__
+
+#include "AcquisitionEngine.h"
+#include "SimulatedProbe.h"
+
+/**
+
+	Replays a packet capture file through the same AcquisitionEngine
+	specialization that acquired it, so the decoding and timing code of
+	the hardware probes can be exercised without a basestation.
+
+	Probe metadata (geometry, gains, references) comes from the part
+	number stored in the capture file. Quad Base shanks are captured as
+	separate streams and are replayed as single-stream 4-shank probes.
+
+*/
+class ReplayProbe : public SimulatedProbe
+{
+public:
+    /** Constructor */
+    ReplayProbe (Basestation*,
+                 Headstage*,
+                 Flex*,
+                 std::unique_ptr<CaptureReplay> replay);
+
+    /** Sets the scale factors, clears buffers, and starts the thread */
+    void startAcquisition() override;
+
+    /** Stops the thread */
+    void stopAcquisition() override;
+
+    /** Signals whether this probe has an LFP data stream */
+    bool generatesLfpData() override;
+
+    /** Replays packets until the thread is asked to exit */
+    void run() override;
+
+    /** Lets the basestation run the acquisition engine on a shared worker thread */
+    Array<AcquisitionTask*> getAcquisitionTasks() override { return { acquisitionEngine.get() }; }
+
+    /** Returns the capture file being replayed */
+    CaptureReplay& getReplay() { return *replay; }
+
+    /** Returns the part number used to create the probe metadata for a capture file */
+    static String getSimulatedPartNumber (const PacketCapture::FileHeader& header);
+
+private:
+    std::unique_ptr<CaptureReplay> replay;
+
+    std::unique_ptr<AcquisitionEngineBase> acquisitionEngine;
+};
+
+#endif // __REPLAYPROBE_H_2C4C2D67__
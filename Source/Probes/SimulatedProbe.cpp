@@ -28,9 +28,9 @@
 // Initialize static member
 int64 SimulatedProbe::globalTimerStart = Time::getMillisecondCounterHiRes();
 
-int SimulatedProbe::getGlobalEventCode()
+int SimulatedProbe::getGlobalEventCode (double millisecondCounter)
 {
-    double currentMsModS = fmod(Time::getMillisecondCounterHiRes() - globalTimerStart, 1000.0);
+    double currentMsModS = fmod (jmax (0.0, millisecondCounter - globalTimerStart), 1000.0);
     return (currentMsModS < 500) ? 1 : 0;
 }
 
@@ -824,6 +824,8 @@ void SimulatedProbe::startAcquisition()
 
     ap_timestamp = 0;
     lfp_timestamp = 0;
+    apTimestampConverter.reset();
+    lfpTimestampConverter.reset();
     apBuffer->clear();
 
     if (generatesLfpData())
@@ -836,7 +838,25 @@ void SimulatedProbe::startAcquisition()
 
     SKIP = sendSync ? 385 : 384;
 
-    startThread();
+    if (pollingSettings.readBatchSuperFrames > 0)
+        readBatchPackets = jmin (pollingSettings.readBatchSuperFrames, PollingScheduler::Settings::maxReadBatchSuperFrames);
+    else
+        readBatchPackets = 64;
+
+    apSamples.resize (385 * 12 * readBatchPackets);
+    lfpSamples.resize (385 * readBatchPackets);
+    ap_timestamps.resize (12 * readBatchPackets);
+    timestamp_s.resize (12 * readBatchPackets);
+    event_codes.resize (12 * readBatchPackets);
+    lfp_timestamps.resize (readBatchPackets);
+    lfp_timestamp_s.resize (readBatchPackets);
+    lfp_event_codes.resize (readBatchPackets);
+
+    events.reset (0);
+
+    prepareOffsets (384, 30000.0f, 2500.0f);
+
+    startAcquisitionThread();
 }
 
 void SimulatedProbe::stopAcquisition()
@@ -852,73 +872,132 @@ bool SimulatedProbe::runBist (BIST bistType)
 
 void SimulatedProbe::run()
 {
+    prepareToPoll();
 
     while (! threadShouldExit())
     {
-        int64 start = Time::getHighResolutionTicks();
+        poll();
+
+        scheduler.waitForNextRead (*this);
+    }
+
+    finishPolling();
+}
+
+void SimulatedProbe::prepareToPoll()
+{
+    // Packets "arrive" in a software FIFO at the NP1 rate, so the
+    // polling scheduler sees the same timing as with real hardware
+    scheduler.prepare (pollingSettings, 400.0, readBatchPackets);
+    fifo.start (400.0, 4096, Time::getHighResolutionTicks());
+    acquisitionStartMs = Time::getMillisecondCounterHiRes();
+}
+
+double SimulatedProbe::poll()
+{
+    const int64 readTicks = Time::getHighResolutionTicks();
+    const int count = fifo.read (readBatchPackets, readTicks);
+
+    scheduler.packetsRead (count, readBatchPackets, readTicks);
+
+    if (count > 0)
+    {
+        scheduler.startProcessing();
 
-        for (int packetNum = 0; packetNum < MAXPACKETS; packetNum++)
+        events.startBatch();
+
+        const float* apOffset = apOffsets.getOffsets().data();
+        const float* lfpOffset = lfpOffsets.getOffsets().data();
+
+        for (int packetNum = 0; packetNum < count; packetNum++)
         {
             for (int i = 0; i < 12; i++)
             {
                 for (int j = 0; j < 384; j++)
                 {
-                    apSamples[j * (12 * MAXPACKETS) + i + (packetNum * 12)] = (simulatedData.ap_band[ap_timestamp % 3000] + float (j * 2) - ap_offsets[j][0])
+                    apSamples[j * (12 * count) + i + (packetNum * 12)] = (simulatedData.ap_band[ap_timestamp % 3000] + float (j * 2) - apOffset[j])
                                                                               * (float ((ap_timestamp + j * 78) % 60000) / 60000.0f);
-                    // apView->addSample (apSamples[j * (12 * MAXPACKETS) + i + (packetNum * 12)], j);
+                    // apView->addSample (apSamples[j * (12 * count) + i + (packetNum * 12)], j);
 
                     if (i == 0)
                     {
-                        lfpSamples[(j * MAXPACKETS) + packetNum] = simulatedData.lfp_band[lfp_timestamp % 250] * float (j % 24) / 24.0f - lfp_offsets[j][0];
-                        // lfpView->addSample (lfpSamples[(j * MAXPACKETS) + packetNum], j);
+                        lfpSamples[(j * count) + packetNum] = simulatedData.lfp_band[lfp_timestamp % 250] * float (j % 24) / 24.0f - lfpOffset[j];
+                        // lfpView->addSample (lfpSamples[(j * count) + packetNum], j);
                     }
                 }
 
-                eventCode = getGlobalEventCode();
+                const uint16_t status = uint16_t (getGlobalEventCode (acquisitionStartMs + double (ap_timestamp - syncOffsetSamples) / 30.0)
+                                                  << EventTransitions::statusShift);
 
-                ap_timestamps[i + packetNum * 12] = ap_timestamp++;
+                if ((status ^ events.getLastStatus()) & EventTransitions::statusMask)
+                    events.add (i + packetNum * 12, ap_timestamp, status);
 
-                event_codes[i + packetNum * 12] = eventCode;
-
-                if (sendSync)
-                    apSamples[384 * (12 * MAXPACKETS) + i + (packetNum * 12)] = (float) eventCode;
+                // Simulated 100 kHz hardware timestamp, converted to seconds below
+                timestamp_s[i + packetNum * 12] = double (ap_timestamp) * 10.0 / 3.0;
+                ap_timestamps[i + packetNum * 12] = ap_timestamp++;
             }
 
+            lfp_timestamp_s[packetNum] = timestamp_s[packetNum * 12];
             lfp_timestamps[packetNum] = lfp_timestamp++;
-            lfp_event_codes[packetNum] = eventCode;
+        }
 
-            if (sendSync)
-                lfpSamples[(384 * MAXPACKETS) + packetNum] = (float) eventCode;
+        eventCode = events.getEventCode();
+
+        events.expand (event_codes.data(), 12 * count);
 
+        if (sendSync)
+            events.expand (apSamples.data() + 384 * (12 * count), 0, 12 * count);
 
+        for (int packetNum = 0; packetNum < count; packetNum++)
+        {
+            lfp_event_codes[packetNum] = event_codes[packetNum * 12 + 11];
+
+            if (sendSync)
+                lfpSamples[(384 * count) + packetNum] = (float) lfp_event_codes[packetNum];
         }
 
-        apBuffer->addToBuffer (apSamples, ap_timestamps, timestamp_s, event_codes, 12 * MAXPACKETS);
-        apView->addToBuffer (apSamples, 12 * MAXPACKETS);
+        const HardwareClock::Fit fit = basestation->clock.addObservation (int64 (double (ap_timestamp - 1) * 10.0 / 3.0), readTicks);
+
+        apTimestampConverter.convert (fit, timestamp_s.data(), 12 * count);
+        lfpTimestampConverter.convert (fit, lfp_timestamp_s.data(), count);
+
+        syncEdges.detect (events.getTransitions(), timestamp_s.data());
+
+        apBuffer->addToBuffer (apSamples.data(), ap_timestamps.data(), timestamp_s.data(), event_codes.data(), 12 * count);
+        apView->addToBuffer (apSamples.data(), 12 * count);
 
         if (generatesLfpData())
         {
-            lfpBuffer->addToBuffer (lfpSamples, lfp_timestamps, timestamp_s, lfp_event_codes, MAXPACKETS);
-            lfpView->addToBuffer (lfpSamples, MAXPACKETS);
+            lfpBuffer->addToBuffer (lfpSamples.data(), lfp_timestamps.data(), lfp_timestamp_s.data(), lfp_event_codes.data(), count);
+            lfpView->addToBuffer (lfpSamples.data(), count);
         }
 
-        if (ap_offsets[0][0] == 0)
-        {
-            updateOffsets (apSamples, ap_timestamp, true);
+        updateOffsets (apSamples.data(), 12 * count, ap_timestamps[0], true);
 
-            if (generatesLfpData())
-                updateOffsets (lfpSamples, lfp_timestamp, false);
-        }
+        if (generatesLfpData())
+            updateOffsets (lfpSamples.data(), count, lfp_timestamps[0], false);
 
-        fifoFillPercentage = 0;
+        scheduler.stopProcessing();
+    }
 
-        int64 uSecElapsed = int64 (Time::highResolutionTicksToSeconds (Time::getHighResolutionTicks() - start) * 1e6);
+    const int64 now = Time::getHighResolutionTicks();
 
-        if (uSecElapsed < 400 * MAXPACKETS)
-        {
-            std::this_thread::sleep_for (std::chrono::microseconds (400 * MAXPACKETS - uSecElapsed));
-        }
+    if (scheduler.shouldQueryFifo (now))
+    {
+        const int packetsAvailable = fifo.getPacketsAvailable (now);
+        const int headroom = fifo.getHeadroom (now);
+
+        fifoFillPercentage = float (packetsAvailable) / float (packetsAvailable + headroom);
+
+        scheduler.fifoStatusRead (packetsAvailable, headroom, now);
     }
+
+    return scheduler.getTimeUntilNextRead (Time::getHighResolutionTicks());
+}
+
+void SimulatedProbe::finishPolling()
+{
+    LOGC ("Simulated probe acquisition thread: ", scheduler.getSummary());
 }
 
 void SimulatedProbe::createElectrodeConfigurationsUHD()
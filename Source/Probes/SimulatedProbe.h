@@ -3293,7 +3293,8 @@ struct SimulatedData
     };
 };
 
-class SimulatedProbe : public Probe
+class SimulatedProbe : public Probe,
+                       public AcquisitionTask
 {
 public:
     /** Constructor */
@@ -3304,8 +3305,11 @@ public:
                     String partNumber,
                     int serialNumber);
 
-    /** Static method to get current event code (synchronized across all probes) */
-    static int getGlobalEventCode();
+    /** Static method to get the event code at a time (synchronized across all probes) */
+    static int getGlobalEventCode (double millisecondCounter = Time::getMillisecondCounterHiRes());
+
+    /** Delays this probe's simulated sync input by a number of samples, to test sync alignment */
+    void setSyncOffset (int samples) { syncOffsetSamples = samples; }
 
     /** Opens the connection to the probe */
     bool open() override;
@@ -3361,6 +3365,18 @@ public:
     /** Acquires data from the probe */
     void run() override;
 
+    /** Starts the simulated FIFO */
+    void prepareToPoll() override;
+
+    /** Generates the packets that have arrived since the last poll */
+    double poll() override;
+
+    /** Logs the scheduler summary */
+    void finishPolling() override;
+
+    /** Lets the basestation generate data on a shared worker thread */
+    Array<AcquisitionTask*> getAcquisitionTasks() override { return { this }; }
+
     /** Creates arrays of selected electrodes for each available config */
     void createElectrodeConfigurationsUHD();
 
@@ -3373,12 +3389,36 @@ public:
     /** Static timer for synchronized event codes across all SimulatedProbe instances */
     static int64 globalTimerStart;
 
-    float apSamples[385 * 12 * MAXPACKETS];
-    float lfpSamples[385 * MAXPACKETS];
-    int64 ap_timestamps[12 * MAXPACKETS];
-    uint64 event_codes[12 * MAXPACKETS];
-    int64 lfp_timestamps[MAXPACKETS];
-    uint64 lfp_event_codes[MAXPACKETS];
+    /** Time at which the simulated FIFO started, for the event code of each sample */
+    double acquisitionStartMs = 0.0;
+
+    /** Injected delay of the sync input */
+    std::atomic<int> syncOffsetSamples { 0 };
+
+    /** Models the hardware FIFO that packets are read from */
+    SimulatedFifo fifo;
+
+    /** Decides when to read from the FIFO */
+    PollingScheduler scheduler;
+
+    /** Packets per read, from pollingSettings.readBatchSuperFrames */
+    int readBatchPackets = 64;
+
+    std::vector<float> apSamples;
+    std::vector<float> lfpSamples;
+    std::vector<int64> ap_timestamps;
+    std::vector<double> timestamp_s;
+    std::vector<uint64> event_codes;
+    std::vector<int64> lfp_timestamps;
+    std::vector<double> lfp_timestamp_s;
+    std::vector<uint64> lfp_event_codes;
+
+    /** Keep the AP and LFP timestamps increasing across batches */
+    HardwareClock::StreamTimestamps apTimestampConverter;
+    HardwareClock::StreamTimestamps lfpTimestampConverter;
+
+    /** Changes of the simulated inputs in the current batch */
+    EventTransitions events;
 
     Array<String> availableElectrodeConfigurationsUHD;
 
@@ -0,0 +1,296 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#include "SyncAlignment.h"
+#include "../NeuropixThread.h"
+
+// How often new sync edges are matched
+#define MATCH_INTERVAL_MS 500
+
+// How often the alignment table is broadcast
+#define SYNC_TABLE_INTERVAL_MS 10000
+
+// Edges are only matched if they are closer (in host time) than this fraction of the sync period
+#define MATCH_WINDOW_PERIODS 0.45
+
+// Reference edges kept for matching
+#define REFERENCE_HISTORY_EDGES 64
+
+SyncEdges::SyncEdges()
+{
+}
+
+void SyncEdges::reset()
+{
+    fifo.reset();
+    numDropped = 0;
+}
+
+void SyncEdges::detect (const std::vector<EventTransitions::Transition>& transitions, const double* timestamps)
+{
+    for (const auto& transition : transitions)
+    {
+        // An input that is high at the start is not an edge
+        if (transition.bit != syncBit || ! transition.rising || transition.sampleNumber == 0)
+            continue;
+
+        const auto scope = fifo.write (1);
+
+        if (scope.blockSize1 > 0)
+            edges[scope.startIndex1] = { transition.sampleNumber, timestamps[transition.sampleIndex] };
+        else
+            numDropped++;
+    }
+}
+
+int SyncEdges::read (Edge* dest, int maxEdges)
+{
+    const auto scope = fifo.read (jmin (maxEdges, fifo.getNumReady()));
+
+    for (int i = 0; i < scope.blockSize1; i++)
+        dest[i] = edges[scope.startIndex1 + i];
+
+    for (int i = 0; i < scope.blockSize2; i++)
+        dest[scope.blockSize1 + i] = edges[scope.startIndex2 + i];
+
+    return scope.blockSize1 + scope.blockSize2;
+}
+
+SyncAligner::SyncAligner (NeuropixThread* neuropixThread_)
+    : Thread ("Sync aligner"),
+      neuropixThread (neuropixThread_)
+{
+}
+
+SyncAligner::~SyncAligner()
+{
+    stopThread (1000);
+}
+
+void SyncAligner::start (const Array<Probe*>& probes)
+{
+    stop();
+
+    {
+        const ScopedLock sl (streamsLock);
+
+        streams.clear();
+        referenceIndex = -1;
+
+        for (auto probe : probes)
+        {
+            if (! probe->isEnabled)
+                continue;
+
+            probe->syncEdges.reset();
+
+            Stream stream;
+            stream.probe = probe;
+            stream.samplesPerMs = probe->ap_sample_rate / 1000.0;
+            streams.push_back (stream);
+        }
+    }
+
+    lastTableTimeMs = Time::getMillisecondCounter();
+
+    startThread (Thread::Priority::low);
+}
+
+void SyncAligner::stop()
+{
+    if (isThreadRunning())
+    {
+        signalThreadShouldExit();
+        notify();
+        stopThread (1000);
+    }
+}
+
+void SyncAligner::run()
+{
+    while (! threadShouldExit())
+    {
+        wait (MATCH_INTERVAL_MS);
+
+        StringArray messages;
+
+        update (messages);
+
+        if (Time::getMillisecondCounter() - lastTableTimeMs >= SYNC_TABLE_INTERVAL_MS && referenceIndex >= 0)
+        {
+            lastTableTimeMs = Time::getMillisecondCounter();
+            messages.add ("NPX SYNC TABLE: " + getTableString());
+        }
+
+        for (const auto& msg : messages)
+            neuropixThread->sendBroadcastMessage (msg);
+    }
+}
+
+void SyncAligner::update (StringArray& messages)
+{
+    const ScopedLock sl (streamsLock);
+
+    SyncEdges::Edge buffer[SyncEdges::capacity];
+
+    for (int i = 0; i < (int) streams.size(); i++)
+    {
+        Stream& stream = streams[i];
+
+        const int numRead = stream.probe->syncEdges.read (buffer, SyncEdges::capacity);
+
+        stream.edges.insert (stream.edges.end(), buffer, buffer + numRead);
+
+        if (referenceIndex < 0 && numRead > 0)
+        {
+            referenceIndex = i;
+            LOGC ("Sync alignment reference: ", getStreamName (stream));
+        }
+    }
+
+    if (referenceIndex < 0)
+        return;
+
+    Stream& reference = streams[referenceIndex];
+
+    while (reference.edges.size() > REFERENCE_HISTORY_EDGES)
+        reference.edges.pop_front();
+
+    if (reference.edges.size() < 2)
+        return;
+
+    const double latestReference = reference.edges.back().timestamp;
+    const double matchWindow = MATCH_WINDOW_PERIODS * (latestReference - reference.edges[reference.edges.size() - 2].timestamp);
+
+    for (int i = 0; i < (int) streams.size(); i++)
+    {
+        if (i == referenceIndex)
+            continue;
+
+        Stream& stream = streams[i];
+
+        for (auto edge = stream.edges.begin(); edge != stream.edges.end();)
+        {
+            const SyncEdges::Edge* nearest = nullptr;
+
+            for (const auto& candidate : reference.edges)
+            {
+                if (nearest == nullptr || std::abs (candidate.timestamp - edge->timestamp) < std::abs (nearest->timestamp - edge->timestamp))
+                    nearest = &candidate;
+            }
+
+            if (std::abs (nearest->timestamp - edge->timestamp) <= matchWindow)
+            {
+                match (stream, *edge, *nearest, messages);
+                edge = stream.edges.erase (edge);
+            }
+            else if (edge->timestamp < latestReference - matchWindow)
+            {
+                // The reference has moved past this edge without seeing it
+                stream.numUnmatched++;
+                edge = stream.edges.erase (edge);
+            }
+            else
+            {
+                ++edge; // the reference edge may not have been read yet
+            }
+        }
+    }
+}
+
+void SyncAligner::match (Stream& stream, const SyncEdges::Edge& edge, const SyncEdges::Edge& reference, StringArray& messages)
+{
+    stream.regression.add (double (reference.sampleNumber), double (edge.sampleNumber));
+    stream.offsetSamples = edge.sampleNumber - reference.sampleNumber;
+
+    if (stream.numMatched++ == 0)
+        stream.initialOffsetSamples = stream.offsetSamples;
+
+    const int64 changeSamples = stream.offsetSamples - stream.initialOffsetSamples;
+    const double changeMs = double (changeSamples) / stream.samplesPerMs;
+    const bool misaligned = std::abs (changeMs) > thresholdMs;
+
+    if (misaligned == stream.misaligned)
+        return;
+
+    stream.misaligned = misaligned;
+
+    String msg = String (misaligned ? "NPX SYNC MISALIGNED: " : "NPX SYNC ALIGNED: ") + getStreamName (stream)
+                 + " has moved " + String (changeMs, 3) + " ms (" + String (changeSamples) + " samples) relative to "
+                 + getStreamName (streams[referenceIndex]) + " at sample number " + String (edge.sampleNumber);
+
+    LOGC (msg);
+
+    messages.add (msg);
+}
+
+String SyncAligner::getStreamName (const Stream& stream)
+{
+    String name = "slot " + String (stream.probe->basestation->slot) + ", probe " + String (stream.probe->headstage->port);
+
+    if (stream.probe->dock > 0)
+        name += ", dock " + String (stream.probe->dock);
+
+    return name;
+}
+
+String SyncAligner::getTableString()
+{
+    const ScopedLock sl (streamsLock);
+
+    Array<var> entries;
+
+    for (int i = 0; i < (int) streams.size(); i++)
+    {
+        const Stream& stream = streams[i];
+
+        DynamicObject::Ptr s = new DynamicObject();
+
+        s->setProperty (Identifier ("name"), stream.probe->displayName);
+        s->setProperty (Identifier ("slot"), stream.probe->basestation->slot);
+        s->setProperty (Identifier ("port"), stream.probe->headstage->port);
+        s->setProperty (Identifier ("dock"), stream.probe->dock);
+        s->setProperty (Identifier ("reference"), i == referenceIndex);
+        s->setProperty (Identifier ("offset_samples"), stream.offsetSamples);
+        s->setProperty (Identifier ("offset_ms"), double (stream.offsetSamples) / stream.samplesPerMs);
+        s->setProperty (Identifier ("offset_change_ms"), double (stream.offsetSamples - stream.initialOffsetSamples) / stream.samplesPerMs);
+        s->setProperty (Identifier ("drift_ppm"), (stream.regression.getSlope (1.0) - 1.0) * 1.0e6);
+        s->setProperty (Identifier ("matched_edges"), stream.numMatched);
+        s->setProperty (Identifier ("unmatched_edges"), stream.numUnmatched);
+        s->setProperty (Identifier ("dropped_edges"), stream.probe->syncEdges.getNumDropped());
+        s->setProperty (Identifier ("misaligned"), stream.misaligned);
+
+        entries.add (s.get());
+    }
+
+    DynamicObject output;
+
+    output.setProperty (Identifier ("threshold_ms"), thresholdMs.load());
+    output.setProperty (Identifier ("streams"), entries);
+
+    MemoryOutputStream f;
+    output.writeAsJSON (f, JSON::FormatOptions {}.withIndentLevel (0).withSpacing (JSON::Spacing::singleLine).withMaxDecimalPlaces (4));
+
+    return f.toString();
+}
@@ -0,0 +1,179 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+
+#ifndef __SYNCALIGNMENT_H_2C4C2D67__
+#define __SYNCALIGNMENT_H_2C4C2D67__
+
+#include <DataThreadHeaders.h>
+
+#include "EventTransitions.h"
+#include "LinearRegression.h"
+
+#include <atomic>
+#include <deque>
+#include <vector>
+
+class NeuropixThread;
+class Probe;
+
+/**
+
+	Rising edges of the sync input seen in one probe's inputs.
+
+	The probe's primary acquisition thread (the one that reports the FIFO
+	fill, so shank 0 for Quad Base probes) passes the input changes of
+	each batch to detect() and queues the edges; SyncAligner reads them
+	on its own thread.
+
+*/
+class SyncEdges
+{
+public:
+    /** One rising edge of the sync input */
+    struct Edge
+    {
+        int64 sampleNumber = 0; // AP sample number of the first high sample
+        double timestamp = 0.0; // host seconds since the start of acquisition
+    };
+
+    /** Event code bit that carries the sync input (ELECTRODEPACKET_STATUS_SYNC >> 6) */
+    static constexpr uint8 syncBit = 0;
+
+    /** Edges that can be queued before new edges are dropped */
+    static constexpr int capacity = 256;
+
+    /** Constructor */
+    SyncEdges();
+
+    /** Clears the queue (call while no acquisition thread is running) */
+    void reset();
+
+    /** Queues the rising edges among a batch's input changes; timestamps are indexed by
+        Transition::sampleIndex (acquisition thread) */
+    void detect (const std::vector<EventTransitions::Transition>& transitions, const double* timestamps);
+
+    /** Moves up to maxEdges queued edges into dest; returns the number read (SyncAligner thread) */
+    int read (Edge* dest, int maxEdges);
+
+    /** Returns the number of edges dropped because the queue was full */
+    int64 getNumDropped() const { return numDropped; }
+
+private:
+    AbstractFifo fifo { capacity };
+    Edge edges[capacity];
+
+    std::atomic<int64> numDropped { 0 };
+};
+
+/**
+
+	Low-priority thread that matches sync edges across probes and slots.
+
+	The first probe that sees a sync edge becomes the reference. Every
+	other probe's edges are matched to the reference edge with the
+	nearest host timestamp (see HardwareClock), if it is within 0.45
+	sync periods, giving the offset between the two streams' sample
+	numbers at each edge; a fit of one stream's sample numbers against
+	the other's gives their relative drift.
+
+	Streams start at different sample numbers, so the offset at the first
+	matched edge is taken as the stream's alignment. An offset that moves
+	further than the threshold from it (a jump, or accumulated drift) is
+	logged and broadcast ("NPX SYNC MISALIGNED"), as is the recovery; the
+	whole table is broadcast every SYNC_TABLE_INTERVAL_MS and returned by
+	"NP SYNC".
+
+*/
+class SyncAligner : public Thread
+{
+public:
+    /** Constructor */
+    SyncAligner (NeuropixThread* neuropixThread);
+
+    /** Destructor */
+    ~SyncAligner();
+
+    /** Clears the enabled probes' edge queues and starts matching their edges */
+    void start (const Array<Probe*>& probes);
+
+    /** Stops the thread */
+    void stop();
+
+    /** Matches new edges every MATCH_INTERVAL_MS */
+    void run() override;
+
+    /** Sets the change in offset beyond which a stream is reported as misaligned */
+    void setThresholdMs (double thresholdMs_) { thresholdMs = thresholdMs_; }
+
+    /** Returns the change in offset beyond which a stream is reported as misaligned */
+    double getThresholdMs() const { return thresholdMs; }
+
+    /** Returns the offset and drift of every stream relative to the reference, as JSON */
+    String getTableString();
+
+private:
+    /** Alignment state of one probe's stream */
+    struct Stream
+    {
+        Probe* probe = nullptr;
+
+        /** Edges not matched yet (or, for the reference, recent edges) */
+        std::deque<SyncEdges::Edge> edges;
+
+        /** x = reference sample number, y = this stream's sample number at the same edge */
+        LinearRegression regression;
+
+        /** AP samples per millisecond */
+        double samplesPerMs = 30.0;
+
+        /** Offset at the first matched edge, and at the latest one */
+        int64 initialOffsetSamples = 0;
+        int64 offsetSamples = 0;
+
+        int64 numMatched = 0;
+        int64 numUnmatched = 0;
+        bool misaligned = false;
+    };
+
+    /** Reads new edges, matches them and collects the messages to send */
+    void update (StringArray& messages);
+
+    /** Updates a stream with an edge matched to a reference edge */
+    void match (Stream& stream, const SyncEdges::Edge& edge, const SyncEdges::Edge& reference, StringArray& messages);
+
+    /** Returns "slot S, probe P" (and the dock, if there is one) */
+    static String getStreamName (const Stream& stream);
+
+    NeuropixThread* neuropixThread;
+
+    CriticalSection streamsLock;
+    std::vector<Stream> streams;
+    int referenceIndex = -1;
+
+    std::atomic<double> thresholdMs { 1.0 };
+
+    uint32 lastTableTimeMs = 0;
+};
+
+#endif // __SYNCALIGNMENT_H_2C4C2D67__
@@ -24,12 +24,78 @@
 #include "ActivityView.h"
 
 #include <algorithm>
+#include <cmath>
+
+// Samples reduced per pass in ENVELOPE mode, so that the copy being filtered stays in cache
+#define ENVELOPE_SLICE_SAMPLES 128
+
+// Update intervals queued per block in ENVELOPE mode
+#define ENVELOPE_QUEUE_LENGTH 4
+
+// Lowest sample rate at which threshold crossings are counted
+#define MIN_SPIKE_SAMPLE_RATE 10000.0f
+
+// Weight of each update interval in the displayed spike rates (about 1 s time constant)
+#define SPIKE_RATE_SMOOTHING 0.1f
+
+// Update intervals in the displayed noise levels (1 s)
+#define NOISE_WINDOW_INTERVALS 10
+
+// How often the analysis thread processes the buffered samples
+#define ANALYSIS_INTERVAL_MS 100
+
+// Views whose results have not been read for this long are skipped (unless surveying)
+#define IDLE_TIMEOUT_MS 1000
 
 /**
 
-Helper class for viewing real-time activity across the probe.
+	Background thread shared by all activity views.
 
 */
+class ActivityView::Analyzer : public Thread
+{
+public:
+    Analyzer() : Thread ("Activity analysis")
+    {
+        startThread();
+    }
+
+    ~Analyzer()
+    {
+        stopThread (1000);
+    }
+
+    void addView (ActivityView* view)
+    {
+        const ScopedLock lock (viewsLock);
+        views.addIfNotAlreadyThere (view);
+    }
+
+    void removeView (ActivityView* view)
+    {
+        const ScopedLock lock (viewsLock);
+        views.removeFirstMatchingValue (view);
+    }
+
+    void run() override
+    {
+        while (! threadShouldExit())
+        {
+            {
+                const ScopedLock lock (viewsLock);
+
+                for (auto view : views)
+                    view->analyze();
+            }
+
+            wait (ANALYSIS_INTERVAL_MS);
+        }
+    }
+
+private:
+    CriticalSection viewsLock;
+    Array<ActivityView*> views;
+};
 
 ActivityView::ActivityView (int numChannels_,
                             int updateInterval_,
@@ -60,7 +126,15 @@ ActivityView::ActivityView (int numChannels_,
         blocks = blocks_;
     }
 
+    sampleRate = updateInterval * 10.0f;
+    detectsSpikes = sampleRate >= MIN_SPIKE_SAMPLE_RATE;
+
     peakToPeakValues.assign (totalElectrodes, -1.0f);
+    spikeRates.assign (totalElectrodes, -1.0f);
+    noiseLevels.assign (totalElectrodes, -1.0f);
+    noiseWindows.assign ((size_t) totalElectrodes * NOISE_WINDOW_INTERVALS, 0.0f);
+    noiseIntervals.assign (totalElectrodes, 0);
+    noiseScratch.resize (NOISE_WINDOW_INTERVALS);
     channelToElectrode.resize (numChannels, -1);
     for (int i = 0; i < numChannels; ++i)
     {
@@ -70,46 +144,60 @@ ActivityView::ActivityView (int numChannels_,
 
     surveyAccumulation.assign (totalElectrodes, 0.0);
     surveySampleCount.assign (totalElectrodes, 0);
+    surveyNoiseAccumulation.assign (totalElectrodes, 0.0);
+    surveyNoiseCount.assign (totalElectrodes, 0);
 
-    // Initialize the sample buffers and FIFOs for each block
-    sampleBuffers.resize (blocks.size());
-    filteredBuffers.resize (blocks.size());
-    abstractFifos.resize (blocks.size());
+    allocateSampleBuffers (ingestion == FULL_RATE);
 
-    int bufferSize = updateInterval * 2; // Buffer size to hold 2x the update interval
+    // Initialize the envelope state for each block
+    envelopes.resize (blocks.size());
 
     for (int blockIndex = 0; blockIndex < blocks.size(); ++blockIndex)
     {
-        int blockSize = blocks[blockIndex].size();
-        sampleBuffers[blockIndex].setSize (blockSize, bufferSize);
-        sampleBuffers[blockIndex].clear();
-
-        filteredBuffers[blockIndex].setSize (blockSize, bufferSize);
-        filteredBuffers[blockIndex].clear();
-
-        abstractFifos[blockIndex] = std::make_unique<AbstractFifo> (bufferSize);
+        const int blockSize = (int) blocks[blockIndex].size();
+        Envelope& envelope = envelopes[blockIndex];
+
+        envelope.scratch.setSize (blockSize, ENVELOPE_SLICE_SAMPLES);
+        envelope.sliceMin.resize (blockSize);
+        envelope.sliceMax.resize (blockSize);
+        envelope.sliceSum.resize (blockSize);
+        envelope.sliceSumSquares.resize (blockSize);
+        envelope.runningMin.assign (blockSize, std::numeric_limits<float>::infinity());
+        envelope.runningMax.assign (blockSize, -std::numeric_limits<float>::infinity());
+        envelope.statistics.resize (blockSize);
+        envelope.crossings.assign (blockSize, 0);
+        envelope.summaries.resize ((size_t) ENVELOPE_QUEUE_LENGTH * 4 * blockSize);
+        envelope.fifo = std::make_unique<AbstractFifo> (ENVELOPE_QUEUE_LENGTH);
     }
 
     counters.resize (blocks.size(), 0);
 
-    filters.clear();
+    filterBanks.resize (blocks.size());
+    filterResetPending = std::make_unique<std::atomic<bool>[]> (blocks.size());
+    spikeDetectors.resize (blocks.size());
+
+    size_t maxBlockSize = 0;
 
-    for (int n = 0; n < numChannels; ++n)
+    for (int blockIndex = 0; blockIndex < blocks.size(); ++blockIndex)
     {
-        filters.add (new Dsp::SmoothedFilterDesign<Dsp::Butterworth::Design::BandPass // design type
-                                                   <2>, // order
-                                                   1, // number of channels (must be const)
-                                                   Dsp::DirectFormII> (1)); // realization
+        filterBanks[blockIndex].setBandPass ((int) blocks[blockIndex].size(),
+                                             sampleRate, // sample rate
+                                             (highCut + lowCut) / 2, // center frequency
+                                             highCut - lowCut); // bandwidth
 
-        Dsp::Params params;
-        params[0] = updateInterval * 10.0f; // sample rate
-        params[1] = 2; // order
-        params[2] = (highCut + lowCut) / 2; // center frequency
-        params[3] = highCut - lowCut; // bandwidth
+        spikeDetectors[blockIndex].prepare ((int) blocks[blockIndex].size(), sampleRate);
 
-        filters.getLast()->setParams (params);
+        maxBlockSize = jmax (maxBlockSize, blocks[blockIndex].size());
     }
 
+    channelMin.resize (maxBlockSize);
+    channelMax.resize (maxBlockSize);
+    channelRate.resize (maxBlockSize);
+    channelNoise.resize (maxBlockSize);
+    channelCrossings.resize (maxBlockSize);
+    channelSum.resize (maxBlockSize);
+    channelSumSquares.resize (maxBlockSize);
+
     // Initialize ADC grouping for CAR
     if (numAdcs == 32) // Neuropixels 1.0
     {
@@ -158,12 +246,152 @@ ActivityView::ActivityView (int numChannels_,
             adcBuffers[blockIndex].clear();
         }
     }
+
+    for (auto& snapshot : snapshots)
+    {
+        snapshot = peakToPeakValues;
+        snapshot.insert (snapshot.end(), spikeRates.begin(), spikeRates.end());
+        snapshot.insert (snapshot.end(), noiseLevels.begin(), noiseLevels.end());
+    }
+
+    analyzer = std::make_unique<SharedResourcePointer<Analyzer>>();
+    (*analyzer)->addView (this);
+}
+
+ActivityView::~ActivityView()
+{
+    // Waits for an analysis pass over this view to finish
+    (*analyzer)->removeView (this);
+    analyzer.reset();
+}
+
+String ActivityView::getIngestionName (Ingestion ingestion)
+{
+    return ingestion == FULL_RATE ? "FULL" : "ENVELOPE";
+}
+
+bool ActivityView::parseIngestion (const String& name, Ingestion& ingestion)
+{
+    for (Ingestion i : { FULL_RATE, ENVELOPE })
+    {
+        if (name.equalsIgnoreCase (getIngestionName (i)))
+        {
+            ingestion = i;
+            return true;
+        }
+    }
+
+    return false;
+}
+
+void ActivityView::setIngestion (Ingestion ingestion_)
+{
+    const ScopedLock lock (bufferMutex);
+
+    if (ingestion_ == ingestion)
+        return;
+
+    ingestion = ingestion_;
+
+    allocateSampleBuffers (ingestion == FULL_RATE);
+
+    for (int blockIndex = 0; blockIndex < blocks.size(); ++blockIndex)
+        reset (blockIndex);
+}
+
+void ActivityView::allocateSampleBuffers (bool fullRate)
+{
+    const size_t numBlocks = fullRate ? blocks.size() : 0;
+
+    sampleBuffers.resize (numBlocks);
+    filteredBuffers.resize (numBlocks);
+    abstractFifos.resize (numBlocks);
+
+    int bufferSize = updateInterval * 2; // Buffer size to hold 2x the update interval
+
+    for (int blockIndex = 0; blockIndex < numBlocks; ++blockIndex)
+    {
+        int blockSize = blocks[blockIndex].size();
+        sampleBuffers[blockIndex].setSize (blockSize, bufferSize);
+        sampleBuffers[blockIndex].clear();
+
+        filteredBuffers[blockIndex].setSize (blockSize, bufferSize);
+        filteredBuffers[blockIndex].clear();
+
+        abstractFifos[blockIndex] = std::make_unique<AbstractFifo> (bufferSize);
+    }
+}
+
+const std::vector<float>& ActivityView::getLatestSnapshot()
+{
+    lastReadTime = Time::getMillisecondCounter();
+
+    if (middleSnapshot.load() & newSnapshotFlag)
+        frontSnapshot = middleSnapshot.exchange (frontSnapshot) & ~newSnapshotFlag;
+
+    return snapshots[frontSnapshot];
 }
 
 const float* ActivityView::getPeakToPeakValues()
 {
-    calculatePeakToPeakValues();
-    return peakToPeakValues.data();
+    return getLatestSnapshot().data();
+}
+
+const float* ActivityView::getSpikeRates()
+{
+    return getLatestSnapshot().data() + totalElectrodes;
+}
+
+const float* ActivityView::getNoiseLevels()
+{
+    return getLatestSnapshot().data() + 2 * totalElectrodes;
+}
+
+void ActivityView::setRobustNoiseEnabled (bool enabled)
+{
+    const ScopedLock lock (bufferMutex);
+    robustNoise = enabled;
+}
+
+bool ActivityView::isActive() const
+{
+    return surveyMode || Time::getMillisecondCounter() - lastReadTime.load() <= IDLE_TIMEOUT_MS;
+}
+
+void ActivityView::analyze()
+{
+    const ScopedLock lock (bufferMutex);
+
+    if (! isActive())
+    {
+        // Discard samples queued while nobody reads the results, and restart the filters when reading resumes
+        for (int blockIndex = 0; blockIndex < abstractFifos.size(); ++blockIndex)
+        {
+            if (abstractFifos[blockIndex]->getNumReady() > 0)
+            {
+                abstractFifos[blockIndex]->finishedRead (abstractFifos[blockIndex]->getNumReady());
+                filterResetPending[blockIndex] = true;
+            }
+        }
+
+        return;
+    }
+
+    if (ingestion == ENVELOPE)
+        readEnvelopes();
+    else
+        calculatePeakToPeakValues();
+
+    publishPeakToPeakValues();
+}
+
+void ActivityView::publishPeakToPeakValues()
+{
+    std::copy (peakToPeakValues.begin(), peakToPeakValues.end(), snapshots[backSnapshot].begin());
+    std::copy (spikeRates.begin(), spikeRates.end(), snapshots[backSnapshot].begin() + totalElectrodes);
+    std::copy (noiseLevels.begin(), noiseLevels.end(), snapshots[backSnapshot].begin() + 2 * totalElectrodes);
+
+    backSnapshot = middleSnapshot.exchange (backSnapshot | newSnapshotFlag) & ~newSnapshotFlag;
 }
 
 void ActivityView::setBandpassFilterEnabled (bool enabled)
@@ -180,6 +408,14 @@ void ActivityView::setCommonAverageReferencingEnabled (bool enabled)
 
 void ActivityView::addToBuffer (float* samples, int numSamples, int blockIndex)
 {
+    if (ingestion == ENVELOPE)
+    {
+        if (blockIndex < envelopes.size())
+            addToEnvelope (samples, numSamples, blockIndex);
+
+        return;
+    }
+
     if (blockIndex >= abstractFifos.size())
         return;
 
@@ -209,6 +445,159 @@ void ActivityView::addToBuffer (float* samples, int numSamples, int blockIndex)
     abstractFifos[blockIndex]->finishedWrite (numWritten);
 }
 
+void ActivityView::addToEnvelope (const float* samples, int numSamples, int blockIndex)
+{
+    Envelope& envelope = envelopes[blockIndex];
+
+    const int blockSize = (int) blocks[blockIndex].size();
+    const bool filter = filterEnabled;
+    const bool car = carEnabled;
+
+    // Skip the reduction while nobody reads the results
+    if (! isActive())
+    {
+        envelope.idle = true;
+        return;
+    }
+
+    // Restart the interval and the filters after an idle period, rather than joining up samples from before it
+    if (envelope.idle)
+    {
+        envelope.clearInterval();
+
+        filterResetPending[blockIndex] = true;
+        envelope.idle = false;
+    }
+
+    if (filterResetPending[blockIndex].exchange (false))
+    {
+        filterBanks[blockIndex].reset();
+        spikeDetectors[blockIndex].reset();
+    }
+
+    for (int offset = 0; offset < numSamples;)
+    {
+        const int count = jmin (numSamples - offset, ENVELOPE_SLICE_SAMPLES, updateInterval - envelope.numSamples);
+
+        if (filter || car)
+        {
+            for (int chanIdx = 0; chanIdx < blockSize; ++chanIdx)
+                envelope.scratch.copyFrom (chanIdx, 0, samples + (size_t) chanIdx * numSamples + offset, count);
+
+            if (car)
+                applyCommonAverageReferencing (envelope.scratch, blockIndex, count);
+        }
+
+        if (filter)
+        {
+            filterBanks[blockIndex].process (envelope.scratch.getArrayOfWritePointers(),
+                                             count,
+                                             envelope.sliceMin.data(),
+                                             envelope.sliceMax.data(),
+                                             envelope.sliceSum.data(),
+                                             envelope.sliceSumSquares.data());
+
+            for (int chanIdx = 0; chanIdx < blockSize; ++chanIdx)
+                envelope.statistics[chanIdx].add (count, envelope.sliceSum[chanIdx], envelope.sliceSumSquares[chanIdx]);
+
+            if (detectsSpikes)
+            {
+                spikeDetectors[blockIndex].process (envelope.scratch.getArrayOfReadPointers(), count, envelope.crossings.data());
+                envelope.numFilteredSamples += count;
+            }
+        }
+        else
+        {
+            for (int chanIdx = 0; chanIdx < blockSize; ++chanIdx)
+            {
+                const float* channelData = car ? envelope.scratch.getReadPointer (chanIdx)
+                                               : samples + (size_t) chanIdx * numSamples + offset;
+
+                Range<float> minMax = FloatVectorOperations::findMinAndMax (channelData, count);
+                envelope.sliceMin[chanIdx] = minMax.getStart();
+                envelope.sliceMax[chanIdx] = minMax.getEnd();
+            }
+        }
+
+        for (int chanIdx = 0; chanIdx < blockSize; ++chanIdx)
+        {
+            envelope.runningMin[chanIdx] = jmin (envelope.runningMin[chanIdx], envelope.sliceMin[chanIdx]);
+            envelope.runningMax[chanIdx] = jmax (envelope.runningMax[chanIdx], envelope.sliceMax[chanIdx]);
+        }
+
+        offset += count;
+        envelope.numSamples += count;
+
+        if (envelope.numSamples < updateInterval)
+            continue;
+
+        // Queue the range, spike rate and noise of the completed interval (dropped if the analysis thread is behind)
+        int startIndex1, blockSize1, startIndex2, blockSize2;
+        envelope.fifo->prepareToWrite (1, startIndex1, blockSize1, startIndex2, blockSize2);
+
+        if (blockSize1 > 0)
+        {
+            float* summary = envelope.summaries.data() + (size_t) startIndex1 * 4 * blockSize;
+
+            std::copy (envelope.runningMin.begin(), envelope.runningMin.end(), summary);
+            std::copy (envelope.runningMax.begin(), envelope.runningMax.end(), summary + blockSize);
+
+            for (int chanIdx = 0; chanIdx < blockSize; ++chanIdx)
+            {
+                summary[2 * blockSize + chanIdx] = envelope.numFilteredSamples > 0
+                                                       ? float (envelope.crossings[chanIdx]) * sampleRate / float (envelope.numFilteredSamples)
+                                                       : -1.0f;
+
+                const RunningStatistics& statistics = envelope.statistics[chanIdx];
+
+                summary[3 * blockSize + chanIdx] = statistics.getCount() > 0.0 ? (float) statistics.getStandardDeviation() : -1.0f;
+            }
+        }
+
+        envelope.fifo->finishedWrite (blockSize1);
+        envelope.clearInterval();
+    }
+}
+
+void ActivityView::Envelope::clearInterval()
+{
+    std::fill (runningMin.begin(), runningMin.end(), std::numeric_limits<float>::infinity());
+    std::fill (runningMax.begin(), runningMax.end(), -std::numeric_limits<float>::infinity());
+    std::fill (crossings.begin(), crossings.end(), 0);
+    numSamples = 0;
+    numFilteredSamples = 0;
+
+    for (auto& channelStatistics : statistics)
+        channelStatistics.reset();
+}
+
+void ActivityView::readEnvelopes()
+{
+    for (int blockIndex = 0; blockIndex < envelopes.size(); ++blockIndex)
+    {
+        Envelope& envelope = envelopes[blockIndex];
+
+        const int blockSize = (int) blocks[blockIndex].size();
+
+        for (int numReady = envelope.fifo->getNumReady(); numReady > 0; --numReady)
+        {
+            int startIndex1, blockSize1, startIndex2, blockSize2;
+            envelope.fifo->prepareToRead (1, startIndex1, blockSize1, startIndex2, blockSize2);
+
+            const float* summary = envelope.summaries.data() + (size_t) startIndex1 * 4 * blockSize;
+
+            std::copy (summary, summary + blockSize, channelMin.begin());
+            std::copy (summary + blockSize, summary + 2 * blockSize, channelMax.begin());
+            std::copy (summary + 2 * blockSize, summary + 3 * blockSize, channelRate.begin());
+            std::copy (summary + 3 * blockSize, summary + 4 * blockSize, channelNoise.begin());
+
+            envelope.fifo->finishedRead (1);
+
+            updatePeakToPeakValues (blockIndex);
+        }
+    }
+}
+
 void ActivityView::reset (int blockIndex)
 {
     const ScopedLock lock (bufferMutex);
@@ -226,16 +615,30 @@ void ActivityView::reset (int blockIndex)
                 continue;
 
             peakToPeakValues[(size_t) electrodeIdx] = -1.0f;
+            spikeRates[(size_t) electrodeIdx] = -1.0f;
+            noiseLevels[(size_t) electrodeIdx] = -1.0f;
+            noiseIntervals[(size_t) electrodeIdx] = 0;
         }
 
         counters[blockIndex] = 0;
-        sampleBuffers[blockIndex].clear();
-        filteredBuffers[blockIndex].clear();
-        abstractFifos[blockIndex]->reset();
+
+        if (blockIndex < abstractFifos.size())
+        {
+            sampleBuffers[blockIndex].clear();
+            filteredBuffers[blockIndex].clear();
+            abstractFifos[blockIndex]->reset();
+        }
+
+        envelopes[blockIndex].clearInterval();
+        envelopes[blockIndex].fifo->reset();
+
+        filterResetPending[blockIndex] = true;
     }
 
     bufferIndex = 0;
     needsUpdate = false;
+
+    publishPeakToPeakValues();
 }
 
 void ActivityView::setChannelToElectrodeMapping (const std::vector<int>& mapping)
@@ -247,9 +650,9 @@ void ActivityView::setChannelToElectrodeMapping (const std::vector<int>& mapping
 
     channelToElectrode = mapping;
 
-    // Reset filters after changing mapping
-    for (auto& filter : filters)
-        filter->reset();
+    // Reset filters after changing mapping (by the thread that filters each block)
+    for (int blockIndex = 0; blockIndex < blocks.size(); ++blockIndex)
+        filterResetPending[blockIndex] = true;
 }
 
 void ActivityView::setSurveyMode (bool enabled, bool reset)
@@ -257,9 +660,12 @@ void ActivityView::setSurveyMode (bool enabled, bool reset)
     const ScopedLock lock (bufferMutex);
     surveyMode = enabled;
 
-    // Reset abstract FIFOs
+    // Discard queued samples and ranges
     for (auto& fifo : abstractFifos)
-        fifo->reset();
+        fifo->finishedRead (fifo->getNumReady());
+
+    for (auto& envelope : envelopes)
+        envelope.fifo->finishedRead (envelope.fifo->getNumReady());
 
     if (reset)
         resetSurveyData();
@@ -267,9 +673,15 @@ void ActivityView::setSurveyMode (bool enabled, bool reset)
 
 void ActivityView::resetSurveyData()
 {
+    const ScopedLock lock (bufferMutex);
+
     std::fill (surveyAccumulation.begin(), surveyAccumulation.end(), 0.0);
     std::fill (surveySampleCount.begin(), surveySampleCount.end(), 0);
+    std::fill (surveyNoiseAccumulation.begin(), surveyNoiseAccumulation.end(), 0.0);
+    std::fill (surveyNoiseCount.begin(), surveyNoiseCount.end(), 0);
     std::fill (peakToPeakValues.begin(), peakToPeakValues.end(), -1.0f);
+
+    publishPeakToPeakValues();
 }
 
 ActivityView::SurveyStatistics ActivityView::getSurveyStatistics()
@@ -287,13 +699,20 @@ ActivityView::SurveyStatistics ActivityView::getSurveyStatistics()
         stats.averages[i] = count > 0 ? static_cast<float> (stats.totals[i] / static_cast<double> (count)) : 0.0f;
     }
 
+    // Pooled RMS noise of the surveyed intervals
+    stats.noise.resize (surveyNoiseAccumulation.size(), 0.0f);
+
+    for (size_t i = 0; i < stats.noise.size(); ++i)
+    {
+        if (surveyNoiseCount[i] > 0)
+            stats.noise[i] = static_cast<float> (std::sqrt (surveyNoiseAccumulation[i] / static_cast<double> (surveyNoiseCount[i])));
+    }
+
     return stats;
 }
 
 void ActivityView::calculatePeakToPeakValues()
 {
-    const ScopedLock lock (bufferMutex);
-
     for (int blockIndex = 0; blockIndex < blocks.size(); ++blockIndex)
     {
         int numReady = abstractFifos[blockIndex]->getNumReady();
@@ -341,47 +760,146 @@ void ActivityView::calculatePeakToPeakValues()
             applyCommonAverageReferencing (filteredBuffers[blockIndex], blockIndex, numItems);
         }
 
-        for (int chanIdx = 0; chanIdx < blocks[blockIndex].size(); ++chanIdx)
+        // Apply bandpass filter if enabled, finding the range and noise of each channel in the same pass
+        if (filterEnabled)
         {
-            int globalChan = blocks[blockIndex][chanIdx];
+            if (filterResetPending[blockIndex].exchange (false))
+            {
+                filterBanks[blockIndex].reset();
+                spikeDetectors[blockIndex].reset();
+            }
 
-            if (! isPositiveAndBelow (globalChan, numChannels))
-                continue;
+            filterBanks[blockIndex].process (filteredBuffers[blockIndex].getArrayOfWritePointers(),
+                                             numItems,
+                                             channelMin.data(),
+                                             channelMax.data(),
+                                             channelSum.data(),
+                                             channelSumSquares.data());
 
-            // Apply bandpass filter if enabled
-            if (filterEnabled && isPositiveAndBelow (globalChan, filters.size()))
+            for (int chanIdx = 0; chanIdx < blocks[blockIndex].size(); ++chanIdx)
             {
-                float* channelData = filteredBuffers[blockIndex].getWritePointer (chanIdx);
-
-                filters[globalChan]->process (numItems, &channelData);
+                RunningStatistics statistics;
+                statistics.add (numItems, channelSum[chanIdx], channelSumSquares[chanIdx]);
+                channelNoise[chanIdx] = (float) statistics.getStandardDeviation();
+            }
+        }
+        else
+        {
+            for (int chanIdx = 0; chanIdx < blocks[blockIndex].size(); ++chanIdx)
+            {
+                Range<float> minMax = filteredBuffers[blockIndex].findMinMax (chanIdx, 0, numItems);
+                channelMin[chanIdx] = minMax.getStart();
+                channelMax[chanIdx] = minMax.getEnd();
             }
 
-            Range<float> minMax = filteredBuffers[blockIndex].findMinMax (chanIdx, 0, numItems);
-            const float amplitude = minMax.getEnd() - minMax.getStart();
+            std::fill (channelNoise.begin(), channelNoise.end(), -1.0f);
+        }
 
-            int electrodeIdx = -1;
-            if (isPositiveAndBelow (globalChan, (int) channelToElectrode.size()))
-                electrodeIdx = channelToElectrode[(size_t) globalChan];
+        if (filterEnabled && detectsSpikes)
+        {
+            std::fill (channelCrossings.begin(), channelCrossings.end(), 0);
 
-            if (! isPositiveAndBelow (electrodeIdx, (int) peakToPeakValues.size()))
-                continue;
+            spikeDetectors[blockIndex].process (filteredBuffers[blockIndex].getArrayOfReadPointers(), numItems, channelCrossings.data());
 
-            if (surveyMode && isPositiveAndBelow (electrodeIdx, (int) surveyAccumulation.size()))
-            {
-                surveyAccumulation[(size_t) electrodeIdx] += amplitude;
-                surveySampleCount[(size_t) electrodeIdx] += 1;
+            for (int chanIdx = 0; chanIdx < blocks[blockIndex].size(); ++chanIdx)
+                channelRate[chanIdx] = float (channelCrossings[chanIdx]) * sampleRate / float (numItems);
+        }
+        else
+        {
+            std::fill (channelRate.begin(), channelRate.end(), -1.0f);
+        }
 
-                const double count = static_cast<double> (surveySampleCount[(size_t) electrodeIdx]);
-                peakToPeakValues[(size_t) electrodeIdx] = count > 0.0 ? (float) (surveyAccumulation[(size_t) electrodeIdx] / count) : amplitude;
-            }
-            else
-            {
-                peakToPeakValues[(size_t) electrodeIdx] = amplitude;
-            }
+        updatePeakToPeakValues (blockIndex);
+    }
+}
+
+void ActivityView::updatePeakToPeakValues (int blockIndex)
+{
+    for (int chanIdx = 0; chanIdx < blocks[blockIndex].size(); ++chanIdx)
+    {
+        int globalChan = blocks[blockIndex][chanIdx];
+
+        if (! isPositiveAndBelow (globalChan, numChannels))
+            continue;
+
+        const float amplitude = channelMax[chanIdx] - channelMin[chanIdx];
+
+        int electrodeIdx = -1;
+        if (isPositiveAndBelow (globalChan, (int) channelToElectrode.size()))
+            electrodeIdx = channelToElectrode[(size_t) globalChan];
+
+        if (! isPositiveAndBelow (electrodeIdx, (int) peakToPeakValues.size()))
+            continue;
+
+        const float rate = channelRate[chanIdx];
+        float& displayedRate = spikeRates[(size_t) electrodeIdx];
+
+        if (rate < 0.0f || displayedRate < 0.0f)
+            displayedRate = rate;
+        else
+            displayedRate += SPIKE_RATE_SMOOTHING * (rate - displayedRate);
+
+        const float rms = channelNoise[chanIdx];
+
+        updateNoiseLevel (electrodeIdx, rms);
+
+        if (surveyMode && rms >= 0.0f)
+        {
+            surveyNoiseAccumulation[(size_t) electrodeIdx] += (double) rms * rms;
+            surveyNoiseCount[(size_t) electrodeIdx] += 1;
+        }
+
+        if (surveyMode && isPositiveAndBelow (electrodeIdx, (int) surveyAccumulation.size()))
+        {
+            surveyAccumulation[(size_t) electrodeIdx] += amplitude;
+            surveySampleCount[(size_t) electrodeIdx] += 1;
+
+            const double count = static_cast<double> (surveySampleCount[(size_t) electrodeIdx]);
+            peakToPeakValues[(size_t) electrodeIdx] = count > 0.0 ? (float) (surveyAccumulation[(size_t) electrodeIdx] / count) : amplitude;
+        }
+        else
+        {
+            peakToPeakValues[(size_t) electrodeIdx] = amplitude;
         }
     }
 }
 
+void ActivityView::updateNoiseLevel (int electrodeIdx, float rms)
+{
+    if (rms < 0.0f)
+    {
+        noiseLevels[(size_t) electrodeIdx] = -1.0f;
+        noiseIntervals[(size_t) electrodeIdx] = 0;
+        return;
+    }
+
+    float* window = noiseWindows.data() + (size_t) electrodeIdx * NOISE_WINDOW_INTERVALS;
+    uint32_t& numIntervals = noiseIntervals[(size_t) electrodeIdx];
+
+    window[numIntervals % NOISE_WINDOW_INTERVALS] = rms;
+    numIntervals++;
+
+    const int count = (int) jmin (numIntervals, (uint32_t) NOISE_WINDOW_INTERVALS);
+
+    if (robustNoise)
+    {
+        // Median of the window, ignoring intervals dominated by bursts or artifacts
+        std::copy (window, window + count, noiseScratch.begin());
+        std::nth_element (noiseScratch.begin(), noiseScratch.begin() + count / 2, noiseScratch.begin() + count);
+        noiseLevels[(size_t) electrodeIdx] = noiseScratch[(size_t) count / 2];
+    }
+    else
+    {
+        // Pooled RMS of the window (the intervals have the same length)
+        float sumSquares = 0.0f;
+
+        for (int i = 0; i < count; ++i)
+            sumSquares += window[i] * window[i];
+
+        noiseLevels[(size_t) electrodeIdx] = std::sqrt (sumSquares / float (count));
+    }
+}
+
 void ActivityView::applyCommonAverageReferencing (AudioBuffer<float>& buffer, int blockIndex, int numSamples)
 {
     if (numAdcs == 0 || adcGroups.empty() || adcBuffers.empty() || blockIndex >= adcBuffers.size())
@@ -24,24 +24,55 @@
 #ifndef __ACTIVITYVIEW_H__
 #define __ACTIVITYVIEW_H__
 
-#include <DspLib.h>
 #include <VisualizerEditorHeaders.h>
+#include <atomic>
 #include <cstdint>
 #include <limits>
 #include <memory>
 #include <unordered_map>
 #include <vector>
 
+#include "BiquadBank.h"
+#include "RunningStatistics.h"
+#include "SpikeDetector.h"
+
 enum ActivityToView
 {
     APVIEW = 0,
-    LFPVIEW = 1
+    LFPVIEW = 1,
+    SPIKERATEVIEW = 2,
+    NOISEVIEW = 3
 };
 
 /**
 
 Helper class for viewing real-time activity across the probe.
 
+Acquisition threads add samples with addToBuffer(). By default (ENVELOPE)
+each call is referenced, filtered and reduced to a running minimum and
+maximum per channel on the calling thread, while the samples are still in
+cache, and only one summary per update interval is queued for analysis.
+Samples are ignored while the view is idle (see below), so that the
+acquisition threads only pay for the reduction while a view is shown.
+With FULL_RATE ingestion the samples themselves are queued, and filtered on
+the analysis thread instead.
+
+A background thread shared by all views computes the peak-to-peak amplitude
+of each channel every 100 ms, for views that were read in the last second
+(or are in survey mode), and publishes the results as a snapshot. The
+message thread only picks up the latest snapshot in getPeakToPeakValues().
+
+Views sampled at 10 kHz or more (the AP band) also count negative threshold
+crossings of the filtered signal, wherever it is filtered, and publish a
+smoothed spike rate per electrode (getSpikeRates()).
+
+The RMS noise of each filtered channel is found in the same pass as its
+range: the filter bank returns the sum and sum of squares of its output,
+which are merged into streaming (Welford) statistics for each update
+interval. getNoiseLevels() returns the median of the last 10 intervals
+per electrode, so that bursts of spikes or artifacts do not inflate it,
+or their pooled RMS if robust noise estimation is turned off.
+
 */
 
 class ActivityView
@@ -52,10 +83,43 @@ public:
                   std::vector<std::vector<int>> blocks = {},
                   int numAdcs = 0,
                   int totalElectrodes = -1);
-    ~ActivityView() {};
+    ~ActivityView();
+
+    /** How samples reach the analysis thread */
+    enum Ingestion
+    {
+        FULL_RATE, // all samples are queued, and filtered on the analysis thread
+        ENVELOPE // samples are filtered by the acquisition thread, and one range per channel is queued per update interval
+    };
+
+    /** Returns the name used by the NP ACTIVITY config message */
+    static String getIngestionName (Ingestion ingestion);
+
+    /** Parses a name returned by getIngestionName (case-insensitive) */
+    static bool parseIngestion (const String& name, Ingestion& ingestion);
+
+    /** Selects the ingestion mode (only while not acquiring) */
+    void setIngestion (Ingestion ingestion);
 
+    Ingestion getIngestion() const { return ingestion; }
+
+    /** Returns the most recent peak-to-peak amplitude of each electrode (-1 = no data);
+        valid until the next call (message thread) */
     const float* getPeakToPeakValues();
 
+    /** Returns the most recent threshold crossing rate of each electrode in Hz (-1 = no data,
+        e.g. without the band-pass filter or for the LFP band); valid until the next call (message thread) */
+    const float* getSpikeRates();
+
+    /** Returns the RMS noise of each electrode over the last 10 update intervals (-1 = no data,
+        e.g. without the band-pass filter); valid until the next call (message thread) */
+    const float* getNoiseLevels();
+
+    /** Selects the median (robust, the default) or the pooled RMS of the intervals in the noise window */
+    void setRobustNoiseEnabled (bool enabled);
+
+    const bool getRobustNoiseEnabled() const { return robustNoise; }
+
     void setBandpassFilterEnabled (bool enabled);
 
     const bool getBandpassFilterEnabled() const { return filterEnabled; }
@@ -79,13 +143,45 @@ public:
         std::vector<float> averages;
         std::vector<double> totals;
         std::vector<uint64_t> sampleCounts;
+        std::vector<float> noise; // RMS noise over the survey (0 = no data)
     };
 
     SurveyStatistics getSurveyStatistics();
 
 private:
+    class Analyzer;
+
+    /** Returns true if the results were read in the last second, or the view is in survey mode */
+    bool isActive() const;
+
+    /** Runs one analysis pass if the results are being used (analysis thread) */
+    void analyze();
+
+    /** Filters the buffered samples and updates peakToPeakValues (call with bufferMutex held) */
     void calculatePeakToPeakValues();
 
+    /** Copies peakToPeakValues, spikeRates and noiseLevels to the next snapshot (call with bufferMutex held) */
+    void publishPeakToPeakValues();
+
+    /** Returns the newest published snapshot (message thread) */
+    const std::vector<float>& getLatestSnapshot();
+
+    /** Reduces samples to the running range of each channel (ENVELOPE, acquisition thread) */
+    void addToEnvelope (const float* samples, int numSamples, int blockIndex);
+
+    /** Analyzes the queued ranges (ENVELOPE, call with bufferMutex held) */
+    void readEnvelopes();
+
+    /** Sets the peak-to-peak values, spike rates and noise levels of a block from channelMin,
+        channelMax, channelRate and channelNoise */
+    void updatePeakToPeakValues (int blockIndex);
+
+    /** Adds the RMS noise of one update interval to the window of an electrode (-1 clears it) */
+    void updateNoiseLevel (int electrodeIdx, float rms);
+
+    /** Allocates the sample FIFOs for FULL_RATE ingestion, or frees them */
+    void allocateSampleBuffers (bool fullRate);
+
     void applyCommonAverageReferencing (AudioBuffer<float>& buffer, int blockIndex, int numSamples);
 
     // Thread synchronization
@@ -94,14 +190,49 @@ private:
     int numChannels;
     int totalElectrodes;
     std::vector<float> peakToPeakValues;
+    std::vector<float> spikeRates;
+    std::vector<float> noiseLevels;
+
+    Ingestion ingestion = ENVELOPE;
 
-    // JUCE AudioBuffers for sample storage - one per block
+    // JUCE AudioBuffers for sample storage - one per block (FULL_RATE only)
     std::vector<AudioBuffer<float>> sampleBuffers;
     std::vector<AudioBuffer<float>> filteredBuffers;
 
-    // AbstractFifo - one per block
+    // AbstractFifo - one per block (FULL_RATE only)
     std::vector<std::unique_ptr<AbstractFifo>> abstractFifos;
 
+    /** State of one block in ENVELOPE mode */
+    struct Envelope
+    {
+        // Referenced and filtered copy of the samples being reduced
+        AudioBuffer<float> scratch;
+
+        // Range, sum and sum of squares of each channel in the current slice, and the range and
+        // filtered statistics of each channel in the current update interval
+        std::vector<float> sliceMin, sliceMax;
+        std::vector<float> sliceSum, sliceSumSquares;
+        std::vector<float> runningMin, runningMax;
+        std::vector<RunningStatistics> statistics;
+        int numSamples = 0;
+
+        // Threshold crossings of each channel in the current update interval, and the number of filtered samples
+        std::vector<uint32_t> crossings;
+        int numFilteredSamples = 0;
+
+        // True while samples are being ignored because the view is idle (acquisition thread)
+        bool idle = true;
+
+        // Completed intervals (minimum, maximum, spike rate and RMS noise of each channel), read by the analysis thread
+        std::vector<float> summaries;
+        std::unique_ptr<AbstractFifo> fifo;
+
+        /** Clears the range, crossings and statistics of the current update interval */
+        void clearInterval();
+    };
+
+    std::vector<Envelope> envelopes;
+
     int bufferIndex;
     bool needsUpdate;
 
@@ -110,20 +241,58 @@ private:
     std::vector<int> counters;
     int updateInterval;
 
-    // Bandpass filter state
-    bool filterEnabled;
-    OwnedArray<Dsp::Filter> filters;
+    // Bandpass filter state - one bank per block, used by the thread that filters the block
+    std::atomic<bool> filterEnabled;
+    std::vector<BiquadBank> filterBanks;
+    std::unique_ptr<std::atomic<bool>[]> filterResetPending;
+
+    // Threshold crossing detection - one detector per block, used by the thread that filters the block
+    bool detectsSpikes;
+    std::vector<SpikeDetector> spikeDetectors;
+
+    // Range, spike rate and RMS noise of each channel in the block being analyzed
+    std::vector<float> channelMin;
+    std::vector<float> channelMax;
+    std::vector<float> channelRate;
+    std::vector<float> channelNoise;
+    std::vector<uint32_t> channelCrossings;
+    std::vector<float> channelSum;
+    std::vector<float> channelSumSquares;
+
+    // RMS noise of the last update intervals of each electrode (ring buffers), and the number of intervals added
+    std::vector<float> noiseWindows;
+    std::vector<uint32_t> noiseIntervals;
+    std::vector<float> noiseScratch;
+    bool robustNoise = true;
+
+    // Sample rate implied by the update interval (10 updates per second)
+    float sampleRate;
 
     // Common average referencing state
-    bool carEnabled;
+    std::atomic<bool> carEnabled;
     int numAdcs;
     std::vector<std::vector<int>> adcGroups; // Maps global channel index to ADC group index
     std::vector<AudioBuffer<float>> adcBuffers; // One AudioBuffer per block, channels = ADC groups
 
+    // Published results: the analysis thread fills the back snapshot and swaps it with the
+    // middle one, flagging it as new; the reader swaps a new middle one with its front snapshot
+    static constexpr int newSnapshotFlag = 4;
+    std::vector<float> snapshots[3];
+    int backSnapshot = 0;
+    int frontSnapshot = 2;
+    std::atomic<int> middleSnapshot { 1 };
+
+    // Time the results were last read (Time::getMillisecondCounter)
+    std::atomic<uint32> lastReadTime { 0 };
+
+    std::unique_ptr<SharedResourcePointer<Analyzer>> analyzer;
+
     // Survey averaging state
-    bool surveyMode;
+    std::atomic<bool> surveyMode;
     std::vector<double> surveyAccumulation;
     std::vector<uint64_t> surveySampleCount;
+    std::vector<double> surveyNoiseAccumulation; // sum of interval variances
+    std::vector<uint64_t> surveyNoiseCount;
 
     // 300 Hz low-pass filter
     const float lowCut = 300.0f;
@@ -0,0 +1,506 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "BiquadBank.h"
+
+#include <DspLib.h>
+
+#include <limits>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NP_FILTER_SSE2 1
+#include <immintrin.h>
+
+#if defined(_MSC_VER) && ! defined(__clang__)
+#define NP_TARGET_AVX2
+#else
+#define NP_TARGET_AVX2 __attribute__ ((target ("avx2")))
+#endif
+#endif
+
+// Longest cascade supported by the vector kernels
+#define MAX_STAGES 4
+
+using Stage = BiquadBank::Stage;
+
+static void processChannelsScalar (float* const* channels,
+                                   int channelStart,
+                                   int channelEnd,
+                                   int numSamples,
+                                   const Stage* stages,
+                                   int numStages,
+                                   float* state,
+                                   int numChannels,
+                                   float* minValues,
+                                   float* maxValues,
+                                   float* sums,
+                                   float* sumSquares)
+{
+    for (int ch = channelStart; ch < channelEnd; ch++)
+    {
+        float s1[MAX_STAGES], s2[MAX_STAGES];
+
+        for (int s = 0; s < numStages; s++)
+        {
+            s1[s] = state[(size_t) (2 * s) * numChannels + ch];
+            s2[s] = state[(size_t) (2 * s + 1) * numChannels + ch];
+        }
+
+        float* samples = channels[ch];
+        float lo = std::numeric_limits<float>::infinity();
+        float hi = -lo;
+        float sum = 0.0f;
+        float sumSquare = 0.0f;
+
+        for (int t = 0; t < numSamples; t++)
+        {
+            float x = samples[t];
+
+            for (int s = 0; s < numStages; s++)
+            {
+                const float y = stages[s].b0 * x + s1[s];
+                s1[s] = stages[s].b1 * x - stages[s].a1 * y + s2[s];
+                s2[s] = stages[s].b2 * x - stages[s].a2 * y;
+                x = y;
+            }
+
+            samples[t] = x;
+            lo = jmin (lo, x);
+            hi = jmax (hi, x);
+            sum += x;
+            sumSquare += x * x;
+        }
+
+        for (int s = 0; s < numStages; s++)
+        {
+            state[(size_t) (2 * s) * numChannels + ch] = s1[s];
+            state[(size_t) (2 * s + 1) * numChannels + ch] = s2[s];
+        }
+
+        minValues[ch] = lo;
+        maxValues[ch] = hi;
+        sums[ch] = sum;
+        sumSquares[ch] = sumSquare;
+    }
+}
+
+#ifdef NP_FILTER_SSE2
+
+/** Output statistics of 4 channels */
+struct MomentsSse2
+{
+    __m128 lo, hi, sum, sumSquare;
+};
+
+/** Filters one sample of 4 channels through the cascade */
+template <int NumStages>
+static inline __m128 filterSse2 (__m128 x, const __m128* c, __m128* s1, __m128* s2, MomentsSse2& m)
+{
+    for (int s = 0; s < NumStages; s++)
+    {
+        const __m128 y = _mm_add_ps (_mm_mul_ps (c[5 * s], x), s1[s]);
+        s1[s] = _mm_add_ps (_mm_sub_ps (_mm_mul_ps (c[5 * s + 1], x), _mm_mul_ps (c[5 * s + 3], y)), s2[s]);
+        s2[s] = _mm_sub_ps (_mm_mul_ps (c[5 * s + 2], x), _mm_mul_ps (c[5 * s + 4], y));
+        x = y;
+    }
+
+    m.lo = _mm_min_ps (m.lo, x);
+    m.hi = _mm_max_ps (m.hi, x);
+    m.sum = _mm_add_ps (m.sum, x);
+    m.sumSquare = _mm_add_ps (m.sumSquare, _mm_mul_ps (x, x));
+
+    return x;
+}
+
+/** Filters 8 channels per group as two vectors of 4, transposing 4 x 4 tiles in registers;
+    returns the first channel that was not processed */
+template <int NumStages>
+static int processChannelsSse2 (float* const* channels,
+                                int numSamples,
+                                const Stage* stages,
+                                float* state,
+                                int numChannels,
+                                float* minValues,
+                                float* maxValues,
+                                float* sums,
+                                float* sumSquares)
+{
+    __m128 c[5 * NumStages];
+
+    for (int s = 0; s < NumStages; s++)
+    {
+        c[5 * s] = _mm_set1_ps (stages[s].b0);
+        c[5 * s + 1] = _mm_set1_ps (stages[s].b1);
+        c[5 * s + 2] = _mm_set1_ps (stages[s].b2);
+        c[5 * s + 3] = _mm_set1_ps (stages[s].a1);
+        c[5 * s + 4] = _mm_set1_ps (stages[s].a2);
+    }
+
+    const int sampleTileEnd = numSamples & ~3;
+
+    int ch = 0;
+
+    for (; ch + 8 <= numChannels; ch += 8)
+    {
+        __m128 s1[2][NumStages], s2[2][NumStages];
+        MomentsSse2 m[2];
+
+        for (int j = 0; j < 2; j++)
+        {
+            for (int s = 0; s < NumStages; s++)
+            {
+                s1[j][s] = _mm_loadu_ps (state + (size_t) (2 * s) * numChannels + ch + 4 * j);
+                s2[j][s] = _mm_loadu_ps (state + (size_t) (2 * s + 1) * numChannels + ch + 4 * j);
+            }
+
+            m[j].lo = _mm_set1_ps (std::numeric_limits<float>::infinity());
+            m[j].hi = _mm_set1_ps (-std::numeric_limits<float>::infinity());
+            m[j].sum = _mm_setzero_ps();
+            m[j].sumSquare = _mm_setzero_ps();
+        }
+
+        for (int t = 0; t < sampleTileEnd; t += 4)
+        {
+            for (int j = 0; j < 2; j++)
+            {
+                float* const* in = channels + ch + 4 * j;
+
+                __m128 r0 = _mm_loadu_ps (in[0] + t);
+                __m128 r1 = _mm_loadu_ps (in[1] + t);
+                __m128 r2 = _mm_loadu_ps (in[2] + t);
+                __m128 r3 = _mm_loadu_ps (in[3] + t);
+
+                _MM_TRANSPOSE4_PS (r0, r1, r2, r3);
+
+                r0 = filterSse2<NumStages> (r0, c, s1[j], s2[j], m[j]);
+                r1 = filterSse2<NumStages> (r1, c, s1[j], s2[j], m[j]);
+                r2 = filterSse2<NumStages> (r2, c, s1[j], s2[j], m[j]);
+                r3 = filterSse2<NumStages> (r3, c, s1[j], s2[j], m[j]);
+
+                _MM_TRANSPOSE4_PS (r0, r1, r2, r3);
+
+                _mm_storeu_ps (in[0] + t, r0);
+                _mm_storeu_ps (in[1] + t, r1);
+                _mm_storeu_ps (in[2] + t, r2);
+                _mm_storeu_ps (in[3] + t, r3);
+            }
+        }
+
+        for (int t = sampleTileEnd; t < numSamples; t++)
+        {
+            for (int j = 0; j < 2; j++)
+            {
+                float* const* in = channels + ch + 4 * j;
+                float x[4];
+
+                _mm_storeu_ps (x, filterSse2<NumStages> (_mm_setr_ps (in[0][t], in[1][t], in[2][t], in[3][t]), c, s1[j], s2[j], m[j]));
+
+                for (int k = 0; k < 4; k++)
+                    in[k][t] = x[k];
+            }
+        }
+
+        for (int j = 0; j < 2; j++)
+        {
+            for (int s = 0; s < NumStages; s++)
+            {
+                _mm_storeu_ps (state + (size_t) (2 * s) * numChannels + ch + 4 * j, s1[j][s]);
+                _mm_storeu_ps (state + (size_t) (2 * s + 1) * numChannels + ch + 4 * j, s2[j][s]);
+            }
+
+            _mm_storeu_ps (minValues + ch + 4 * j, m[j].lo);
+            _mm_storeu_ps (maxValues + ch + 4 * j, m[j].hi);
+            _mm_storeu_ps (sums + ch + 4 * j, m[j].sum);
+            _mm_storeu_ps (sumSquares + ch + 4 * j, m[j].sumSquare);
+        }
+    }
+
+    return ch;
+}
+
+/** Output statistics of 8 channels */
+struct MomentsAvx2
+{
+    __m256 lo, hi, sum, sumSquare;
+};
+
+/** Filters one sample of 8 channels through the cascade */
+template <int NumStages>
+NP_TARGET_AVX2 static inline __m256 filterAvx2 (__m256 x, const __m256* c, __m256* s1, __m256* s2, MomentsAvx2& m)
+{
+    for (int s = 0; s < NumStages; s++)
+    {
+        const __m256 y = _mm256_add_ps (_mm256_mul_ps (c[5 * s], x), s1[s]);
+        s1[s] = _mm256_add_ps (_mm256_sub_ps (_mm256_mul_ps (c[5 * s + 1], x), _mm256_mul_ps (c[5 * s + 3], y)), s2[s]);
+        s2[s] = _mm256_sub_ps (_mm256_mul_ps (c[5 * s + 2], x), _mm256_mul_ps (c[5 * s + 4], y));
+        x = y;
+    }
+
+    m.lo = _mm256_min_ps (m.lo, x);
+    m.hi = _mm256_max_ps (m.hi, x);
+    m.sum = _mm256_add_ps (m.sum, x);
+    m.sumSquare = _mm256_add_ps (m.sumSquare, _mm256_mul_ps (x, x));
+
+    return x;
+}
+
+/** Filters 16 channels per group as two vectors of 8, each built from two transposed 4 x 4 tiles;
+    returns the first channel that was not processed */
+template <int NumStages>
+NP_TARGET_AVX2 static int processChannelsAvx2 (float* const* channels,
+                                               int numSamples,
+                                               const Stage* stages,
+                                               float* state,
+                                               int numChannels,
+                                               float* minValues,
+                                               float* maxValues,
+                                               float* sums,
+                                               float* sumSquares)
+{
+    __m256 c[5 * NumStages];
+
+    for (int s = 0; s < NumStages; s++)
+    {
+        c[5 * s] = _mm256_set1_ps (stages[s].b0);
+        c[5 * s + 1] = _mm256_set1_ps (stages[s].b1);
+        c[5 * s + 2] = _mm256_set1_ps (stages[s].b2);
+        c[5 * s + 3] = _mm256_set1_ps (stages[s].a1);
+        c[5 * s + 4] = _mm256_set1_ps (stages[s].a2);
+    }
+
+    const int sampleTileEnd = numSamples & ~3;
+
+    int ch = 0;
+
+    for (; ch + 16 <= numChannels; ch += 16)
+    {
+        __m256 s1[2][NumStages], s2[2][NumStages];
+        MomentsAvx2 m[2];
+
+        for (int j = 0; j < 2; j++)
+        {
+            for (int s = 0; s < NumStages; s++)
+            {
+                s1[j][s] = _mm256_loadu_ps (state + (size_t) (2 * s) * numChannels + ch + 8 * j);
+                s2[j][s] = _mm256_loadu_ps (state + (size_t) (2 * s + 1) * numChannels + ch + 8 * j);
+            }
+
+            m[j].lo = _mm256_set1_ps (std::numeric_limits<float>::infinity());
+            m[j].hi = _mm256_set1_ps (-std::numeric_limits<float>::infinity());
+            m[j].sum = _mm256_setzero_ps();
+            m[j].sumSquare = _mm256_setzero_ps();
+        }
+
+        for (int t = 0; t < sampleTileEnd; t += 4)
+        {
+            for (int j = 0; j < 2; j++)
+            {
+                float* const* in = channels + ch + 8 * j;
+
+                __m128 a0 = _mm_loadu_ps (in[0] + t);
+                __m128 a1 = _mm_loadu_ps (in[1] + t);
+                __m128 a2 = _mm_loadu_ps (in[2] + t);
+                __m128 a3 = _mm_loadu_ps (in[3] + t);
+                __m128 b0 = _mm_loadu_ps (in[4] + t);
+                __m128 b1 = _mm_loadu_ps (in[5] + t);
+                __m128 b2 = _mm_loadu_ps (in[6] + t);
+                __m128 b3 = _mm_loadu_ps (in[7] + t);
+
+                _MM_TRANSPOSE4_PS (a0, a1, a2, a3);
+                _MM_TRANSPOSE4_PS (b0, b1, b2, b3);
+
+                __m256 r0 = _mm256_insertf128_ps (_mm256_castps128_ps256 (a0), b0, 1);
+                __m256 r1 = _mm256_insertf128_ps (_mm256_castps128_ps256 (a1), b1, 1);
+                __m256 r2 = _mm256_insertf128_ps (_mm256_castps128_ps256 (a2), b2, 1);
+                __m256 r3 = _mm256_insertf128_ps (_mm256_castps128_ps256 (a3), b3, 1);
+
+                r0 = filterAvx2<NumStages> (r0, c, s1[j], s2[j], m[j]);
+                r1 = filterAvx2<NumStages> (r1, c, s1[j], s2[j], m[j]);
+                r2 = filterAvx2<NumStages> (r2, c, s1[j], s2[j], m[j]);
+                r3 = filterAvx2<NumStages> (r3, c, s1[j], s2[j], m[j]);
+
+                a0 = _mm256_castps256_ps128 (r0);
+                a1 = _mm256_castps256_ps128 (r1);
+                a2 = _mm256_castps256_ps128 (r2);
+                a3 = _mm256_castps256_ps128 (r3);
+                b0 = _mm256_extractf128_ps (r0, 1);
+                b1 = _mm256_extractf128_ps (r1, 1);
+                b2 = _mm256_extractf128_ps (r2, 1);
+                b3 = _mm256_extractf128_ps (r3, 1);
+
+                _MM_TRANSPOSE4_PS (a0, a1, a2, a3);
+                _MM_TRANSPOSE4_PS (b0, b1, b2, b3);
+
+                _mm_storeu_ps (in[0] + t, a0);
+                _mm_storeu_ps (in[1] + t, a1);
+                _mm_storeu_ps (in[2] + t, a2);
+                _mm_storeu_ps (in[3] + t, a3);
+                _mm_storeu_ps (in[4] + t, b0);
+                _mm_storeu_ps (in[5] + t, b1);
+                _mm_storeu_ps (in[6] + t, b2);
+                _mm_storeu_ps (in[7] + t, b3);
+            }
+        }
+
+        for (int t = sampleTileEnd; t < numSamples; t++)
+        {
+            for (int j = 0; j < 2; j++)
+            {
+                float* const* in = channels + ch + 8 * j;
+                float x[8];
+
+                for (int k = 0; k < 8; k++)
+                    x[k] = in[k][t];
+
+                _mm256_storeu_ps (x, filterAvx2<NumStages> (_mm256_loadu_ps (x), c, s1[j], s2[j], m[j]));
+
+                for (int k = 0; k < 8; k++)
+                    in[k][t] = x[k];
+            }
+        }
+
+        for (int j = 0; j < 2; j++)
+        {
+            for (int s = 0; s < NumStages; s++)
+            {
+                _mm256_storeu_ps (state + (size_t) (2 * s) * numChannels + ch + 8 * j, s1[j][s]);
+                _mm256_storeu_ps (state + (size_t) (2 * s + 1) * numChannels + ch + 8 * j, s2[j][s]);
+            }
+
+            _mm256_storeu_ps (minValues + ch + 8 * j, m[j].lo);
+            _mm256_storeu_ps (maxValues + ch + 8 * j, m[j].hi);
+            _mm256_storeu_ps (sums + ch + 8 * j, m[j].sum);
+            _mm256_storeu_ps (sumSquares + ch + 8 * j, m[j].sumSquare);
+        }
+    }
+
+    return ch;
+}
+
+static bool cpuHasAvx2()
+{
+    static const bool hasAvx2 = SystemStats::hasAVX2();
+    return hasAvx2;
+}
+
+template <int NumStages>
+static int processChannelsVector (float* const* channels,
+                                  int numSamples,
+                                  const Stage* stages,
+                                  float* state,
+                                  int numChannels,
+                                  float* minValues,
+                                  float* maxValues,
+                                  float* sums,
+                                  float* sumSquares)
+{
+    if (cpuHasAvx2())
+        return processChannelsAvx2<NumStages> (channels, numSamples, stages, state, numChannels, minValues, maxValues, sums, sumSquares);
+
+    return processChannelsSse2<NumStages> (channels, numSamples, stages, state, numChannels, minValues, maxValues, sums, sumSquares);
+}
+
+#endif
+
+void BiquadBank::setBandPass (int numChannels_, double sampleRate, double centreFrequency, double bandwidth)
+{
+    Dsp::Butterworth::BandPass<2> design;
+    design.setup (2, sampleRate, centreFrequency, bandwidth);
+
+    std::vector<Stage> cascade;
+
+    for (int s = 0; s < design.getNumStages(); s++)
+    {
+        const Dsp::Biquad& biquad = design[s];
+        const double a0 = biquad.getA0();
+
+        cascade.push_back ({ float (biquad.getB0() / a0),
+                             float (biquad.getB1() / a0),
+                             float (biquad.getB2() / a0),
+                             float (biquad.getA1() / a0),
+                             float (biquad.getA2() / a0) });
+    }
+
+    setStages (numChannels_, cascade);
+}
+
+void BiquadBank::setStages (int numChannels_, const std::vector<Stage>& stages_)
+{
+    jassert (stages_.size() <= MAX_STAGES);
+
+    numChannels = numChannels_;
+    stages.assign (stages_.begin(), stages_.begin() + jmin ((int) stages_.size(), MAX_STAGES));
+    state.assign ((size_t) (2 * stages.size()) * numChannels, 0.0f);
+}
+
+void BiquadBank::reset()
+{
+    std::fill (state.begin(), state.end(), 0.0f);
+}
+
+void BiquadBank::process (float* const* channels, int numSamples, float* minValues, float* maxValues, float* sums, float* sumSquares)
+{
+    if (numSamples <= 0)
+    {
+        std::fill (minValues, minValues + numChannels, 0.0f);
+        std::fill (maxValues, maxValues + numChannels, 0.0f);
+        std::fill (sums, sums + numChannels, 0.0f);
+        std::fill (sumSquares, sumSquares + numChannels, 0.0f);
+        return;
+    }
+
+    const ScopedNoDenormals noDenormals;
+
+    int channelStart = 0;
+
+#ifdef NP_FILTER_SSE2
+    switch (stages.size())
+    {
+        case 1:
+            channelStart = processChannelsVector<1> (channels, numSamples, stages.data(), state.data(), numChannels, minValues, maxValues, sums, sumSquares);
+            break;
+        case 2:
+            channelStart = processChannelsVector<2> (channels, numSamples, stages.data(), state.data(), numChannels, minValues, maxValues, sums, sumSquares);
+            break;
+        case 3:
+            channelStart = processChannelsVector<3> (channels, numSamples, stages.data(), state.data(), numChannels, minValues, maxValues, sums, sumSquares);
+            break;
+        case 4:
+            channelStart = processChannelsVector<4> (channels, numSamples, stages.data(), state.data(), numChannels, minValues, maxValues, sums, sumSquares);
+            break;
+        default:
+            break;
+    }
+#endif
+
+    processChannelsScalar (channels, channelStart, numChannels, numSamples, stages.data(), (int) stages.size(), state.data(), numChannels, minValues, maxValues, sums, sumSquares);
+}
+
+const char* BiquadBank::getInstructionSetName()
+{
+#ifdef NP_FILTER_SSE2
+    return cpuHasAvx2() ? "AVX2" : "SSE2";
+#else
+    return "scalar";
+#endif
+}
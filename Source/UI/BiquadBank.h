@@ -0,0 +1,80 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __BIQUADBANK_H__
+#define __BIQUADBANK_H__
+
+#include <VisualizerEditorHeaders.h>
+#include <vector>
+
+/**
+
+	A bank of identical biquad cascades, one per channel.
+
+	The coefficients are shared by all channels and the filter state
+	is stored channel by channel, so that 8 (SSE2) or 16 (AVX2,
+	selected at runtime) channels are filtered together, 4 or 8 per
+	instruction. Samples are filtered in place, and the range, sum and
+	sum of squares of the output of each channel are found in the same
+	pass.
+
+	Each stage is a transposed direct form II biquad, in single
+	precision.
+
+*/
+class BiquadBank
+{
+public:
+    /** Coefficients of one biquad, normalised so that a0 = 1 */
+    struct Stage
+    {
+        float b0, b1, b2, a1, a2;
+    };
+
+    /** Uses a second order Butterworth band-pass (as Dsp::Butterworth::BandPass) for numChannels channels */
+    void setBandPass (int numChannels, double sampleRate, double centreFrequency, double bandwidth);
+
+    /** Uses the given cascade (up to 4 stages) for numChannels channels, and clears the state */
+    void setStages (int numChannels, const std::vector<Stage>& stages);
+
+    /** Clears the state of all channels */
+    void reset();
+
+    /** Filters numSamples samples of each channel in place, and writes the minimum, maximum,
+        sum and sum of squares of the output of each channel to the given arrays (numChannels each) */
+    void process (float* const* channels, int numSamples, float* minValues, float* maxValues, float* sums, float* sumSquares);
+
+    int getNumChannels() const { return numChannels; }
+
+    /** Returns "AVX2", "SSE2" or "scalar" */
+    static const char* getInstructionSetName();
+
+private:
+    int numChannels = 0;
+    std::vector<Stage> stages;
+
+    // Two values (s1, s2) per stage, each stored for all channels
+    std::vector<float> state;
+};
+
+#endif // __BIQUADBANK_H__
@@ -35,6 +35,15 @@
 
 #include "../Basestations/PxiBasestation.h"
 
+/** Describes a read batch size (in superframes) by its duration */
+static String getReadBatchText (int superFrames)
+{
+    if (superFrames <= 0)
+        return "DEFAULT";
+
+    return String (superFrames * PollingScheduler::Settings::superFrameDurationUs / 1000.0, 1) + " ms";
+}
+
 NeuropixInterface::NeuropixInterface (DataSource* p,
                                       NeuropixThread* t,
                                       NeuropixEditor* e,
@@ -276,25 +285,23 @@ NeuropixInterface::NeuropixInterface (DataSource* p,
         activityViewButton->setRadius (3.0f);
 
         activityViewButton->addListener (this);
-        activityViewButton->setTooltip ("View peak-to-peak amplitudes for each channel");
+        activityViewButton->setTooltip ("View peak-to-peak amplitudes or spike rates for each channel");
         addAndMakeVisible (activityViewButton.get());
 
         activityViewComboBox = std::make_unique<ComboBox> ("ActivityView Combo Box");
+        activityViewComboBox->setBounds (500, currentHeight, 72, 22);
+        activityViewComboBox->addListener (this);
+        activityViewComboBox->addItem ("AP", 1);
 
         if (probe->settings.availableLfpGains.size() > 0)
-        {
-            activityViewComboBox->setBounds (500, currentHeight, 65, 22);
-            activityViewComboBox->addListener (this);
-            activityViewComboBox->addItem ("AP", 1);
             activityViewComboBox->addItem ("LFP", 2);
-            activityViewComboBox->setSelectedId (1, dontSendNotification);
-            addAndMakeVisible (activityViewComboBox.get());
-            activityViewButton->setBounds (580, currentHeight + 2, 45, 18);
-        }
-        else
-        {
-            activityViewButton->setBounds (500, currentHeight + 2, 45, 18);
-        }
+
+        activityViewComboBox->addItem ("SPIKES", 3);
+        activityViewComboBox->addItem ("NOISE", 4);
+        activityViewComboBox->setSelectedId (1, dontSendNotification);
+        activityViewComboBox->setTooltip ("Peak-to-peak amplitude of the AP or LFP band, or rate of threshold crossings or RMS noise in the filtered AP band");
+        addAndMakeVisible (activityViewComboBox.get());
+        activityViewButton->setBounds (582, currentHeight + 2, 45, 18);
 
         activityViewLabel = std::make_unique<Label> ("PROBE SIGNAL", "PROBE SIGNAL");
         activityViewLabel->setFont (FontOptions ("Inter", "Regular", 13.0f));
@@ -411,6 +418,23 @@ NeuropixInterface::NeuropixInterface (DataSource* p,
         bistLabel->setBounds (700, 473, 200, 20);
         addAndMakeVisible (bistLabel.get());
 
+        // READ BATCH
+        readBatchComboBox = std::make_unique<ComboBox> ("ReadBatchComboBox");
+        readBatchComboBox->setBounds (1000, 500, 100, 22);
+        readBatchComboBox->addListener (this);
+
+        for (int i = 0; i < readBatchOptions.size(); i++)
+            readBatchComboBox->addItem (getReadBatchText (readBatchOptions[i]), i + 1);
+
+        readBatchComboBox->setSelectedId (1, dontSendNotification);
+        readBatchComboBox->setTooltip ("Longest wait between reads from this probe. Shorter batches reduce latency but use more CPU.");
+        addAndMakeVisible (readBatchComboBox.get());
+
+        readBatchLabel = std::make_unique<Label> ("READ BATCH", "Read batch:");
+        readBatchLabel->setFont (FontOptions ("Inter", "Regular", 15.0f));
+        readBatchLabel->setBounds (1000, 473, 200, 20);
+        addAndMakeVisible (readBatchLabel.get());
+
         // COPY / PASTE / UPLOAD
         copyButton = std::make_unique<UtilityButton> ("COPY");
         copyButton->setRadius (3.0f);
@@ -841,18 +865,14 @@ void NeuropixInterface::comboBoxChanged (ComboBox* comboBox)
         {
             updateProbeSettingsInBackground();
         }
+        else if (comboBox == readBatchComboBox.get())
+        {
+            if (comboBox->getSelectedId() > 0)
+                probe->pollingSettings.readBatchSuperFrames = readBatchOptions[comboBox->getSelectedId() - 1];
+        }
         else if (comboBox == activityViewComboBox.get())
         {
-            if (comboBox->getSelectedId() == 1)
-            {
-                probeBrowser->activityToView = ActivityToView::APVIEW;
-                ColourScheme::setColourScheme (ColourSchemeId::PLASMA);
-            }
-            else
-            {
-                probeBrowser->activityToView = ActivityToView::LFPVIEW;
-                ColourScheme::setColourScheme (ColourSchemeId::VIRIDIS);
-            }
+            updateActivityToView();
         }
         else if (comboBox == activityViewAmplitudeComboBox.get())
         {
@@ -889,17 +909,7 @@ void NeuropixInterface::comboBoxChanged (ComboBox* comboBox)
     {
         if (comboBox == activityViewComboBox.get())
         {
-            if (comboBox->getSelectedId() == 1)
-            {
-                probeBrowser->activityToView = ActivityToView::APVIEW;
-                ColourScheme::setColourScheme (ColourSchemeId::PLASMA);
-            }
-            else
-            {
-                probeBrowser->activityToView = ActivityToView::LFPVIEW;
-                ColourScheme::setColourScheme (ColourSchemeId::VIRIDIS);
-            }
-
+            updateActivityToView();
             repaint();
         }
         else if (comboBox == activityViewAmplitudeComboBox.get())
@@ -1211,6 +1221,20 @@ void NeuropixInterface::setApFilterState (bool state)
     filterComboBox->setSelectedId (int (! state) + 1, true);
 }
 
+void NeuropixInterface::setReadBatchSize (int superFrames)
+{
+    superFrames = jlimit (0, PollingScheduler::Settings::maxReadBatchSuperFrames, superFrames);
+
+    probe->pollingSettings.readBatchSuperFrames = superFrames;
+
+    const int optionIndex = readBatchOptions.indexOf (superFrames);
+
+    if (optionIndex > -1)
+        readBatchComboBox->setSelectedId (optionIndex + 1, dontSendNotification);
+    else
+        readBatchComboBox->setText (getReadBatchText (superFrames), dontSendNotification);
+}
+
 void NeuropixInterface::setEmissionSite (String wavelength, int site)
 {
     LOGD ("Emission site selection.");
@@ -1356,6 +1380,9 @@ void NeuropixInterface::startAcquisition()
     if (referenceComboBox != nullptr)
         referenceComboBox->setEnabled (enabledState);
 
+    if (readBatchComboBox != nullptr)
+        readBatchComboBox->setEnabled (enabledState);
+
     if (bistComboBox != nullptr)
         bistComboBox->setEnabled (enabledState);
 
@@ -1425,6 +1452,9 @@ void NeuropixInterface::stopAcquisition()
     if (referenceComboBox != nullptr)
         referenceComboBox->setEnabled (enabledState);
 
+    if (readBatchComboBox != nullptr)
+        readBatchComboBox->setEnabled (enabledState);
+
     if (bistComboBox != nullptr)
         bistComboBox->setEnabled (enabledState);
 
@@ -1477,6 +1507,29 @@ void NeuropixInterface::paint (Graphics& g)
     }
 }
 
+void NeuropixInterface::updateActivityToView()
+{
+    switch (activityViewComboBox->getSelectedId())
+    {
+        case 2:
+            probeBrowser->activityToView = ActivityToView::LFPVIEW;
+            ColourScheme::setColourScheme (ColourSchemeId::VIRIDIS);
+            break;
+        case 3:
+            probeBrowser->activityToView = ActivityToView::SPIKERATEVIEW;
+            ColourScheme::setColourScheme (ColourSchemeId::INFERNO);
+            break;
+        case 4:
+            probeBrowser->activityToView = ActivityToView::NOISEVIEW;
+            ColourScheme::setColourScheme (ColourSchemeId::MAGMA);
+            break;
+        default:
+            probeBrowser->activityToView = ActivityToView::APVIEW;
+            ColourScheme::setColourScheme (ColourSchemeId::PLASMA);
+            break;
+    }
+}
+
 void NeuropixInterface::drawLegend (Graphics& g)
 {
     if (thread->isRefreshing)
@@ -1583,11 +1636,32 @@ void NeuropixInterface::drawLegend (Graphics& g)
             break;
 
         case ACTIVITY_VIEW:
-            g.drawMultiLineText ("AMPLITUDE", xOffset, yOffset, 200);
+            if (probeBrowser->activityToView == ActivityToView::SPIKERATEVIEW)
+            {
+                g.drawMultiLineText ("SPIKE RATE", xOffset, yOffset, 200);
 
-            for (int i = 0; i < 6; i++)
+                for (int i = 0; i < 6; i++)
+                {
+                    g.drawMultiLineText (String (ProbeBrowser::maxSpikeRate / 5.0f * float (i)) + " Hz", xOffset + 30, yOffset + 22 + 20 * i, 200);
+                }
+            }
+            else if (probeBrowser->activityToView == ActivityToView::NOISEVIEW)
             {
-                g.drawMultiLineText (String (float (currentMaxPeakToPeak) / 5.0f * float (i)) + " uV", xOffset + 30, yOffset + 22 + 20 * i, 200);
+                g.drawMultiLineText ("NOISE (RMS)", xOffset, yOffset, 200);
+
+                for (int i = 0; i < 6; i++)
+                {
+                    g.drawMultiLineText (String (ProbeBrowser::maxNoiseLevel / 5.0f * float (i)) + " uV", xOffset + 30, yOffset + 22 + 20 * i, 200);
+                }
+            }
+            else
+            {
+                g.drawMultiLineText ("AMPLITUDE", xOffset, yOffset, 200);
+
+                for (int i = 0; i < 6; i++)
+                {
+                    g.drawMultiLineText (String (float (currentMaxPeakToPeak) / 5.0f * float (i)) + " uV", xOffset + 30, yOffset + 22 + 20 * i, 200);
+                }
             }
 
             for (int i = 0; i < 6; i++)
@@ -1913,6 +1987,8 @@ void NeuropixInterface::saveParameters (XmlElement* xml)
                 xmlNode->setAttribute ("filterCutIndex", filterComboBox->getSelectedId());
             }
 
+            xmlNode->setAttribute ("readBatchSuperFrames", probe->pollingSettings.readBatchSuperFrames);
+
             XmlElement* channelNode = xmlNode->createNewChildElement ("CHANNELS");
             XmlElement* xposNode = xmlNode->createNewChildElement ("ELECTRODE_XPOS");
             XmlElement* yposNode = xmlNode->createNewChildElement ("ELECTRODE_YPOS");
@@ -2244,6 +2320,8 @@ void NeuropixInterface::loadParameters (XmlElement* xml)
 
                 settings.apFilterState = matchingNode->getIntAttribute ("filterCutIndex", 1) == 1;
 
+                setReadBatchSize (matchingNode->getIntAttribute ("readBatchSuperFrames", 0));
+
                 forEachXmlChildElement (*matchingNode, imroNode)
                 {
                     if (imroNode->hasTagName ("IMRO_FILES"))
@@ -118,6 +118,7 @@ public:
     void setLfpGain (int index);
     void setReference (int index);
     void setApFilterState (bool state);
+    void setReadBatchSize (int superFrames);
     void setEmissionSite (String wavelength, int site);
     void selectElectrodes (Array<int> electrodes);
 
@@ -147,6 +148,7 @@ private:
     std::unique_ptr<ComboBox> activityViewAmplitudeComboBox;
     std::unique_ptr<ComboBox> redEmissionSiteComboBox;
     std::unique_ptr<ComboBox> blueEmissionSiteComboBox;
+    std::unique_ptr<ComboBox> readBatchComboBox;
 
     // Combo box - basestation settings
     std::unique_ptr<ComboBox> bistComboBox;
@@ -171,6 +173,7 @@ private:
     std::unique_ptr<Label> activityViewLabel;
     std::unique_ptr<Label> redEmissionSiteLabel;
     std::unique_ptr<Label> blueEmissionSiteLabel;
+    std::unique_ptr<Label> readBatchLabel;
 
     std::unique_ptr<Label> bistLabel;
     std::unique_ptr<Label> bscFirmwareLabel;
@@ -218,6 +221,9 @@ private:
     void drawLegend (Graphics& g);
     void drawAnnotations (Graphics& g);
 
+    /** Shows the activity selected in activityViewComboBox (AP, LFP or spike rate) */
+    void updateActivityToView();
+
     /* Thread-safe method to show bad site warning */
     void showDamagedShankWarning();
 
@@ -230,6 +236,9 @@ private:
     Array<bool> imroLoadedFromFolder;
 
     Array<float> amplitudeOptions { 250.0f, 500.0f, 750.0f, 1000.0f };
+
+    /** Read batch sizes in superframes (0 = probe default) */
+    Array<int> readBatchOptions { 0, 1, 2, 4, 8, 16, 32, 64, 128, 256, 512, 1024 };
     float currentMaxPeakToPeak { 500.0f };
 };
 
@@ -1276,6 +1276,14 @@ void ProbeBrowser::calculateElectrodeColours()
 
     const int electrodeCount = parent->electrodeMetadata.size();
 
+    float overviewRange = overviewMaxPeakToPeakAmplitude;
+    float range = parent->getMaxPeakToPeakValue();
+
+    if (activityToView == ActivityToView::SPIKERATEVIEW)
+        overviewRange = range = maxSpikeRate;
+    else if (activityToView == ActivityToView::NOISEVIEW)
+        overviewRange = range = maxNoiseLevel;
+
     for (int i = 0; i < electrodeCount; i++)
     {
         const int electrodeIdx = parent->electrodeMetadata[i].global_index;
@@ -1288,8 +1296,8 @@ void ProbeBrowser::calculateElectrodeColours()
         }
         else
         {
-            overviewElectrodeColours.setUnchecked (i, ColourScheme::getColourForNormalizedValue (value / overviewMaxPeakToPeakAmplitude));
-            parent->electrodeMetadata.getReference (i).colour = ColourScheme::getColourForNormalizedValue (value / parent->getMaxPeakToPeakValue());
+            overviewElectrodeColours.setUnchecked (i, ColourScheme::getColourForNormalizedValue (value / overviewRange));
+            parent->electrodeMetadata.getReference (i).colour = ColourScheme::getColourForNormalizedValue (value / range);
         }
     }
 
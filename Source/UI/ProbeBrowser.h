@@ -86,6 +86,12 @@ public:
     ActivityToView activityToView;
     float maxPeakToPeakAmplitude;
 
+    /** Spike rate shown with the brightest colour (Hz) */
+    static constexpr float maxSpikeRate = 50.0f;
+
+    /** RMS noise shown with the brightest colour (uV) */
+    static constexpr float maxNoiseLevel = 20.0f;
+
 private:
     std::map<Bank, Colour> disconnectedColours;
 
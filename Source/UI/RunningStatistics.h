@@ -0,0 +1,95 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __RUNNINGSTATISTICS_H__
+#define __RUNNINGSTATISTICS_H__
+
+#include <cmath>
+
+/**
+
+	Streaming mean and variance of a signal (Welford, 1962).
+
+	Samples are added in blocks, given the sum and sum of squares of
+	each block, and merged with the pairwise update of Chan et al.
+	(1979), which stays accurate when the mean is large compared to
+	the spread. Block sums only need to cover a few thousand samples.
+
+*/
+class RunningStatistics
+{
+public:
+    /** Adds numSamples samples with the given sum and sum of squares */
+    void add (int numSamples, double sum, double sumSquares)
+    {
+        if (numSamples <= 0)
+            return;
+
+        const double n = double (numSamples);
+        const double blockMean = sum / n;
+
+        merge (n, blockMean, std::fmax (0.0, sumSquares - sum * blockMean));
+    }
+
+    /** Adds all samples added to other */
+    void add (const RunningStatistics& other)
+    {
+        merge (other.count, other.mean, other.m2);
+    }
+
+    void reset()
+    {
+        count = 0.0;
+        mean = 0.0;
+        m2 = 0.0;
+    }
+
+    double getCount() const { return count; }
+
+    double getMean() const { return mean; }
+
+    double getVariance() const { return count > 0.0 ? m2 / count : 0.0; }
+
+    /** Returns the RMS deviation from the mean (the noise level of a filtered signal) */
+    double getStandardDeviation() const { return std::sqrt (getVariance()); }
+
+private:
+    void merge (double n, double blockMean, double blockM2)
+    {
+        if (n <= 0.0)
+            return;
+
+        const double total = count + n;
+        const double delta = blockMean - mean;
+
+        mean += delta * n / total;
+        m2 += blockM2 + delta * delta * count * n / total;
+        count = total;
+    }
+
+    double count = 0.0;
+    double mean = 0.0;
+    double m2 = 0.0; // sum of squared deviations from the mean
+};
+
+#endif // __RUNNINGSTATISTICS_H__
@@ -0,0 +1,193 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#include "SpikeDetector.h"
+
+#include <cmath>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+#define NP_DETECT_SSE2 1
+#include <immintrin.h>
+#endif
+
+// Threshold, in multiples of the noise standard deviation
+#define THRESHOLD_MULTIPLE 5.0f
+
+// Ratio of the standard deviation to median (|x|) for Gaussian noise
+#define MAD_SCALE (1.0f / 0.6745f)
+
+// Ratio of median (|x|) to mean (|x|) for Gaussian noise, used for the initial estimate
+#define MEAN_TO_MEDIAN 0.8453f
+
+// Time constant of the noise estimate
+#define ADAPTATION_SECONDS 1.0f
+
+// Crossings closer than this to the previous one are ignored
+#define REFRACTORY_SECONDS 0.001f
+
+/** Counts samples above level, crossings below threshold and the sum of absolute values in one channel;
+    lastCrossing is the index of the last counted crossing, relative to the first sample */
+static void scanChannel (const float* x,
+                         int numSamples,
+                         float previous,
+                         float level,
+                         float threshold,
+                         int refractorySamples,
+                         int& lastCrossing,
+                         int& numAbove,
+                         int& numCrossings,
+                         float& sumAbs)
+{
+    int t = 0;
+
+    numAbove = 0;
+    numCrossings = 0;
+    sumAbs = 0.0f;
+
+    auto addCrossing = [&] (int index)
+    {
+        if (index - lastCrossing >= refractorySamples)
+        {
+            numCrossings++;
+            lastCrossing = index;
+        }
+    };
+
+#ifdef NP_DETECT_SSE2
+    if (numSamples >= 4)
+    {
+        const __m128 signBit = _mm_set1_ps (-0.0f);
+        const __m128 vLevel = _mm_set1_ps (level);
+        const __m128 vThreshold = _mm_set1_ps (threshold);
+
+        __m128i above = _mm_setzero_si128();
+        __m128 sum = _mm_setzero_ps();
+
+        for (; t + 4 <= numSamples; t += 4)
+        {
+            const __m128 v = _mm_loadu_ps (x + t);
+            const __m128 p = t == 0 ? _mm_setr_ps (previous, x[0], x[1], x[2]) : _mm_loadu_ps (x + t - 1);
+            const __m128 a = _mm_andnot_ps (signBit, v);
+
+            // Comparison masks are -1 where true
+            above = _mm_sub_epi32 (above, _mm_castps_si128 (_mm_cmpgt_ps (a, vLevel)));
+            sum = _mm_add_ps (sum, a);
+
+            // Crossings are rare, so the refractory check is done one by one
+            int crossingMask = _mm_movemask_ps (_mm_and_ps (_mm_cmplt_ps (v, vThreshold), _mm_cmpge_ps (p, vThreshold)));
+
+            for (int k = 0; crossingMask != 0; k++, crossingMask >>= 1)
+            {
+                if (crossingMask & 1)
+                    addCrossing (t + k);
+            }
+        }
+
+        int32_t aboveLanes[4];
+        float sumLanes[4];
+
+        _mm_storeu_si128 ((__m128i*) aboveLanes, above);
+        _mm_storeu_ps (sumLanes, sum);
+
+        for (int k = 0; k < 4; k++)
+        {
+            numAbove += aboveLanes[k];
+            sumAbs += sumLanes[k];
+        }
+
+        previous = x[t - 1];
+    }
+#endif
+
+    for (; t < numSamples; t++)
+    {
+        const float a = std::abs (x[t]);
+
+        numAbove += a > level ? 1 : 0;
+        sumAbs += a;
+
+        if (x[t] < threshold && previous >= threshold)
+            addCrossing (t);
+
+        previous = x[t];
+    }
+}
+
+void SpikeDetector::prepare (int numChannels_, float sampleRate_)
+{
+    numChannels = numChannels_;
+    sampleRate = sampleRate_;
+
+    refractorySamples = jmax (1, int (sampleRate * REFRACTORY_SECONDS));
+
+    medianAbs.assign ((size_t) numChannels, 0.0f);
+    lastSample.assign ((size_t) numChannels, 0.0f);
+    samplesSinceCrossing.assign ((size_t) numChannels, refractorySamples);
+}
+
+void SpikeDetector::reset()
+{
+    std::fill (medianAbs.begin(), medianAbs.end(), 0.0f);
+    std::fill (lastSample.begin(), lastSample.end(), 0.0f);
+    std::fill (samplesSinceCrossing.begin(), samplesSinceCrossing.end(), refractorySamples);
+}
+
+float SpikeDetector::getThreshold (int channel) const
+{
+    return -THRESHOLD_MULTIPLE * MAD_SCALE * medianAbs[(size_t) channel];
+}
+
+void SpikeDetector::process (const float* const* channels, int numSamples, uint32_t* crossings)
+{
+    if (numSamples <= 0)
+        return;
+
+    // Fraction of the way the estimate moves towards balance in this call
+    const float gain = jmin (1.0f, float (numSamples) / (sampleRate * ADAPTATION_SECONDS));
+
+    for (int ch = 0; ch < numChannels; ch++)
+    {
+        const float* x = channels[ch];
+        float& level = medianAbs[(size_t) ch];
+
+        int lastCrossing = -samplesSinceCrossing[(size_t) ch];
+        int numAbove, numCrossings;
+        float sumAbs;
+
+        scanChannel (x, numSamples, lastSample[(size_t) ch], level, getThreshold (ch), refractorySamples, lastCrossing, numAbove, numCrossings, sumAbs);
+
+        lastSample[(size_t) ch] = x[numSamples - 1];
+        samplesSinceCrossing[(size_t) ch] = jmin (numSamples - lastCrossing, refractorySamples);
+
+        if (level > 0.0f)
+        {
+            // Moves up when more than half of the samples are above the estimate, down otherwise
+            crossings[ch] += (uint32_t) numCrossings;
+            level *= std::exp (gain * (2.0f * float (numAbove) / float (numSamples) - 1.0f));
+        }
+        else
+        {
+            level = MEAN_TO_MEDIAN * sumAbs / float (numSamples);
+        }
+    }
+}
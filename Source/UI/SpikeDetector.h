@@ -0,0 +1,74 @@
+/*
+    ------------------------------------------------------------------
+
+    This file is part of the Open Ephys GUI
+    Copyright (C) 2024 Open Ephys
+
+    ------------------------------------------------------------------
+
+    This program is free software: you can redistribute it and/or modify
+    it under the terms of the GNU General Public License as published by
+    the Free Software Foundation, either version 3 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU General Public License for more details.
+
+    You should have received a copy of the GNU General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+
+*/
+
+#ifndef __SPIKEDETECTOR_H__
+#define __SPIKEDETECTOR_H__
+
+#include <VisualizerEditorHeaders.h>
+#include <cstdint>
+#include <vector>
+
+/**
+
+	Counts negative threshold crossings on band-pass filtered channels.
+
+	The threshold of each channel is a multiple of its noise level,
+	estimated as median (|x|) / 0.6745 (Quiroga et al., 2004), so
+	that spikes barely affect it. The median is tracked incrementally:
+	after each call it moves up or down by an amount proportional to
+	the fraction of samples above or below it. It starts from the
+	mean absolute value, scaled for Gaussian noise. Crossings within
+	1 ms of the previous one are not counted.
+
+	Each channel is scanned once per call, 4 samples per instruction
+	where SSE2 is available.
+
+*/
+class SpikeDetector
+{
+public:
+    /** Clears the noise estimates of numChannels channels sampled at sampleRate */
+    void prepare (int numChannels, float sampleRate);
+
+    /** Clears the noise estimates and the last sample of each channel */
+    void reset();
+
+    /** Adds the threshold crossings of each channel in numSamples samples to crossings,
+        then updates the noise estimates */
+    void process (const float* const* channels, int numSamples, uint32_t* crossings);
+
+    /** Returns the current threshold of a channel (negative, 0 = not estimated yet) */
+    float getThreshold (int channel) const;
+
+private:
+    int numChannels = 0;
+    float sampleRate = 30000.0f;
+
+    int refractorySamples = 30;
+
+    std::vector<float> medianAbs;
+    std::vector<float> lastSample;
+    std::vector<int> samplesSinceCrossing;
+};
+
+#endif // __SPIKEDETECTOR_H__
@@ -1581,6 +1581,9 @@ void SurveyInterface::saveSurveyResultsToJson (const Array<SurveyTarget>& target
             const float apPeak = index < apStats.averages.size() ? apStats.averages[index] : 0.0f;
             electrodeObj->setProperty (Identifier ("peak_to_peak"), apPeak);
 
+            const float apNoise = index < apStats.noise.size() ? apStats.noise[index] : 0.0f;
+            electrodeObj->setProperty (Identifier ("noise_rms"), apNoise);
+
             electrodesVar.add (electrodeObj.get());
         }
 